@@ -0,0 +1,317 @@
+#include "anytime.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "memo.h"
+#include "memory.h"
+
+// grid points per variable of the initial coarse sampling
+#define ANYTIME_COARSE 5
+
+struct anytime {
+    int active[PLL_NUM_VARIABLES];
+    double lower[PLL_NUM_VARIABLES];
+    double upper[PLL_NUM_VARIABLES];
+    double timebudget;
+    size_t evaluationbudget;
+    double tolerance;
+    struct memo* memo;
+    double start[PLL_NUM_VARIABLES];
+    int hasstart;
+    atomic_int cancel;
+};
+
+// state of one run
+struct search {
+    struct anytime* anytime;
+    struct pll_state* state;
+    evaluator eval;
+    struct timespec start;
+    size_t evaluations;
+    int exhausted; // budget expired or cancelled
+    int cancelled;
+    double best[PLL_NUM_VARIABLES]; // normalized coordinates
+    double bestscore;
+    int hasbest;
+};
+
+struct anytime* anytime_create(void)
+{
+    struct anytime* anytime = memory_allocate_zeroed(1, sizeof(*anytime));
+    anytime->timebudget = 0.2;
+    anytime->evaluationbudget = 0;
+    anytime->tolerance = 1e-6;
+    atomic_init(&anytime->cancel, 0);
+    return anytime;
+}
+
+void anytime_destroy(struct anytime* anytime)
+{
+    memory_free(anytime);
+}
+
+void anytime_set_range(struct anytime* anytime, enum pll_variable variable, double lower, double upper)
+{
+    anytime->active[variable] = 1;
+    anytime->lower[variable] = lower;
+    anytime->upper[variable] = upper;
+}
+
+void anytime_set_time_budget(struct anytime* anytime, double seconds)
+{
+    anytime->timebudget = seconds;
+}
+
+void anytime_set_evaluation_budget(struct anytime* anytime, size_t evaluations)
+{
+    anytime->evaluationbudget = evaluations;
+}
+
+void anytime_set_tolerance(struct anytime* anytime, double tolerance)
+{
+    anytime->tolerance = tolerance;
+}
+
+void anytime_set_memo(struct anytime* anytime, struct memo* memo)
+{
+    anytime->memo = memo;
+}
+
+void anytime_set_start(struct anytime* anytime, const double* variables)
+{
+    anytime->hasstart = variables != NULL;
+    for(size_t i = 0; variables && i < PLL_NUM_VARIABLES; ++i)
+    {
+        anytime->start[i] = variables[i];
+    }
+}
+
+void anytime_cancel(struct anytime* anytime)
+{
+    atomic_store(&anytime->cancel, 1);
+}
+
+static double _elapsed(const struct search* search)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - search->start.tv_sec) + 1e-9 * (now.tv_nsec - search->start.tv_nsec);
+}
+
+// normalized coordinate u in [0, 1] -> variable value (logarithmic for positive ranges)
+static double _value(const struct anytime* anytime, size_t variable, double u)
+{
+    double lower = anytime->lower[variable];
+    double upper = anytime->upper[variable];
+    if(lower > 0 && upper > 0)
+    {
+        return lower * pow(upper / lower, u);
+    }
+    return lower + u * (upper - lower);
+}
+
+// inverse of _value, clamped to the range
+static double _normalized(const struct anytime* anytime, size_t variable, double value)
+{
+    double lower = anytime->lower[variable];
+    double upper = anytime->upper[variable];
+    double u;
+    if(lower > 0 && upper > 0)
+    {
+        u = value > 0 ? log(value / lower) / log(upper / lower) : 0.0;
+    }
+    else
+    {
+        u = (value - lower) / (upper - lower);
+    }
+    return isfinite(u) ? fmin(1.0, fmax(0.0, u)) : 0.0;
+}
+
+static int _check_budget(struct search* search)
+{
+    const struct anytime* anytime = search->anytime;
+    if(atomic_load(&search->anytime->cancel))
+    {
+        search->cancelled = 1;
+        search->exhausted = 1;
+    }
+    else if(anytime->evaluationbudget > 0 && search->evaluations >= anytime->evaluationbudget)
+    {
+        search->exhausted = 1;
+    }
+    else if(anytime->timebudget > 0 && _elapsed(search) >= anytime->timebudget)
+    {
+        search->exhausted = 1;
+    }
+    return !search->exhausted;
+}
+
+// evaluates the point u (normalized coordinates), returns 1 if it is the new best point
+static int _probe(struct search* search, const double* u)
+{
+    if(!_check_budget(search))
+    {
+        return 0;
+    }
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(search->anytime->active[i])
+        {
+            pll_set_variable(search->state, i, _value(search->anytime, i, u[i]));
+        }
+    }
+    ++search->evaluations;
+    double score;
+    if(search->anytime->memo)
+    {
+        struct pll_results results;
+        if(!memo_calculate(search->anytime->memo, search->state, &results))
+        {
+            return 0;
+        }
+        score = pll_get_results_score(&results, search->eval);
+    }
+    else
+    {
+        if(!pll_calculate(search->state))
+        {
+            return 0;
+        }
+        score = pll_get_score(search->state, search->eval);
+    }
+    // an infeasible (infinite) or NaN score is never the best one, a NaN could not be improved on
+    if(isfinite(score) && (!search->hasbest || score < search->bestscore))
+    {
+        search->bestscore = score;
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            search->best[i] = u[i];
+        }
+        search->hasbest = 1;
+        return 1;
+    }
+    return 0;
+}
+
+// coarse grid over all active variables (the first variable varies fastest)
+static void _coarse(struct search* search)
+{
+    size_t total = 1;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(search->anytime->active[i])
+        {
+            total *= ANYTIME_COARSE;
+        }
+    }
+    for(size_t n = 0; n < total && !search->exhausted; ++n)
+    {
+        double u[PLL_NUM_VARIABLES] = { 0 };
+        size_t rest = n;
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            if(search->anytime->active[i])
+            {
+                u[i] = (double)(rest % ANYTIME_COARSE) / (ANYTIME_COARSE - 1);
+                rest /= ANYTIME_COARSE;
+            }
+        }
+        _probe(search, u);
+    }
+}
+
+int anytime_run(struct anytime* anytime, struct pll_state* state, evaluator eval, struct anytime_result* result)
+{
+    struct search search;
+    search.anytime = anytime;
+    search.state = state;
+    search.eval = eval;
+    clock_gettime(CLOCK_MONOTONIC, &search.start);
+    search.evaluations = 0;
+    search.exhausted = 0;
+    search.cancelled = 0;
+    search.bestscore = DBL_MAX;
+    search.hasbest = 0;
+    atomic_store(&anytime->cancel, 0);
+
+    if(anytime->hasstart)
+    {
+        // warm start: the compass search begins at the given design, the coarse grid is only needed if it is not valid
+        // or not feasible in this configuration
+        double u[PLL_NUM_VARIABLES] = { 0 };
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            if(anytime->active[i])
+            {
+                u[i] = _normalized(anytime, i, anytime->start[i]);
+            }
+        }
+        _probe(&search, u);
+    }
+    if(!search.hasbest)
+    {
+        _coarse(&search);
+    }
+
+    // compass search around the best point, starting at half the grid spacing
+    double step = 0.5 / (ANYTIME_COARSE - 1);
+    double improvement = 0.0;
+    int converged = 0;
+    while(search.hasbest && _check_budget(&search))
+    {
+        if(step < anytime->tolerance || step == 0)
+        {
+            converged = 1;
+            break;
+        }
+        double before = search.bestscore;
+        int improved = 0;
+        for(size_t i = 0; i < PLL_NUM_VARIABLES && !improved && !search.exhausted; ++i)
+        {
+            if(!anytime->active[i])
+            {
+                continue;
+            }
+            for(int direction = -1; direction <= 1 && !improved; direction += 2)
+            {
+                double u[PLL_NUM_VARIABLES];
+                for(size_t j = 0; j < PLL_NUM_VARIABLES; ++j)
+                {
+                    u[j] = search.best[j];
+                }
+                u[i] = fmin(1.0, fmax(0.0, u[i] + direction * step));
+                if(u[i] == search.best[i])
+                {
+                    continue;
+                }
+                improved = _probe(&search, u);
+            }
+        }
+        if(improved)
+        {
+            improvement = before - search.bestscore;
+        }
+        else if(!search.exhausted)
+        {
+            step *= 0.5;
+        }
+    }
+
+    result->evaluations = search.evaluations;
+    result->elapsed = _elapsed(&search);
+    result->step = step;
+    result->improvement = improvement;
+    result->converged = converged;
+    result->cancelled = search.cancelled;
+    result->score = search.bestscore;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        result->variables[i] = anytime->active[i] && search.hasbest ? _value(anytime, i, search.best[i]) : pll_get_variable(state, i);
+        pll_set_variable(state, i, result->variables[i]);
+    }
+    return search.hasbest;
+}
@@ -0,0 +1,52 @@
+#ifndef PLL_ANYTIME_H
+#define PLL_ANYTIME_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Anytime optimization under a wall-clock and/or evaluation budget.
+// The search starts with a coarse grid over the ranges of the design variables and then refines around the best point
+// with a compass search (probe +- step along every variable, halve the step if nothing improves).
+// Positive ranges are searched on a logarithmic scale. When the budget expires (or the run is cancelled),
+// the best design found so far is returned together with a convergence estimate.
+// Variables without a range keep the value of the state.
+
+struct anytime_result {
+    double variables[PLL_NUM_VARIABLES];
+    double score;
+    size_t evaluations;
+    double elapsed; // in seconds
+    // convergence estimate: current step as a fraction of the (logarithmic) range,
+    // the best point is a local optimum of the score on this scale
+    double step;
+    double improvement; // score improvement of the last accepted refinement step
+    int converged; // step fell below the tolerance before the budget expired
+    int cancelled;
+};
+
+struct anytime;
+struct memo;
+
+struct anytime* anytime_create(void);
+void anytime_destroy(struct anytime* anytime);
+void anytime_set_range(struct anytime* anytime, enum pll_variable variable, double lower, double upper);
+// budget in seconds (0: no time limit, default: 0.2)
+void anytime_set_time_budget(struct anytime* anytime, double seconds);
+// maximum number of evaluations (0: no limit, default: 0)
+void anytime_set_evaluation_budget(struct anytime* anytime, size_t evaluations);
+// stop refining once the step is below 'tolerance' (fraction of the range, default: 1e-6)
+void anytime_set_tolerance(struct anytime* anytime, double tolerance);
+// evaluate through a memo cache (the compass search revisits points), NULL: pll_calculate directly
+void anytime_set_memo(struct anytime* anytime, struct memo* memo);
+// start the compass search at a known design (e.g. a stored optimum, PLL_NUM_VARIABLES values clamped to the ranges)
+// instead of the best point of the coarse grid, which is only sampled if the start is not valid or its score is not finite
+// (NULL: no start)
+void anytime_set_start(struct anytime* anytime, const double* variables);
+// can be called from any thread, anytime_run returns after the current evaluation (anytime_run clears the flag when it starts)
+void anytime_cancel(struct anytime* anytime);
+// runs the optimization on 'state' (the best design is left set in 'state'), returns 0 if no valid design with a finite
+// score was found
+int anytime_run(struct anytime* anytime, struct pll_state* state, evaluator eval, struct anytime_result* result);
+
+#endif /* PLL_ANYTIME_H */
@@ -0,0 +1,166 @@
+#include "batch.h"
+
+#include <complex.h>
+#include <math.h>
+
+#include "constants.h"
+#include "loopscan.h"
+#include "noise.h"
+#include "pll_internal.h"
+
+#ifndef BATCH_LANES
+#define BATCH_LANES 4
+#endif
+
+// one SIMD register of designs (GCC/clang vector extension, scalars are broadcast in mixed expressions)
+typedef double lanes __attribute__((vector_size(BATCH_LANES * sizeof(double))));
+
+struct group {
+    lanes Rf;
+    lanes Cf;
+    lanes Cfx;
+    lanes gm;
+    lanes Kvco;
+    lanes detectorgain;
+    size_t count; // valid lanes
+};
+
+static double _get(const double* values, size_t idx, double fallback)
+{
+    return values ? values[idx] : fallback;
+}
+
+static void _load_group(const struct pll_state* state, const struct batch_input* input, size_t first, size_t count, size_t corner, struct group* group)
+{
+    double Kvco = corner == 0 ? state->min_Kvco : state->max_Kvco;
+    group->count = count;
+    for(size_t l = 0; l < BATCH_LANES; ++l)
+    {
+        // unused lanes repeat the last design, their results are discarded
+        size_t idx = first + (l < count ? l : count - 1);
+        group->Rf[l] = _get(input->Rf, idx, state->Rf);
+        group->Cf[l] = _get(input->Cf, idx, state->Cf);
+        group->Cfx[l] = _get(input->Cfx, idx, state->Cfx);
+        group->gm[l] = _get(input->gm, idx, state->gm);
+        group->Kvco[l] = _get(input->Kvco, idx, Kvco);
+        group->detectorgain[l] = _get(input->detectorgain, idx, state->detectorgain);
+    }
+}
+
+// per-lane bookkeeping for the scalar parts (crossing search, phase unwrapping and integration)
+struct tracker {
+    struct loopscan scan;
+    double phaseoffset;
+};
+
+static void _calculate_group(const struct pll_state* state, const struct group* group, struct tracker* trackers)
+{
+    const struct context* context = state->context;
+    const double complex* f = vector_data(context->f);
+    const double complex* s = vector_data(context->s);
+    const double complex* Hparasitic = vector_data(context->Hparasitic);
+    const double complex* Sref = vector_data(context->Sref);
+    const double complex* Svco = vector_data(context->Svco);
+    const double complex* Scp = vector_data(context->Scp);
+    const double complex* Sphasedetector = vector_data(context->Sphasedetector);
+    size_t samples = context->samples;
+
+    unsigned int k = state->fsig / state->fref;
+    double kM = k / state->M; // integer division, like in pll_calculate
+    double invN = 1.0 / state->N;
+
+    // Hfilter: (1 + s * a) / (s * c1 + s^2 * c2)
+    lanes a = group->Rf * group->Cf;
+    lanes c1 = group->Cf + group->Cfx;
+    lanes c2 = group->Rf * group->Cf * group->Cfx;
+    lanes g = group->detectorgain * group->gm;
+    lanes g2 = g * g;
+    lanes gm2 = group->gm * group->gm;
+    lanes Sfilter0 = 1.657e-20 * group->Rf;
+    lanes vcogain = -2 * CONSTANTS_PI * group->Kvco;
+
+    for(size_t l = 0; l < BATCH_LANES; ++l)
+    {
+        loopscan_start(&trackers[l].scan, &state->jitterband);
+        trackers[l].phaseoffset = 0;
+    }
+
+    for(size_t j = 0; j < samples; ++j)
+    {
+        double w = cimag(s[j]);
+        double hpr = creal(Hparasitic[j]);
+        double hpi = cimag(Hparasitic[j]);
+
+        // Hfilter
+        lanes denr = -w * w * c2;
+        lanes deni = w * c1;
+        lanes numi = w * a;
+        lanes dd = denr * denr + deni * deni;
+        lanes hfr = (denr + numi * deni) / dd;
+        lanes hfi = (numi * denr - deni) / dd;
+        // Hvco = 2 * pi * Kvco / s = -i * 2 * pi * Kvco / w
+        lanes hv = vcogain / w;
+        // Hfilter * Hvco
+        lanes fvr = -hfi * hv;
+        lanes fvi = hfr * hv;
+        // Hloop = detectorgain * gm * Hfilter * Hvco * Hparasitic
+        lanes lr = g * (fvr * hpr - fvi * hpi);
+        lanes li = g * (fvr * hpi + fvi * hpr);
+        // 1 + 1 / N * Hloop
+        lanes dr = 1 + invN * lr;
+        lanes di = invN * li;
+        lanes dmag2 = dr * dr + di * di;
+        lanes loopmag2 = lr * lr + li * li;
+        lanes clmag2 = loopmag2 / dmag2;
+
+        // effective noise contributions (|NTF|^2 * S)
+        lanes Stot_ref = kM * kM * clmag2 * creal(Sref[j]);
+        lanes Stot_vco = creal(Svco[j]) / dmag2;
+        lanes Stot_cp = clmag2 / g2 * creal(Scp[j]);
+        lanes Stot_phasedetector = gm2 * (fvr * fvr + fvi * fvi) / dmag2 * creal(Sphasedetector[j]);
+        lanes Stot_filter = clmag2 / (g2 * (hfr * hfr + hfi * hfi)) * Sfilter0;
+        lanes Stot = Stot_ref + Stot_vco + Stot_cp + Stot_phasedetector + Stot_filter;
+
+        double fj = creal(f[j]);
+        for(size_t l = 0; l < group->count; ++l)
+        {
+            struct tracker* t = &trackers[l];
+            double magnitude = sqrt(loopmag2[l]);
+            double phase = 180 / CONSTANTS_PI * atan2(li[l], lr[l]);
+            phase = j == 0 ? phase : loopscan_unwrap(phase, t->scan.phase, &t->phaseoffset);
+            loopscan_add(&t->scan, fj, magnitude, log10(magnitude), phase, Stot[l]);
+        }
+    }
+}
+
+void batch_calculate(const struct pll_state* state, const struct batch_input* input, const struct batch_output* output, size_t count, size_t corner)
+{
+    struct tracker trackers[BATCH_LANES];
+    for(size_t first = 0; first < count; first += BATCH_LANES)
+    {
+        size_t groupcount = count - first < BATCH_LANES ? count - first : BATCH_LANES;
+        struct group group;
+        _load_group(state, input, first, groupcount, corner, &group);
+        _calculate_group(state, &group, trackers);
+        for(size_t l = 0; l < groupcount; ++l)
+        {
+            size_t idx = first + l;
+            if(output->phasemargin)
+            {
+                output->phasemargin[idx] = trackers[l].scan.phasemargin;
+            }
+            if(output->f0dB)
+            {
+                output->f0dB[idx] = trackers[l].scan.f0dB;
+            }
+            if(output->fbw)
+            {
+                output->fbw[idx] = trackers[l].scan.fbw;
+            }
+            if(output->Jrms)
+            {
+                output->Jrms[idx] = noise_area_to_RMSjitter(state->fsig, trackers[l].scan.Atot);
+            }
+        }
+    }
+}
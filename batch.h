@@ -0,0 +1,34 @@
+#ifndef PLL_BATCH_H
+#define PLL_BATCH_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Evaluate many designs that share the configuration of one (initialized) pll_state.
+// The designs are processed in groups of BATCH_LANES, vectorized across the designs at every frequency point,
+// so the shared data (s, Hparasitic, source PSDs) is only loaded once per group.
+// Every input array may be NULL, in which case the value of the state is used for all designs
+// (for Kvco this is min_Kvco or max_Kvco, depending on 'corner').
+// Output arrays may be NULL if a metric is not needed. Metrics that can not be determined (no 0 dB crossing) are NaN.
+// Additional jitter bands (pll_add_jitter_band) are not evaluated.
+
+struct batch_input {
+    const double* Rf;
+    const double* Cf;
+    const double* Cfx;
+    const double* gm;
+    const double* Kvco;
+    const double* detectorgain;
+};
+
+struct batch_output {
+    double* phasemargin;
+    double* f0dB;
+    double* fbw;
+    double* Jrms;
+};
+
+void batch_calculate(const struct pll_state* state, const struct batch_input* input, const struct batch_output* output, size_t count, size_t corner);
+
+#endif /* PLL_BATCH_H */
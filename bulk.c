@@ -0,0 +1,196 @@
+#include "bulk.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "memory.h"
+
+#define BULK_BUFFER_SIZE (256 * 1024)
+#define BULK_MAX_RECORD 4096 // upper bound of the length of one formatted record
+
+struct bulk {
+    FILE* file;
+    enum bulk_format format;
+    char* buffer;
+    size_t used;
+    int ok;
+};
+
+static const char* variablenames[PLL_NUM_VARIABLES] = { "Rf", "Cf", "Cfx", "gm" };
+
+#define BULK_NUM_METRICS 8
+static const char* metricnames[BULK_NUM_METRICS] = { "Jrms", "Jrms_vco", "Jrms_ref", "Jrms_cp", "Jrms_filter", "f0dB", "phasemargin", "fbw" };
+
+static const double* _get_metric(const struct pll_results* results, size_t metric)
+{
+    const double* metrics[BULK_NUM_METRICS] = {
+        results->Jrms,
+        results->Jrms_vco,
+        results->Jrms_ref,
+        results->Jrms_cp,
+        results->Jrms_filter,
+        results->f0dB,
+        results->phasemargin,
+        results->fbw,
+    };
+    return metrics[metric];
+}
+
+static void _append(struct bulk* bulk, const char* text)
+{
+    size_t length = strlen(text);
+    memcpy(bulk->buffer + bulk->used, text, length);
+    bulk->used += length;
+}
+
+static void _number(struct bulk* bulk, double value)
+{
+    if(isfinite(value))
+    {
+        bulk->used += snprintf(bulk->buffer + bulk->used, BULK_BUFFER_SIZE - bulk->used, "%.17g", value);
+    }
+    else if(bulk->format == BULK_JSONL)
+    {
+        _append(bulk, "null");
+    }
+    else
+    {
+        _append(bulk, isnan(value) ? "nan" : value > 0 ? "inf" : "-inf");
+    }
+}
+
+struct bulk* bulk_open(const char* filename, enum bulk_format format)
+{
+    FILE* file = fopen(filename, "w");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return NULL;
+    }
+    struct bulk* bulk = memory_allocate_zeroed(1, sizeof(*bulk));
+    bulk->file = file;
+    bulk->format = format;
+    bulk->buffer = memory_allocate(BULK_BUFFER_SIZE);
+    bulk->ok = 1;
+    if(format == BULK_CSV)
+    {
+        _append(bulk, "index");
+        for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+        {
+            _append(bulk, ",");
+            _append(bulk, variablenames[v]);
+        }
+        _append(bulk, ",valid,score");
+        for(size_t m = 0; m < BULK_NUM_METRICS; ++m)
+        {
+            // one column per Kvco corner
+            _append(bulk, ",");
+            _append(bulk, metricnames[m]);
+            _append(bulk, "_min,");
+            _append(bulk, metricnames[m]);
+            _append(bulk, "_max");
+        }
+        _append(bulk, "\n");
+    }
+    return bulk;
+}
+
+int bulk_flush(struct bulk* bulk)
+{
+    if(bulk->used > 0 && fwrite(bulk->buffer, 1, bulk->used, bulk->file) != bulk->used)
+    {
+        bulk->ok = 0;
+    }
+    bulk->used = 0;
+    return bulk->ok;
+}
+
+int bulk_close(struct bulk* bulk)
+{
+    bulk_flush(bulk);
+    int ok = fclose(bulk->file) == 0 && bulk->ok;
+    memory_free(bulk->buffer);
+    memory_free(bulk);
+    return ok;
+}
+
+enum bulk_format bulk_format_from_filename(const char* filename)
+{
+    const char* extension = strrchr(filename, '.');
+    if(extension && (strcmp(extension, ".jsonl") == 0 || strcmp(extension, ".json") == 0))
+    {
+        return BULK_JSONL;
+    }
+    return BULK_CSV;
+}
+
+static void _write_csv(struct bulk* bulk, size_t index, const double* variables, int valid, double score, const struct pll_results* results)
+{
+    bulk->used += snprintf(bulk->buffer + bulk->used, BULK_BUFFER_SIZE - bulk->used, "%zu", index);
+    for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+    {
+        _append(bulk, ",");
+        _number(bulk, variables[v]);
+    }
+    _append(bulk, valid ? ",1," : ",0,");
+    _number(bulk, score);
+    for(size_t m = 0; m < BULK_NUM_METRICS; ++m)
+    {
+        const double* values = _get_metric(results, m);
+        _append(bulk, ",");
+        _number(bulk, values[0]);
+        _append(bulk, ",");
+        _number(bulk, values[1]);
+    }
+    _append(bulk, "\n");
+}
+
+static void _write_jsonl(struct bulk* bulk, size_t index, const double* variables, int valid, double score, const struct pll_results* results)
+{
+    bulk->used += snprintf(bulk->buffer + bulk->used, BULK_BUFFER_SIZE - bulk->used, "{\"index\":%zu", index);
+    for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+    {
+        _append(bulk, ",\"");
+        _append(bulk, variablenames[v]);
+        _append(bulk, "\":");
+        _number(bulk, variables[v]);
+    }
+    _append(bulk, valid ? ",\"valid\":true,\"score\":" : ",\"valid\":false,\"score\":");
+    _number(bulk, score);
+    for(size_t m = 0; m < BULK_NUM_METRICS; ++m)
+    {
+        // [minimum Kvco, maximum Kvco]
+        const double* values = _get_metric(results, m);
+        _append(bulk, ",\"");
+        _append(bulk, metricnames[m]);
+        _append(bulk, "\":[");
+        _number(bulk, values[0]);
+        _append(bulk, ",");
+        _number(bulk, values[1]);
+        _append(bulk, "]");
+    }
+    _append(bulk, "}\n");
+}
+
+int bulk_write(struct bulk* bulk, size_t index, const double* variables, int valid, double score, const struct pll_results* results)
+{
+    if(BULK_BUFFER_SIZE - bulk->used < BULK_MAX_RECORD)
+    {
+        bulk_flush(bulk);
+    }
+    if(bulk->format == BULK_JSONL)
+    {
+        _write_jsonl(bulk, index, variables, valid, score, results);
+    }
+    else
+    {
+        _write_csv(bulk, index, variables, valid, score, results);
+    }
+    return bulk->ok;
+}
+
+int bulk_write_record(const struct sweep_record* record, void* bulk)
+{
+    return bulk_write(bulk, record->index, record->variables, record->valid, record->score, &record->results);
+}
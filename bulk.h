@@ -0,0 +1,33 @@
+#ifndef PLL_BULK_H
+#define PLL_BULK_H
+
+#include <stddef.h>
+
+#include "pll.h"
+#include "sweep.h"
+
+// Buffered machine-readable writer for many results (one line per design): CSV with a header line or JSON lines.
+// Records are formatted directly into an internal buffer that is written out in large blocks, nothing is allocated
+// per record or field. Numbers are written with 17 significant digits (exact round trip), metrics that could not be
+// determined are 'nan' in CSV and null in JSON. Not thread-safe (sweep writers are only called from one thread).
+
+enum bulk_format {
+    BULK_CSV,
+    BULK_JSONL
+};
+
+struct bulk;
+
+// returns NULL if the file can not be opened
+struct bulk* bulk_open(const char* filename, enum bulk_format format);
+// flushes and closes the file, returns 0 if any write failed
+int bulk_close(struct bulk* bulk);
+// CSV for every filename but *.jsonl and *.json
+enum bulk_format bulk_format_from_filename(const char* filename);
+
+int bulk_write(struct bulk* bulk, size_t index, const double* variables, int valid, double score, const struct pll_results* results);
+// sweep writer adapter, 'bulk' is a struct bulk*
+int bulk_write_record(const struct sweep_record* record, void* bulk);
+int bulk_flush(struct bulk* bulk);
+
+#endif /* PLL_BULK_H */
@@ -0,0 +1,51 @@
+#include "context.h"
+
+#include <stdlib.h>
+
+#include "constants.h"
+#include "memory.h"
+
+struct context* context_create(int flowerexp, int fupperexp, unsigned int pointsperdecade)
+{
+    struct context* context = memory_allocate(sizeof(*context));
+    atomic_init(&context->refcount, 1);
+    context->flowerexp = flowerexp;
+    context->fupperexp = fupperexp;
+    context->pointsperdecade = pointsperdecade;
+    context->samples = (fupperexp - flowerexp) * pointsperdecade;
+    context->f = vector_logspace(flowerexp, fupperexp, context->samples);
+    context->s = vector_copy(context->f);
+    vector_scale(context->s, 2 * CONSTANTS_PI * CONSTANTS_I);
+    context->Hparasitic = vector_create(context->samples, 1);
+    context->Sref = vector_create(context->samples, 0);
+    context->Svco = vector_create(context->samples, 0);
+    context->Scp = vector_create(context->samples, 0);
+    context->Sphasedetector = vector_create(context->samples, 0);
+    return context;
+}
+
+struct context* context_retain(struct context* context)
+{
+    atomic_fetch_add_explicit(&context->refcount, 1, memory_order_relaxed);
+    return context;
+}
+
+void context_release(struct context* context)
+{
+    if(!context)
+    {
+        return;
+    }
+    if(atomic_fetch_sub_explicit(&context->refcount, 1, memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+    vector_destroy(context->f);
+    vector_destroy(context->s);
+    vector_destroy(context->Hparasitic);
+    vector_destroy(context->Sref);
+    vector_destroy(context->Svco);
+    vector_destroy(context->Scp);
+    vector_destroy(context->Sphasedetector);
+    memory_free(context);
+}
@@ -0,0 +1,38 @@
+#ifndef PLL_CONTEXT_H
+#define PLL_CONTEXT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "vector.h"
+
+// Read-only data that only depends on the configuration of a pll_state (not on the filter or charge pump values).
+// A context is filled once by pll_initialize and is then shared (reference-counted) between all states
+// that are created with pll_clone or pll_initialize_shared. It must not be modified after initialization.
+struct context {
+    atomic_uint refcount;
+
+    int flowerexp;
+    int fupperexp;
+    unsigned int pointsperdecade;
+    size_t samples;
+
+    // evaluation grid
+    struct vector* f;
+    struct vector* s;
+
+    // product of all parasitic poles
+    struct vector* Hparasitic;
+
+    // source power spectral densities
+    struct vector* Sref;
+    struct vector* Svco;
+    struct vector* Scp;
+    struct vector* Sphasedetector;
+};
+
+struct context* context_create(int flowerexp, int fupperexp, unsigned int pointsperdecade);
+struct context* context_retain(struct context* context);
+void context_release(struct context* context);
+
+#endif /* PLL_CONTEXT_H */
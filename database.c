@@ -0,0 +1,499 @@
+#include "database.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+#define DATABASE_MAGIC "stajiba-database"
+#define DATABASE_VERSION 2
+#define DATABASE_MAX_CONFIGURATION 64
+
+struct point {
+    uint64_t confighash;
+    double variables[PLL_NUM_VARIABLES];
+    struct pll_results results;
+    struct point* next;
+};
+
+struct optimum {
+    uint64_t confighash;
+    uint64_t cost; // identity of the cost function of 'score'
+    double configuration[DATABASE_MAX_CONFIGURATION];
+    size_t configurationsize;
+    double variables[PLL_NUM_VARIABLES];
+    double score;
+};
+
+struct database {
+    FILE* file;
+    pthread_mutex_t mutex;
+
+    // points: chained hash table
+    struct point** buckets;
+    size_t numbuckets;
+    size_t numpoints;
+
+    struct optimum* optima;
+    size_t numoptima;
+    size_t optimacapacity;
+
+    size_t hits;
+    size_t misses;
+};
+
+static uint64_t _point_hash(uint64_t confighash, const double* variables)
+{
+    uint64_t hash = confighash;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        uint64_t bits;
+        double value = variables[i] == 0.0 ? 0.0 : variables[i];
+        memcpy(&bits, &value, sizeof(bits));
+        hash ^= bits + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+static int _same_variables(const double* a, const double* b)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(a[i] != b[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static struct point* _find_point(struct database* database, uint64_t confighash, const double* variables)
+{
+    size_t bucket = _point_hash(confighash, variables) & (database->numbuckets - 1);
+    for(struct point* point = database->buckets[bucket]; point; point = point->next)
+    {
+        if(point->confighash == confighash && _same_variables(point->variables, variables))
+        {
+            return point;
+        }
+    }
+    return NULL;
+}
+
+static void _rehash(struct database* database)
+{
+    size_t numbuckets = 2 * database->numbuckets;
+    struct point** buckets = memory_allocate_zeroed(numbuckets, sizeof(*buckets));
+    for(size_t i = 0; i < database->numbuckets; ++i)
+    {
+        struct point* point = database->buckets[i];
+        while(point)
+        {
+            struct point* next = point->next;
+            size_t bucket = _point_hash(point->confighash, point->variables) & (numbuckets - 1);
+            point->next = buckets[bucket];
+            buckets[bucket] = point;
+            point = next;
+        }
+    }
+    memory_free(database->buckets);
+    database->buckets = buckets;
+    database->numbuckets = numbuckets;
+}
+
+// returns 0 if the point was already present
+static int _add_point(struct database* database, uint64_t confighash, const double* variables, const struct pll_results* results)
+{
+    if(_find_point(database, confighash, variables))
+    {
+        return 0;
+    }
+    if(database->numpoints >= database->numbuckets)
+    {
+        _rehash(database);
+    }
+    struct point* point = memory_allocate(sizeof(*point));
+    point->confighash = confighash;
+    memcpy(point->variables, variables, sizeof(point->variables));
+    point->results = *results;
+    size_t bucket = _point_hash(confighash, variables) & (database->numbuckets - 1);
+    point->next = database->buckets[bucket];
+    database->buckets[bucket] = point;
+    ++database->numpoints;
+    return 1;
+}
+
+static struct optimum* _find_optimum(struct database* database, uint64_t confighash, uint64_t cost)
+{
+    for(size_t i = 0; i < database->numoptima; ++i)
+    {
+        if(database->optima[i].confighash == confighash && database->optima[i].cost == cost)
+        {
+            return &database->optima[i];
+        }
+    }
+    return NULL;
+}
+
+// returns 0 if an existing optimum was better
+static int _add_optimum(struct database* database, const struct optimum* optimum)
+{
+    struct optimum* existing = _find_optimum(database, optimum->confighash, optimum->cost);
+    if(existing)
+    {
+        if(existing->score <= optimum->score)
+        {
+            return 0;
+        }
+        *existing = *optimum;
+        return 1;
+    }
+    if(database->numoptima == database->optimacapacity)
+    {
+        database->optimacapacity = database->optimacapacity ? 2 * database->optimacapacity : 16;
+        database->optima = memory_reallocate(database->optima, database->optimacapacity * sizeof(*database->optima));
+    }
+    database->optima[database->numoptima] = *optimum;
+    ++database->numoptima;
+    return 1;
+}
+
+/*
+ * File I/O
+ * point <confighash> <variables> <results>
+ * best <confighash> <cost> <score> <variables> <configurationsize> <configuration>
+ * (optima of earlier versions were written as 'optimum <confighash> <score> ...' without the cost function,
+ * their scores can not be compared and they are skipped)
+ */
+
+static void _write_results(FILE* file, const struct pll_results* r)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        fprintf(
+            file, " %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g",
+            r->Jrms[i], r->Jrms_vco[i], r->Jrms_ref[i], r->Jrms_cp[i], r->Jrms_filter[i], r->f0dB[i], r->phasemargin[i], r->fbw[i]
+        );
+    }
+}
+
+static int _read_results(FILE* file, struct pll_results* r)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        int ret = fscanf(
+            file, "%lg %lg %lg %lg %lg %lg %lg %lg",
+            &r->Jrms[i], &r->Jrms_vco[i], &r->Jrms_ref[i], &r->Jrms_cp[i], &r->Jrms_filter[i], &r->f0dB[i], &r->phasemargin[i], &r->fbw[i]
+        );
+        if(ret != 8)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int _read_variables(FILE* file, double* variables)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(fscanf(file, "%lg", &variables[i]) != 1)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void _write_variables(FILE* file, const double* variables)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        fprintf(file, " %.17g", variables[i]);
+    }
+}
+
+static int _load(struct database* database, FILE* file, const char* filename)
+{
+    char magic[32];
+    int version;
+    if(fscanf(file, "%31s %d", magic, &version) != 2 || strcmp(magic, DATABASE_MAGIC) != 0 || version != DATABASE_VERSION)
+    {
+        fprintf(stderr, "database_open: '%s' is not a design database\n", filename);
+        return 0;
+    }
+    char tag[32];
+    while(fscanf(file, "%31s", tag) == 1)
+    {
+        int ok;
+        if(strcmp(tag, "point") == 0)
+        {
+            uint64_t confighash;
+            double variables[PLL_NUM_VARIABLES];
+            struct pll_results results;
+            ok = fscanf(file, "%" SCNx64, &confighash) == 1 && _read_variables(file, variables) && _read_results(file, &results);
+            if(ok)
+            {
+                _add_point(database, confighash, variables, &results);
+            }
+        }
+        else if(strcmp(tag, "best") == 0)
+        {
+            struct optimum optimum;
+            ok = fscanf(file, "%" SCNx64, &optimum.confighash) == 1;
+            ok = ok && fscanf(file, "%" SCNx64, &optimum.cost) == 1;
+            ok = ok && fscanf(file, "%lg", &optimum.score) == 1;
+            ok = ok && _read_variables(file, optimum.variables);
+            ok = ok && fscanf(file, "%zu", &optimum.configurationsize) == 1 && optimum.configurationsize <= DATABASE_MAX_CONFIGURATION;
+            for(size_t i = 0; ok && i < optimum.configurationsize; ++i)
+            {
+                ok = fscanf(file, "%lg", &optimum.configuration[i]) == 1;
+            }
+            if(ok)
+            {
+                _add_optimum(database, &optimum);
+            }
+        }
+        else
+        {
+            ok = 0;
+        }
+        if(!ok)
+        {
+            // a truncated last line (interrupted run) is not fatal, everything before it is kept
+            fprintf(stderr, "database_open: ignoring malformed entry '%s' in '%s'\n", tag, filename);
+            break;
+        }
+    }
+    return 1;
+}
+
+struct database* database_open(const char* filename)
+{
+    struct database* database = memory_allocate_zeroed(1, sizeof(*database));
+    pthread_mutex_init(&database->mutex, NULL);
+    database->numbuckets = 1024;
+    database->buckets = memory_allocate_zeroed(database->numbuckets, sizeof(*database->buckets));
+
+    FILE* existing = fopen(filename, "r");
+    if(existing)
+    {
+        int ok = _load(database, existing, filename);
+        fclose(existing);
+        if(!ok)
+        {
+            database_close(database);
+            return NULL;
+        }
+        database->file = fopen(filename, "a");
+    }
+    else
+    {
+        database->file = fopen(filename, "w");
+        if(database->file)
+        {
+            fprintf(database->file, "%s %d\n", DATABASE_MAGIC, DATABASE_VERSION);
+        }
+    }
+    if(!database->file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        database_close(database);
+        return NULL;
+    }
+    return database;
+}
+
+void database_close(struct database* database)
+{
+    if(database->file)
+    {
+        fclose(database->file);
+    }
+    for(size_t i = 0; i < database->numbuckets; ++i)
+    {
+        struct point* point = database->buckets[i];
+        while(point)
+        {
+            struct point* next = point->next;
+            memory_free(point);
+            point = next;
+        }
+    }
+    memory_free(database->buckets);
+    memory_free(database->optima);
+    pthread_mutex_destroy(&database->mutex);
+    memory_free(database);
+}
+
+static void _get_variables(const struct pll_state* state, double* variables)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        variables[i] = pll_get_variable(state, i);
+    }
+}
+
+int database_lookup(struct database* database, const struct pll_state* state, struct pll_results* results)
+{
+    uint64_t confighash = pll_get_configuration_hash(state);
+    double variables[PLL_NUM_VARIABLES];
+    _get_variables(state, variables);
+    pthread_mutex_lock(&database->mutex);
+    struct point* point = _find_point(database, confighash, variables);
+    if(point)
+    {
+        *results = point->results;
+        ++database->hits;
+    }
+    else
+    {
+        ++database->misses;
+    }
+    pthread_mutex_unlock(&database->mutex);
+    return point != NULL;
+}
+
+void database_insert(struct database* database, const struct pll_state* state, const struct pll_results* results)
+{
+    uint64_t confighash = pll_get_configuration_hash(state);
+    double variables[PLL_NUM_VARIABLES];
+    _get_variables(state, variables);
+    pthread_mutex_lock(&database->mutex);
+    if(_add_point(database, confighash, variables, results))
+    {
+        fprintf(database->file, "point %016" PRIx64, confighash);
+        _write_variables(database->file, variables);
+        _write_results(database->file, results);
+        fputc('\n', database->file);
+    }
+    pthread_mutex_unlock(&database->mutex);
+}
+
+int database_calculate(struct database* database, struct pll_state* state, struct pll_results* results)
+{
+    if(database_lookup(database, state, results))
+    {
+        return 1;
+    }
+    int valid = pll_calculate(state);
+    if(valid)
+    {
+        pll_get_results(state, results);
+        database_insert(database, state, results);
+    }
+    return valid;
+}
+
+void database_store_optimum(struct database* database, const struct pll_state* state, uint64_t cost, double score)
+{
+    struct optimum optimum;
+    optimum.confighash = pll_get_configuration_hash(state);
+    optimum.cost = cost;
+    optimum.configurationsize = pll_get_configuration(state, optimum.configuration, DATABASE_MAX_CONFIGURATION);
+    if(optimum.configurationsize > DATABASE_MAX_CONFIGURATION)
+    {
+        optimum.configurationsize = DATABASE_MAX_CONFIGURATION;
+    }
+    _get_variables(state, optimum.variables);
+    optimum.score = score;
+    pthread_mutex_lock(&database->mutex);
+    if(_add_optimum(database, &optimum))
+    {
+        fprintf(database->file, "best %016" PRIx64 " %016" PRIx64 " %.17g", optimum.confighash, optimum.cost, optimum.score);
+        _write_variables(database->file, optimum.variables);
+        fprintf(database->file, " %zu", optimum.configurationsize);
+        for(size_t i = 0; i < optimum.configurationsize; ++i)
+        {
+            fprintf(database->file, " %.17g", optimum.configuration[i]);
+        }
+        fputc('\n', database->file);
+        fflush(database->file);
+    }
+    pthread_mutex_unlock(&database->mutex);
+}
+
+// distance between two configurations: squared log-ratios of all values (same sign, non-zero),
+// a sign change or a change from/to zero counts as one decade, every missing parasitic pole as well
+static double _distance(const double* a, size_t sizea, const double* b, size_t sizeb)
+{
+    size_t common = sizea < sizeb ? sizea : sizeb;
+    double distance = 0.0;
+    for(size_t i = 0; i < common; ++i)
+    {
+        if(a[i] == b[i])
+        {
+            continue;
+        }
+        if(a[i] * b[i] > 0)
+        {
+            double d = log10(a[i] / b[i]);
+            distance += d * d;
+        }
+        else
+        {
+            distance += 1.0;
+        }
+    }
+    distance += (double)(sizea > sizeb ? sizea - sizeb : sizeb - sizea);
+    return sqrt(distance);
+}
+
+int database_find_optimum(struct database* database, const struct pll_state* state, uint64_t cost, double* variables, double* score, double* distance)
+{
+    double configuration[DATABASE_MAX_CONFIGURATION];
+    size_t configurationsize = pll_get_configuration(state, configuration, DATABASE_MAX_CONFIGURATION);
+    if(configurationsize > DATABASE_MAX_CONFIGURATION)
+    {
+        configurationsize = DATABASE_MAX_CONFIGURATION;
+    }
+    uint64_t confighash = pll_get_configuration_hash(state);
+    pthread_mutex_lock(&database->mutex);
+    const struct optimum* nearest = NULL;
+    double nearestdistance = HUGE_VAL;
+    for(size_t i = 0; i < database->numoptima; ++i)
+    {
+        const struct optimum* optimum = &database->optima[i];
+        if(optimum->cost != cost)
+        {
+            continue;
+        }
+        double d = optimum->confighash == confighash ? 0.0 : _distance(configuration, configurationsize, optimum->configuration, optimum->configurationsize);
+        if(d < nearestdistance)
+        {
+            nearestdistance = d;
+            nearest = optimum;
+        }
+    }
+    if(nearest)
+    {
+        memcpy(variables, nearest->variables, sizeof(nearest->variables));
+        *score = nearest->score;
+        *distance = nearestdistance;
+    }
+    pthread_mutex_unlock(&database->mutex);
+    return nearest != NULL;
+}
+
+// the counters are updated under the lock by concurrent lookups, so they are read under it as well
+static size_t _read(struct database* database, const size_t* counter)
+{
+    pthread_mutex_lock(&database->mutex);
+    size_t value = *counter;
+    pthread_mutex_unlock(&database->mutex);
+    return value;
+}
+
+size_t database_get_hits(struct database* database)
+{
+    return _read(database, &database->hits);
+}
+
+size_t database_get_misses(struct database* database)
+{
+    return _read(database, &database->misses);
+}
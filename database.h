@@ -0,0 +1,32 @@
+#ifndef PLL_DATABASE_H
+#define PLL_DATABASE_H
+
+#include "pll.h"
+
+// Persistent store of evaluated design points and optima.
+// Entries are keyed by the configuration hash of a pll_state (see pll_get_configuration_hash) and the design variables.
+// The file is plain text and append-only: it is read completely on open and new entries are appended.
+// All functions are thread-safe.
+
+struct database;
+
+struct database* database_open(const char* filename);
+void database_close(struct database* database);
+
+// exact hit for the current configuration and design variables of 'state'
+int database_lookup(struct database* database, const struct pll_state* state, struct pll_results* results);
+void database_insert(struct database* database, const struct pll_state* state, const struct pll_results* results);
+// lookup, otherwise run pll_calculate on 'state' and insert the result; returns the validity like pll_calculate
+int database_calculate(struct database* database, struct pll_state* state, struct pll_results* results);
+
+// remember the current design variables of 'state' as optimum of its configuration (kept if 'score' is better)
+// optima are kept per cost function, 'cost' identifies the one that computed 'score' (e.g. expression_get_hash)
+void database_store_optimum(struct database* database, const struct pll_state* state, uint64_t cost, double score);
+// find the stored optimum of the same cost function whose configuration is closest to the one of 'state'
+// 'distance' is 0 for an exact configuration match, returns 0 if no optimum is stored
+int database_find_optimum(struct database* database, const struct pll_state* state, uint64_t cost, double* variables, double* score, double* distance);
+
+size_t database_get_hits(struct database* database);
+size_t database_get_misses(struct database* database);
+
+#endif /* PLL_DATABASE_H */
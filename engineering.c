@@ -3,11 +3,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "engineering.h"
+#include "memory.h"
+
 static void _engineering_notation(double number, double* new_num, char* prefix)
 {
-    if(number == 0)
+    if(number == 0 || !isfinite(number))
     {
-        *new_num = 0;
+        *new_num = number;
         *prefix = ' ';
         return;
     }
@@ -31,20 +34,25 @@ static void _engineering_notation(double number, double* new_num, char* prefix)
         'Y', // Yotta
     };
     int power = floor(log(fabs(number)) / log(10) / 3);
+    // beyond the prefixes the mantissa grows (or shrinks) instead
+    power = power < -8 ? -8 : power > 8 ? 8 : power;
     *new_num = number / pow(10, 3 * power);
     *prefix = powertable[power + 8]; // 8: offset to zero power
 }
 
-char* engineering_format(double number, const char* unit, int precision)
+int engineering_format_buffer(char* buffer, size_t size, double number, const char* unit, int precision)
 {
     double new_num;
     char prefix;
     _engineering_notation(number, &new_num, &prefix);
-    char* fmt = malloc(100); // FIXME
-    sprintf(fmt, "%%%d.%df %%c%%s", 3 + 1 + precision, precision);
-    char* result = malloc(100); // FIXME
-    sprintf(result, fmt, new_num, prefix, unit);
-    free(fmt);
+    return snprintf(buffer, size, "%*.*f %c%s", 3 + 1 + precision, precision, new_num, prefix, unit);
+}
+
+char* engineering_format(double number, const char* unit, int precision)
+{
+    int length = engineering_format_buffer(NULL, 0, number, unit, precision);
+    char* result = memory_allocate(length + 1);
+    engineering_format_buffer(result, length + 1, number, unit, precision);
     return result;
 }
 
@@ -1,6 +1,14 @@
 #ifndef PLL_ENGINEERING_FORMAT
 #define PLL_ENGINEERING_FORMAT
 
+#include <stddef.h>
+
+// buffer size that is sufficient for engineering_format_buffer with units of up to 32 characters and a precision below 16
+#define ENGINEERING_FORMAT_SIZE 64
+
+// the result is allocated with memory_allocate (release it with memory_free)
 char* engineering_format(double number, const char* unit, int precision);
+// allocation-free variant, writes at most 'size' bytes (including the terminating zero), returns the length like snprintf
+int engineering_format_buffer(char* buffer, size_t size, double number, const char* unit, int precision);
 
 #endif /* PLL_ENGINEERING_FORMAT */
@@ -0,0 +1,528 @@
+#include "expression.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "memory.h"
+
+// Register machine: registers [0, EXPRESSION_NUM_SYMBOLS) hold the symbols, followed by the constants and the temporaries.
+// Every instruction writes a new register (no register is reused), the result is the last written register.
+
+#define EXPRESSION_MAX_REGISTERS 256
+
+enum opcode {
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_NEG,
+    OP_NOT,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_AND,
+    OP_OR,
+    OP_SELECT, // c ? a : b (condition in 'c')
+    OP_ABS,
+    OP_SQRT,
+    OP_EXP,
+    OP_LOG,
+    OP_LOG10,
+    OP_MIN,
+    OP_MAX
+};
+
+struct instruction {
+    unsigned char op;
+    unsigned char dst;
+    unsigned char a;
+    unsigned char b;
+    unsigned char c;
+};
+
+struct expression {
+    struct instruction* code;
+    size_t numcode;
+    double constants[EXPRESSION_MAX_REGISTERS]; // initial values of the constant registers
+    size_t numregisters;
+    unsigned char result;
+    unsigned int references;
+    unsigned char loads[EXPRESSION_NUM_SYMBOLS]; // referenced symbols
+    size_t numloads;
+    uint64_t hash; // of the text without white space
+};
+
+static const char* symbolnames[EXPRESSION_NUM_SYMBOLS] = {
+    "pm", "f0db", "fbw", "jrms", "jrms_vco", "jrms_ref", "jrms_cp", "jrms_filter", "rf", "cf", "cfx", "gm"
+};
+
+static const struct {
+    const char* name;
+    enum opcode op;
+    size_t numarguments;
+} functions[] = {
+    { "abs", OP_ABS, 1 },
+    { "sqrt", OP_SQRT, 1 },
+    { "exp", OP_EXP, 1 },
+    { "log", OP_LOG, 1 },
+    { "log10", OP_LOG10, 1 },
+    { "pow", OP_POW, 2 },
+    { "min", OP_MIN, 2 },
+    { "max", OP_MAX, 2 },
+};
+
+// compiler state (recursive descent, every parse function returns the register of its value)
+struct compiler {
+    const char* text;
+    const char* position;
+    struct expression* expression;
+    size_t capacity;
+    int error;
+    int constant[EXPRESSION_MAX_REGISTERS]; // register holds a compile-time constant
+};
+
+static int _fail(struct compiler* compiler, const char* message)
+{
+    if(!compiler->error)
+    {
+        fprintf(stderr, "expression: %s at position %zd in '%s'\n", message, compiler->position - compiler->text + 1, compiler->text);
+        compiler->error = 1;
+    }
+    return 0;
+}
+
+static int _new_register(struct compiler* compiler)
+{
+    if(compiler->expression->numregisters >= EXPRESSION_MAX_REGISTERS)
+    {
+        return _fail(compiler, "expression too long");
+    }
+    return compiler->expression->numregisters++;
+}
+
+static int _constant(struct compiler* compiler, double value)
+{
+    int reg = _new_register(compiler);
+    compiler->expression->constants[reg] = value;
+    compiler->constant[reg] = 1;
+    return reg;
+}
+
+static inline double _execute(const struct instruction* instruction, const double* r)
+{
+    double a = r[instruction->a];
+    double b = r[instruction->b];
+    switch(instruction->op)
+    {
+        case OP_ADD: return a + b;
+        case OP_SUB: return a - b;
+        case OP_MUL: return a * b;
+        case OP_DIV: return a / b;
+        case OP_POW: return pow(a, b);
+        case OP_NEG: return -a;
+        case OP_NOT: return !a;
+        case OP_LT: return a < b;
+        case OP_LE: return a <= b;
+        case OP_GT: return a > b;
+        case OP_GE: return a >= b;
+        case OP_EQ: return a == b;
+        case OP_NE: return a != b;
+        case OP_AND: return a != 0 && b != 0;
+        case OP_OR: return a != 0 || b != 0;
+        case OP_SELECT: return r[instruction->c] != 0 ? a : b;
+        case OP_ABS: return fabs(a);
+        case OP_SQRT: return sqrt(a);
+        case OP_EXP: return exp(a);
+        case OP_LOG: return log(a);
+        case OP_LOG10: return log10(a);
+        case OP_MIN: return a < b ? a : b;
+        case OP_MAX: return a > b ? a : b;
+    }
+    return NAN;
+}
+
+// emits an instruction, or folds it if all operands are constants
+static int _emit(struct compiler* compiler, enum opcode op, int a, int b, int c)
+{
+    if(compiler->error)
+    {
+        return 0;
+    }
+    struct instruction instruction = { op, 0, a, b, c };
+    if(compiler->constant[a] && compiler->constant[b] && compiler->constant[c])
+    {
+        return _constant(compiler, _execute(&instruction, compiler->expression->constants));
+    }
+    int dst = _new_register(compiler);
+    if(compiler->error)
+    {
+        return 0;
+    }
+    struct expression* expression = compiler->expression;
+    if(expression->numcode == compiler->capacity)
+    {
+        compiler->capacity = compiler->capacity > 0 ? 2 * compiler->capacity : 16;
+        expression->code = memory_reallocate(expression->code, compiler->capacity * sizeof(*expression->code));
+    }
+    instruction.dst = dst;
+    expression->code[expression->numcode++] = instruction;
+    return dst;
+}
+
+static void _skip_space(struct compiler* compiler)
+{
+    while(isspace((unsigned char)*compiler->position))
+    {
+        ++compiler->position;
+    }
+}
+
+static int _accept(struct compiler* compiler, const char* token)
+{
+    _skip_space(compiler);
+    size_t length = strlen(token);
+    if(strncmp(compiler->position, token, length) == 0)
+    {
+        compiler->position += length;
+        return 1;
+    }
+    return 0;
+}
+
+static int _expect(struct compiler* compiler, const char* token)
+{
+    if(!_accept(compiler, token))
+    {
+        char message[64];
+        snprintf(message, sizeof(message), "expected '%s'", token);
+        return _fail(compiler, message);
+    }
+    return 1;
+}
+
+static int _parse_conditional(struct compiler* compiler);
+
+static int _parse_primary(struct compiler* compiler)
+{
+    _skip_space(compiler);
+    const char* start = compiler->position;
+    if(_accept(compiler, "("))
+    {
+        int reg = _parse_conditional(compiler);
+        _expect(compiler, ")");
+        return reg;
+    }
+    if(isdigit((unsigned char)*start) || *start == '.')
+    {
+        char* end;
+        double value = strtod(start, &end);
+        compiler->position = end;
+        return _constant(compiler, value);
+    }
+    if(isalpha((unsigned char)*start) || *start == '_')
+    {
+        const char* end = start;
+        while(isalnum((unsigned char)*end) || *end == '_')
+        {
+            ++end;
+        }
+        size_t length = end - start;
+        compiler->position = end;
+        for(size_t i = 0; i < EXPRESSION_NUM_SYMBOLS; ++i)
+        {
+            if(strlen(symbolnames[i]) == length && strncmp(symbolnames[i], start, length) == 0)
+            {
+                compiler->expression->references |= 1u << i;
+                return i;
+            }
+        }
+        if(length == 3 && strncmp(start, "inf", 3) == 0)
+        {
+            return _constant(compiler, INFINITY);
+        }
+        if(length == 3 && strncmp(start, "nan", 3) == 0)
+        {
+            return _constant(compiler, NAN);
+        }
+        if(length == 2 && strncmp(start, "pi", 2) == 0)
+        {
+            return _constant(compiler, CONSTANTS_PI);
+        }
+        for(size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i)
+        {
+            if(strlen(functions[i].name) == length && strncmp(functions[i].name, start, length) == 0)
+            {
+                int arguments[2] = { 0, 0 };
+                _expect(compiler, "(");
+                for(size_t j = 0; j < functions[i].numarguments; ++j)
+                {
+                    if(j > 0)
+                    {
+                        _expect(compiler, ",");
+                    }
+                    arguments[j] = _parse_conditional(compiler);
+                }
+                _expect(compiler, ")");
+                return _emit(compiler, functions[i].op, arguments[0], arguments[functions[i].numarguments - 1], arguments[0]);
+            }
+        }
+        compiler->position = start;
+        return _fail(compiler, "unknown symbol");
+    }
+    return _fail(compiler, *start ? "unexpected character" : "unexpected end");
+}
+
+static int _parse_power(struct compiler* compiler)
+{
+    int base = _parse_primary(compiler);
+    if(_accept(compiler, "^"))
+    {
+        // right-associative, binds tighter than unary minus on its left (-2^2 = -4)
+        int exponent = _parse_power(compiler);
+        return _emit(compiler, OP_POW, base, exponent, base);
+    }
+    return base;
+}
+
+static int _parse_unary(struct compiler* compiler)
+{
+    if(_accept(compiler, "-"))
+    {
+        int reg = _parse_unary(compiler);
+        return _emit(compiler, OP_NEG, reg, reg, reg);
+    }
+    if(_accept(compiler, "+"))
+    {
+        return _parse_unary(compiler);
+    }
+    _skip_space(compiler);
+    if(compiler->position[0] == '!' && compiler->position[1] != '=')
+    {
+        ++compiler->position;
+        int reg = _parse_unary(compiler);
+        return _emit(compiler, OP_NOT, reg, reg, reg);
+    }
+    return _parse_power(compiler);
+}
+
+static int _parse_multiplicative(struct compiler* compiler)
+{
+    int left = _parse_unary(compiler);
+    while(!compiler->error)
+    {
+        if(_accept(compiler, "*"))
+        {
+            int right = _parse_unary(compiler);
+            left = _emit(compiler, OP_MUL, left, right, left);
+        }
+        else if(_accept(compiler, "/"))
+        {
+            int right = _parse_unary(compiler);
+            left = _emit(compiler, OP_DIV, left, right, left);
+        }
+        else
+        {
+            break;
+        }
+    }
+    return left;
+}
+
+static int _parse_additive(struct compiler* compiler)
+{
+    int left = _parse_multiplicative(compiler);
+    while(!compiler->error)
+    {
+        if(_accept(compiler, "+"))
+        {
+            int right = _parse_multiplicative(compiler);
+            left = _emit(compiler, OP_ADD, left, right, left);
+        }
+        else if(_accept(compiler, "-"))
+        {
+            int right = _parse_multiplicative(compiler);
+            left = _emit(compiler, OP_SUB, left, right, left);
+        }
+        else
+        {
+            break;
+        }
+    }
+    return left;
+}
+
+static int _parse_comparison(struct compiler* compiler)
+{
+    // two-character operators first
+    static const struct {
+        const char* token;
+        enum opcode op;
+    } operators[] = {
+        { "<=", OP_LE },
+        { ">=", OP_GE },
+        { "==", OP_EQ },
+        { "!=", OP_NE },
+        { "<", OP_LT },
+        { ">", OP_GT },
+    };
+    int left = _parse_additive(compiler);
+    int found = 1;
+    while(found && !compiler->error)
+    {
+        found = 0;
+        for(size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); ++i)
+        {
+            if(_accept(compiler, operators[i].token))
+            {
+                int right = _parse_additive(compiler);
+                left = _emit(compiler, operators[i].op, left, right, left);
+                found = 1;
+                break;
+            }
+        }
+    }
+    return left;
+}
+
+static int _parse_and(struct compiler* compiler)
+{
+    int left = _parse_comparison(compiler);
+    while(!compiler->error && _accept(compiler, "&&"))
+    {
+        int right = _parse_comparison(compiler);
+        left = _emit(compiler, OP_AND, left, right, left);
+    }
+    return left;
+}
+
+static int _parse_or(struct compiler* compiler)
+{
+    int left = _parse_and(compiler);
+    while(!compiler->error && _accept(compiler, "||"))
+    {
+        int right = _parse_and(compiler);
+        left = _emit(compiler, OP_OR, left, right, left);
+    }
+    return left;
+}
+
+static int _parse_conditional(struct compiler* compiler)
+{
+    int condition = _parse_or(compiler);
+    if(!compiler->error && _accept(compiler, "?"))
+    {
+        int a = _parse_conditional(compiler);
+        _expect(compiler, ":");
+        int b = _parse_conditional(compiler);
+        return _emit(compiler, OP_SELECT, a, b, condition);
+    }
+    return condition;
+}
+
+struct expression* expression_compile(const char* text)
+{
+    struct compiler compiler;
+    memset(&compiler, 0, sizeof(compiler));
+    compiler.text = text;
+    compiler.position = text;
+    compiler.expression = memory_allocate_zeroed(1, sizeof(*compiler.expression));
+    compiler.expression->numregisters = EXPRESSION_NUM_SYMBOLS;
+    int result = _parse_conditional(&compiler);
+    _skip_space(&compiler);
+    if(!compiler.error && *compiler.position)
+    {
+        _fail(&compiler, "unexpected character");
+    }
+    if(compiler.error)
+    {
+        expression_destroy(compiler.expression);
+        return NULL;
+    }
+    compiler.expression->result = result;
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(const char* c = text; *c; ++c)
+    {
+        if(!isspace((unsigned char)*c))
+        {
+            hash ^= (unsigned char)*c;
+            hash *= 1099511628211ULL;
+        }
+    }
+    compiler.expression->hash = hash ? hash : 1; // 0 is the built-in cost function
+    for(size_t i = 0; i < EXPRESSION_NUM_SYMBOLS; ++i)
+    {
+        if(compiler.expression->references & (1u << i))
+        {
+            compiler.expression->loads[compiler.expression->numloads++] = i;
+        }
+    }
+    return compiler.expression;
+}
+
+void expression_destroy(struct expression* expression)
+{
+    memory_free(expression->code);
+    memory_free(expression);
+}
+
+unsigned int expression_get_references(const struct expression* expression)
+{
+    return expression->references;
+}
+
+uint64_t expression_get_hash(const struct expression* expression)
+{
+    return expression->hash;
+}
+
+size_t expression_get_num_instructions(const struct expression* expression)
+{
+    return expression->numcode;
+}
+
+double expression_evaluate(const struct expression* expression, const double* values)
+{
+    double r[EXPRESSION_MAX_REGISTERS];
+    for(size_t i = 0; i < expression->numloads; ++i)
+    {
+        r[expression->loads[i]] = values[expression->loads[i]];
+    }
+    memcpy(r + EXPRESSION_NUM_SYMBOLS, expression->constants + EXPRESSION_NUM_SYMBOLS, (expression->numregisters - EXPRESSION_NUM_SYMBOLS) * sizeof(*r));
+    for(size_t i = 0; i < expression->numcode; ++i)
+    {
+        r[expression->code[i].dst] = _execute(&expression->code[i], r);
+    }
+    return r[expression->result];
+}
+
+static const struct expression* installed;
+
+static double _installed_evaluator(double phasemargin, double bandwidth, double Jrms)
+{
+    double values[EXPRESSION_NUM_SYMBOLS];
+    values[EXPRESSION_PHASEMARGIN] = phasemargin;
+    values[EXPRESSION_BANDWIDTH] = bandwidth;
+    values[EXPRESSION_JRMS] = Jrms;
+    return expression_evaluate(installed, values);
+}
+
+evaluator expression_install(const struct expression* expression)
+{
+    unsigned int available = (1u << EXPRESSION_PHASEMARGIN) | (1u << EXPRESSION_BANDWIDTH) | (1u << EXPRESSION_JRMS);
+    if(expression->references & ~available)
+    {
+        fprintf(stderr, "expression: cost functions can only use pm, fbw and jrms\n");
+        return NULL;
+    }
+    installed = expression;
+    return _installed_evaluator;
+}
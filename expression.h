@@ -0,0 +1,54 @@
+#ifndef PLL_EXPRESSION_H
+#define PLL_EXPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pll.h"
+
+// Cost functions as expressions over metrics and design variables, e.g. "10*abs(pm-70) + (fbw>2e6 ? inf : 0) + jrms/50e-15".
+// An expression is parsed once and compiled to register bytecode (constant subexpressions are folded),
+// evaluating it only runs a short loop over the instructions without any allocation.
+//
+// symbols: pm (phase margin), f0db, fbw, jrms, jrms_vco, jrms_ref, jrms_cp, jrms_filter (metrics of one Kvco corner),
+//          rf, cf, cfx, gm (design variables), constants inf, nan and pi
+// operators (by increasing precedence): ?:  ||  &&  == != < <= > >=  + -  * /  unary - !  ^ (power, right-associative)
+// functions: abs, sqrt, exp, log, log10, pow, min, max
+// comparisons and logical operators return 0 or 1, both branches of ?: are evaluated (a NaN in the unused branch does not propagate)
+
+enum expression_symbol {
+    EXPRESSION_PHASEMARGIN,
+    EXPRESSION_F0DB,
+    EXPRESSION_BANDWIDTH,
+    EXPRESSION_JRMS,
+    EXPRESSION_JRMS_VCO,
+    EXPRESSION_JRMS_REF,
+    EXPRESSION_JRMS_CP,
+    EXPRESSION_JRMS_FILTER,
+    EXPRESSION_RF,
+    EXPRESSION_CF,
+    EXPRESSION_CFX,
+    EXPRESSION_GM,
+    EXPRESSION_NUM_SYMBOLS
+};
+
+struct expression;
+
+// returns NULL (and reports the position of the error to stderr) if 'text' is not a valid expression
+struct expression* expression_compile(const char* text);
+void expression_destroy(struct expression* expression);
+// symbols that the expression depends on (bit 1 << expression_symbol), metrics that are not referenced need not be calculated
+unsigned int expression_get_references(const struct expression* expression);
+size_t expression_get_num_instructions(const struct expression* expression);
+// identity of the expression (hash of its text without white space, never 0), e.g. to tell scores of different cost functions apart
+uint64_t expression_get_hash(const struct expression* expression);
+
+// values: EXPRESSION_NUM_SYMBOLS entries (unreferenced entries are not read)
+double expression_evaluate(const struct expression* expression, const double* values);
+
+// The evaluator callback only receives phase margin, bandwidth and Jrms, so an expression is installed globally
+// and evaluated by the returned function. Returns NULL if the expression references any other symbol.
+// Only one expression can be installed at a time, it must not be destroyed while the evaluator is in use.
+evaluator expression_install(const struct expression* expression);
+
+#endif /* PLL_EXPRESSION_H */
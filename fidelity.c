@@ -0,0 +1,286 @@
+#include "fidelity.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "memory.h"
+#include "pll_internal.h"
+
+struct fidelity {
+    unsigned int* levels; // screening levels
+    size_t numlevels;
+    size_t reduction;
+
+    struct fidelity_level* reports;
+    size_t numreports;
+};
+
+struct fidelity* fidelity_create(void)
+{
+    struct fidelity* fidelity = memory_allocate_zeroed(1, sizeof(*fidelity));
+    fidelity->reduction = 4;
+    return fidelity;
+}
+
+void fidelity_destroy(struct fidelity* fidelity)
+{
+    memory_free(fidelity->levels);
+    memory_free(fidelity->reports);
+    memory_free(fidelity);
+}
+
+void fidelity_add_level(struct fidelity* fidelity, unsigned int pointsperdecade)
+{
+    fidelity->levels = memory_reallocate(fidelity->levels, (fidelity->numlevels + 1) * sizeof(*fidelity->levels));
+    fidelity->levels[fidelity->numlevels] = pointsperdecade;
+    ++fidelity->numlevels;
+}
+
+void fidelity_set_reduction(struct fidelity* fidelity, size_t reduction)
+{
+    fidelity->reduction = reduction > 1 ? reduction : 2;
+}
+
+static int _compare_unsigned(const void* lhs, const void* rhs)
+{
+    unsigned int a = *(const unsigned int*)lhs;
+    unsigned int b = *(const unsigned int*)rhs;
+    return (a > b) - (a < b);
+}
+
+struct entry {
+    size_t candidate;
+    double score;
+};
+
+// by score, ties by candidate (grid order)
+static int _compare_entry(const void* lhs, const void* rhs)
+{
+    const struct entry* a = lhs;
+    const struct entry* b = rhs;
+    if(a->score != b->score)
+    {
+        return a->score < b->score ? -1 : 1;
+    }
+    return (a->candidate > b->candidate) - (a->candidate < b->candidate);
+}
+
+// ranks (0-based, ties get the average rank) of 'values' in the order of 'values'
+static void _ranks(const double* values, size_t count, double* ranks)
+{
+    struct entry* entries = memory_allocate(count * sizeof(*entries));
+    for(size_t i = 0; i < count; ++i)
+    {
+        entries[i].candidate = i;
+        entries[i].score = values[i];
+    }
+    qsort(entries, count, sizeof(*entries), _compare_entry);
+    size_t i = 0;
+    while(i < count)
+    {
+        size_t j = i + 1;
+        while(j < count && entries[j].score == entries[i].score)
+        {
+            ++j;
+        }
+        for(size_t k = i; k < j; ++k)
+        {
+            ranks[entries[k].candidate] = 0.5 * (i + j - 1);
+        }
+        i = j;
+    }
+    memory_free(entries);
+}
+
+static double _spearman(const double* x, const double* y, size_t count)
+{
+    if(count < 2)
+    {
+        return NAN;
+    }
+    double* rx = memory_allocate(count * sizeof(*rx));
+    double* ry = memory_allocate(count * sizeof(*ry));
+    _ranks(x, count, rx);
+    _ranks(y, count, ry);
+    // Pearson correlation of the ranks (exact with ties)
+    double mean = 0.5 * (count - 1);
+    double sxy = 0.0;
+    double sxx = 0.0;
+    double syy = 0.0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        sxy += (rx[i] - mean) * (ry[i] - mean);
+        sxx += (rx[i] - mean) * (rx[i] - mean);
+        syy += (ry[i] - mean) * (ry[i] - mean);
+    }
+    memory_free(rx);
+    memory_free(ry);
+    if(sxx == 0.0 || syy == 0.0)
+    {
+        return NAN;
+    }
+    return sxy / sqrt(sxx * syy);
+}
+
+static double _evaluate(struct pll_state* state, const double* variables, evaluator eval)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        pll_set_variable(state, i, variables[i]);
+    }
+    if(!pll_calculate(state))
+    {
+        return INFINITY;
+    }
+    return pll_get_score(state, eval);
+}
+
+int fidelity_run(struct fidelity* fidelity, const struct sweep* grid, struct pll_state* state, evaluator eval, struct fidelity_result* result)
+{
+    size_t first, last;
+    sweep_get_range(grid, &first, &last);
+    size_t count = last - first;
+    if(count == 0)
+    {
+        return 0;
+    }
+    size_t* indices = memory_allocate(count * sizeof(*indices));
+    double (*variables)[PLL_NUM_VARIABLES] = memory_allocate(count * sizeof(*variables));
+    for(size_t i = 0; i < count; ++i)
+    {
+        indices[i] = sweep_get_index(grid, first + i);
+        sweep_get_point(grid, state, indices[i], variables[i]);
+    }
+
+    // screening levels (coarser than the production grid, coarsest first), then the production level
+    unsigned int* levels = memory_allocate((fidelity->numlevels + 1) * sizeof(*levels));
+    size_t numlevels = 0;
+    for(size_t i = 0; i < fidelity->numlevels; ++i)
+    {
+        if(fidelity->levels[i] < state->pointsperdecade)
+        {
+            levels[numlevels] = fidelity->levels[i];
+            ++numlevels;
+        }
+    }
+    qsort(levels, numlevels, sizeof(*levels), _compare_unsigned);
+    levels[numlevels] = state->pointsperdecade;
+    ++numlevels;
+
+    memory_free(fidelity->reports);
+    fidelity->reports = memory_allocate_zeroed(numlevels, sizeof(*fidelity->reports));
+    fidelity->numreports = numlevels;
+
+    // scores per level and candidate (only valid for the candidates that were evaluated on that level)
+    double* scores = memory_allocate(numlevels * count * sizeof(*scores));
+    struct entry* alive = memory_allocate(count * sizeof(*alive));
+    size_t numalive = count;
+    for(size_t i = 0; i < count; ++i)
+    {
+        alive[i].candidate = i;
+    }
+    // the sorted candidates of every level, for the rank of the winner
+    struct entry** ranking = memory_allocate(numlevels * sizeof(*ranking));
+    size_t* numranked = memory_allocate(numlevels * sizeof(*numranked));
+    double* x = memory_allocate(count * sizeof(*x));
+    double* y = memory_allocate(count * sizeof(*y));
+
+    double cost = 0.0;
+    size_t evaluations = 0;
+    size_t productionsamples = state->context->samples;
+    for(size_t l = 0; l < numlevels; ++l)
+    {
+        struct pll_state* levelstate = state;
+        if(l < numlevels - 1)
+        {
+            levelstate = pll_clone(state);
+            pll_set_eval_frequencies(levelstate, state->flowerexp, state->fupperexp, levels[l]);
+            pll_initialize(levelstate);
+        }
+        for(size_t i = 0; i < numalive; ++i)
+        {
+            size_t c = alive[i].candidate;
+            alive[i].score = _evaluate(levelstate, variables[c], eval);
+            scores[l * count + c] = alive[i].score;
+        }
+        evaluations += numalive;
+        cost += (double)numalive * levelstate->context->samples / ((double)count * productionsamples);
+        if(levelstate != state)
+        {
+            pll_cleanup(levelstate);
+        }
+        qsort(alive, numalive, sizeof(*alive), _compare_entry);
+        ranking[l] = memory_allocate(numalive * sizeof(*ranking[l]));
+        for(size_t i = 0; i < numalive; ++i)
+        {
+            ranking[l][i] = alive[i];
+        }
+        numranked[l] = numalive;
+
+        fidelity->reports[l].pointsperdecade = levels[l];
+        fidelity->reports[l].evaluated = numalive;
+        fidelity->reports[l].correlation = NAN;
+        if(l > 0)
+        {
+            // the candidates of this level are exactly the ones promoted from the previous level
+            for(size_t i = 0; i < numalive; ++i)
+            {
+                x[i] = scores[(l - 1) * count + alive[i].candidate];
+                y[i] = scores[l * count + alive[i].candidate];
+            }
+            fidelity->reports[l - 1].correlation = _spearman(x, y, numalive);
+        }
+        if(l < numlevels - 1)
+        {
+            // promote the best 1 / reduction of the candidates (at least one)
+            size_t promoted = (numalive + fidelity->reduction - 1) / fidelity->reduction;
+            numalive = promoted > 0 ? promoted : 1;
+        }
+    }
+
+    size_t winner = ranking[numlevels - 1][0].candidate;
+    for(size_t l = 0; l < numlevels; ++l)
+    {
+        for(size_t i = 0; i < numranked[l]; ++i)
+        {
+            if(ranking[l][i].candidate == winner)
+            {
+                fidelity->reports[l].winnerrank = i;
+                break;
+            }
+        }
+        memory_free(ranking[l]);
+    }
+
+    result->index = indices[winner];
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        result->variables[i] = variables[winner][i];
+    }
+    result->score = scores[(numlevels - 1) * count + winner];
+    result->evaluations = evaluations;
+    result->cost = cost;
+    // leave the winner (and its results) in the state
+    _evaluate(state, variables[winner], eval);
+
+    memory_free(x);
+    memory_free(y);
+    memory_free(ranking);
+    memory_free(numranked);
+    memory_free(alive);
+    memory_free(scores);
+    memory_free(levels);
+    memory_free(variables);
+    memory_free(indices);
+    return 1;
+}
+
+size_t fidelity_get_num_levels(const struct fidelity* fidelity)
+{
+    return fidelity->numreports;
+}
+
+void fidelity_get_level(const struct fidelity* fidelity, size_t level, struct fidelity_level* report)
+{
+    *report = fidelity->reports[level];
+}
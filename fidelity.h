@@ -0,0 +1,49 @@
+#ifndef PLL_FIDELITY_H
+#define PLL_FIDELITY_H
+
+#include <stddef.h>
+
+#include "pll.h"
+#include "sweep.h"
+
+// Multi-fidelity optimization over the points of a sweep grid (successive halving).
+// All candidates are screened on the coarsest frequency grid (fewest points per decade), the best 1 / reduction of them
+// are promoted to the next finer grid and so on, the survivors of the last screening level are confirmed on the
+// production grid of the state. Every level is a clone of the state with its own context (same frequency range).
+// For every promotion the Spearman rank correlation between the scores of the promoted candidates on both levels
+// is reported, a value close to 1 means that the coarse level ranks the candidates like the finer one.
+
+struct fidelity_level {
+    unsigned int pointsperdecade;
+    size_t evaluated;
+    // rank correlation of the promoted candidates between this level and the next (NaN for the production level)
+    double correlation;
+    // rank of the final winner among the candidates of this level (0: best)
+    size_t winnerrank;
+};
+
+struct fidelity_result {
+    size_t index; // linear grid index of the winner
+    double variables[PLL_NUM_VARIABLES];
+    double score; // on the production grid
+    size_t evaluations;
+    // cost relative to evaluating all candidates on the production grid (weighted by the number of frequency points)
+    double cost;
+};
+
+struct fidelity;
+
+struct fidelity* fidelity_create(void);
+void fidelity_destroy(struct fidelity* fidelity);
+// adds a screening level (the production level is always the grid of the state and must not be added)
+void fidelity_add_level(struct fidelity* fidelity, unsigned int pointsperdecade);
+// fraction of candidates that is promoted per level is 1 / reduction (default: 4)
+void fidelity_set_reduction(struct fidelity* fidelity, size_t reduction);
+// runs the optimization over the points of 'grid' (the axes and the shard of the sweep are used, nothing else),
+// 'state' must be initialized, the winner is left set in 'state', returns 0 if there is no candidate
+int fidelity_run(struct fidelity* fidelity, const struct sweep* grid, struct pll_state* state, evaluator eval, struct fidelity_result* result);
+// levels of the last run, coarsest first, the last one is the production level
+size_t fidelity_get_num_levels(const struct fidelity* fidelity);
+void fidelity_get_level(const struct fidelity* fidelity, size_t level, struct fidelity_level* report);
+
+#endif /* PLL_FIDELITY_H */
@@ -0,0 +1,105 @@
+#ifndef PLL_LOOPSCAN_H
+#define PLL_LOOPSCAN_H
+
+// Scalar metrics of pll_calculate computed in one pass over the grid, one frequency point at a time
+// (internal to the evaluators that do not store the spectra, i.e. batch and worstcase).
+// Every point contributes |Hloop|, log10(|Hloop|), the unwrapped phase of Hloop and Stot; the results follow the vector
+// implementation: the first 0 dB crossing (transfer_unity_gain_frequency and transfer_phase_margin), the bandwidth
+// (transfer_lowpass_bandwidth) and the area of Stot (noise_trapzS or noise_trapzS_band). Undetermined metrics are NaN.
+
+#include <math.h>
+
+#include "noise.h"
+
+struct loopscan {
+    struct noise_band band; // whole range if fupper <= flower
+    size_t points;
+    // previous point
+    double f;
+    double magnitude;
+    double logmagnitude;
+    double phase;
+    double Stot;
+
+    double bwlevel;
+    int found0dB;
+    int foundbw;
+    double phasemargin;
+    double f0dB;
+    double fbw;
+    double Atot;
+};
+
+static inline void loopscan_start(struct loopscan* scan, const struct noise_band* band)
+{
+    scan->band = *band;
+    scan->points = 0;
+    scan->bwlevel = 0;
+    scan->found0dB = 0;
+    scan->foundbw = 0;
+    scan->phasemargin = NAN;
+    scan->f0dB = NAN;
+    scan->fbw = NAN;
+    scan->Atot = 0;
+}
+
+// phase unwrapping (see vector_phase): 'phase' in degree plus the running 'offset', continued from 'previous'
+static inline double loopscan_unwrap(double phase, double previous, double* offset)
+{
+    phase += *offset;
+    if(phase - previous > 180)
+    {
+        *offset -= 360;
+        phase -= 360;
+    }
+    else if(phase - previous < -180)
+    {
+        *offset += 360;
+        phase += 360;
+    }
+    return phase;
+}
+
+static inline void loopscan_add(struct loopscan* scan, double f, double magnitude, double logmagnitude, double phase, double Stot)
+{
+    if(scan->points == 0)
+    {
+        // see transfer_lowpass_bandwidth
+        scan->bwlevel = 20 * logmagnitude * 0.707945784384138;
+    }
+    else
+    {
+        if(!scan->found0dB && scan->logmagnitude * logmagnitude < 0)
+        {
+            double frac = -scan->logmagnitude / (logmagnitude - scan->logmagnitude);
+            scan->f0dB = f + frac * (f - scan->f);
+            scan->phasemargin = phase + frac * (phase - scan->phase) + 180;
+            scan->found0dB = 1;
+        }
+        if(!scan->foundbw && (scan->magnitude - scan->bwlevel) * (magnitude - scan->bwlevel) < 0)
+        {
+            double frac = -scan->magnitude / (magnitude - scan->magnitude);
+            scan->fbw = f + frac * (f - scan->f);
+            scan->foundbw = 1;
+        }
+        double lower = scan->f;
+        double upper = f;
+        if(scan->band.fupper > scan->band.flower)
+        {
+            lower = scan->band.flower > lower ? scan->band.flower : lower;
+            upper = scan->band.fupper < upper ? scan->band.fupper : upper;
+        }
+        if(upper > lower)
+        {
+            scan->Atot += noise_segment_area(scan->f, f, scan->Stot, Stot, lower, upper);
+        }
+    }
+    ++scan->points;
+    scan->f = f;
+    scan->magnitude = magnitude;
+    scan->logmagnitude = logmagnitude;
+    scan->phase = phase;
+    scan->Stot = Stot;
+}
+
+#endif /* PLL_LOOPSCAN_H */
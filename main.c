@@ -1,10 +1,28 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <math.h>
 #include <float.h>
 
+#include "anytime.h"
+#include "bulk.h"
+#include "database.h"
+#include "expression.h"
+#include "fidelity.h"
+#include "measurement.h"
+#include "memo.h"
+#include "metrics.h"
+#include "montecarlo.h"
 #include "parameter.h"
+#include "plan.h"
 #include "pll.h"
+#include "report.h"
+#include "summary.h"
+#include "sweep.h"
+#include "synthesis.h"
+#include "transient.h"
+#include "worstcase.h"
 
 double eval(double phasemargin, double bandwidth, double Jrms)
 {
@@ -47,8 +65,216 @@ double eval(double phasemargin, double bandwidth, double Jrms)
     return score;
 }
 
-int main()
+// sweep writer that feeds the summary and (optionally) the metrics store and the results file
+struct writers {
+    struct summary* summary;
+    struct metrics* metrics;
+    struct bulk* results;
+};
+
+static int _write_record(const struct sweep_record* record, void* userdata)
+{
+    struct writers* writers = userdata;
+    if(writers->metrics)
+    {
+        metrics_add(writers->metrics, record);
+    }
+    if(writers->results && !bulk_write_record(record, writers->results))
+    {
+        return 0;
+    }
+    return summary_writer(record, writers->summary);
+}
+
+static void _usage(const char* progname)
+{
+    fprintf(stderr, "usage: %s [--shard INDEX/COUNT] [--summary FILE] [--database FILE] [--batched] [--montecarlo SAMPLES] [--yield PMMIN,PMMAX[,JRMSMAX]] [--synthesize F0DB,PM,CFX/CF] [--worstcase] [--plan] [--budget MILLISECONDS] [--multifidelity] [--metrics FILE] [--report FILE] [--results FILE] [--cost EXPRESSION] [--discrete RSERIES,CSERIES] [--transient STEP[,TOLERANCE]] [--vco-noise FILE] [--reference-noise FILE]\n", progname);
+}
+
+int main(int argc, char** argv)
 {
+    // command line: a sweep can be split into shards that are run in separate processes,
+    // each shard writes its summary to a file (combine them with the 'merge' tool)
+    size_t shardindex = 0;
+    size_t shardcount = 1;
+    const char* summaryfilename = NULL;
+    const char* databasefilename = NULL;
+    int batched = 0;
+    size_t montecarlosamples = 0;
+    // pass/fail of a Monte Carlo sample: phase margin range in degree and Jrms limit in seconds of both Kvco corners
+    double yieldphasemargin[2] = { 60, 80 };
+    double yieldJrms = INFINITY;
+    int synthesize = 0;
+    struct synthesis_target synthesistarget;
+    int worstcase = 0;
+    int explore = 0;
+    double budget = 0.0;
+    int multifidelity = 0;
+    const char* metricsfilename = NULL;
+    const char* reportfilename = NULL;
+    const char* resultsfilename = NULL;
+    // cost function: 'eval' unless an expression over pm, fbw and jrms is given
+    evaluator cost = eval;
+    struct expression* costexpression = NULL;
+    // E-series of resistors and capacitors (e.g. E96,E12) instead of the continuous filter grid
+    int discrete = 0;
+    enum parameter_series Rseries, Cseries;
+    // lock transient of the final design after an output frequency step (in Hz)
+    double transientstep = 0.0;
+    double transienttolerance = 1e3;
+    // measured L(f) profiles instead of the analytic noise models
+    const char* vconoisefilename = NULL;
+    const char* referencenoisefilename = NULL;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--shard") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[i + 1], "%zu/%zu", &shardindex, &shardcount) != 2 || shardcount == 0 || shardindex >= shardcount)
+            {
+                fprintf(stderr, "invalid shard specification: '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            ++i;
+        }
+        else if(strcmp(argv[i], "--summary") == 0 && i + 1 < argc)
+        {
+            summaryfilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--database") == 0 && i + 1 < argc)
+        {
+            databasefilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--batched") == 0)
+        {
+            batched = 1;
+        }
+        else if(strcmp(argv[i], "--montecarlo") == 0 && i + 1 < argc)
+        {
+            montecarlosamples = strtoul(argv[i + 1], NULL, 10);
+            ++i;
+        }
+        else if(strcmp(argv[i], "--yield") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[i + 1], "%lg,%lg,%lg", &yieldphasemargin[0], &yieldphasemargin[1], &yieldJrms) < 2 || !(yieldphasemargin[0] <= yieldphasemargin[1]))
+            {
+                fprintf(stderr, "invalid yield specification: '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            ++i;
+        }
+        else if(strcmp(argv[i], "--synthesize") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[i + 1], "%lg,%lg,%lg", &synthesistarget.f0dB, &synthesistarget.phasemargin, &synthesistarget.ratio) != 3)
+            {
+                fprintf(stderr, "invalid synthesis target: '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            synthesize = 1;
+            ++i;
+        }
+        else if(strcmp(argv[i], "--worstcase") == 0)
+        {
+            worstcase = 1;
+        }
+        else if(strcmp(argv[i], "--plan") == 0)
+        {
+            explore = 1;
+        }
+        else if(strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+        {
+            budget = strtod(argv[i + 1], NULL) / 1e3;
+            ++i;
+        }
+        else if(strcmp(argv[i], "--multifidelity") == 0)
+        {
+            multifidelity = 1;
+        }
+        else if(strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+        {
+            metricsfilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+        {
+            reportfilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--results") == 0 && i + 1 < argc)
+        {
+            resultsfilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--discrete") == 0 && i + 1 < argc)
+        {
+            char Rname[8], Cname[8];
+            if(sscanf(argv[i + 1], "%7[^,],%7s", Rname, Cname) != 2 || !parameter_series_from_name(Rname, &Rseries) || !parameter_series_from_name(Cname, &Cseries))
+            {
+                fprintf(stderr, "invalid component series: '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            discrete = 1;
+            ++i;
+        }
+        else if(strcmp(argv[i], "--transient") == 0 && i + 1 < argc)
+        {
+            if(sscanf(argv[i + 1], "%lg,%lg", &transientstep, &transienttolerance) < 1 || transientstep == 0 || !(transienttolerance > 0))
+            {
+                fprintf(stderr, "invalid transient specification: '%s'\n", argv[i + 1]);
+                return 1;
+            }
+            ++i;
+        }
+        else if(strcmp(argv[i], "--vco-noise") == 0 && i + 1 < argc)
+        {
+            vconoisefilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--reference-noise") == 0 && i + 1 < argc)
+        {
+            referencenoisefilename = argv[i + 1];
+            ++i;
+        }
+        else if(strcmp(argv[i], "--cost") == 0 && i + 1 < argc)
+        {
+            if(costexpression)
+            {
+                expression_destroy(costexpression);
+            }
+            costexpression = expression_compile(argv[i + 1]);
+            if(!costexpression || !(cost = expression_install(costexpression)))
+            {
+                return 1;
+            }
+            ++i;
+        }
+        else
+        {
+            _usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // optima in the database are kept per cost function
+    uint64_t costid = costexpression ? expression_get_hash(costexpression) : 0;
+
+    // measured L(f) profiles (text or binary, see measurement.h)
+    struct measurement* vconoise = NULL;
+    struct measurement* referencenoise = NULL;
+    if(vconoisefilename && !(vconoise = measurement_load(vconoisefilename)))
+    {
+        return 1;
+    }
+    if(referencenoisefilename && !(referencenoise = measurement_load(referencenoisefilename)))
+    {
+        if(vconoise)
+        {
+            measurement_destroy(vconoise);
+        }
+        return 1;
+    }
+
     struct pll_state* pll_state = pll_create();
 
     // 10^3 <-> 10^12 with 50 points per decade
@@ -73,6 +299,16 @@ int main()
     // Reference
     pll_set_reference_noise(pll_state, 1e3, -139, 1e-3);
 
+    // measured profiles replace the models above
+    if(vconoise)
+    {
+        pll_set_vco_noise_profile(pll_state, vconoise);
+    }
+    if(referencenoise)
+    {
+        pll_set_reference_noise_profile(pll_state, referencenoise);
+    }
+
     // parasitic poles (in Hz, not rad/s!)
     pll_add_parasitic_pole(pll_state, -1e10);
     pll_add_parasitic_pole(pll_state, -1e13);
@@ -92,50 +328,392 @@ int main()
     // define parameter ranges for filter values
     struct parameter* Rf_parameter = parameter_create(100, 10e3, 100);
     struct parameter* Cf_parameter = parameter_create(20e-12, 200e-12, 10e-12);
-
-    double last_score = DBL_MAX;
+    if(discrete)
+    {
+        // only manufacturable values in the same ranges, all grid based modes use these axes
+        parameter_destroy(Rf_parameter);
+        parameter_destroy(Cf_parameter);
+        Rf_parameter = parameter_create_series(Rseries, 100, 10e3);
+        Cf_parameter = parameter_create_series(Cseries, 20e-12, 200e-12);
+    }
 
     // final filter values
     double Rfvalue = 100;
     double Cfvalue = 20e-12;
+    double Cfxvalue = 0e-12;
 
     pll_initialize(pll_state);
 
-    // run optimization
+    // previously evaluated points are served from the database,
+    // the stored optimum of the closest configuration is the warm start of synthesis and the anytime search
+    struct database* database = NULL;
+    double seed[PLL_NUM_VARIABLES];
+    int seeded = 0;
+    if(databasefilename)
+    {
+        database = database_open(databasefilename);
+        if(!database)
+        {
+            return 1;
+        }
+        double score;
+        double distance;
+        if(database_find_optimum(database, pll_state, costid, seed, &score, &distance))
+        {
+            printf("nearest stored optimum (distance %.3g): Rf = %.1f Ohm, Cf = %.1f pF, score = %g\n", distance, seed[PLL_RF], seed[PLL_CF] / 1e-12, score);
+            seeded = 1;
+        }
+    }
+
+    if(explore)
+    {
+        // alternative frequency plans for the same output frequency, each with its best filter
+        struct plan* plan = plan_create();
+        plan_add_reference(plan, 250e6);
+        plan_add_reference(plan, 437.5e6);
+        plan_add_reference(plan, 875e6);
+        plan_add_reference(plan, 1.75e9);
+        plan_set_divider_range(plan, 4, 4);
+        plan_set_min_detector_frequency(plan, 100e6);
+        size_t numplans = plan_run(plan, pll_state, Rf_parameter, Cf_parameter, cost);
+        printf("%zd frequency plans:\n", numplans);
+        printf("  fref / MHz   N   M   Rf / Ohm   Cf / pF    score   f0dB / MHz   PM / Degree   Jrms / fs\n");
+        for(size_t i = 0; i < numplans; ++i)
+        {
+            const struct plan_result* result = plan_get_result(plan, i);
+            if(result->valid)
+            {
+                printf("  %10.2f %3u %3u %10.1f %9.1f %8.3g %12.2f %13.1f %11.1f\n", result->fref / 1e6, result->N, result->M, result->Rf, result->Cf / 1e-12, result->score, result->f0dB / 1e6, result->phasemargin, result->Jrms / 1e-15);
+            }
+            else
+            {
+                printf("  %10.2f %3u %3u   (no filter within the bandwidth limit)\n", result->fref / 1e6, result->N, result->M);
+            }
+        }
+        putchar('\n');
+        plan_destroy(plan);
+    }
+
     size_t numruns = 0;
-    while(!parameter_finished(Cf_parameter))
+    int status = 0; // exit status, the final design is only evaluated and reported if it is 0
+    if(synthesize)
+    {
+        // direct synthesis instead of a sweep
+        struct synthesis_result result;
+        int converged = 0;
+        if(seeded)
+        {
+            // warm start at the stored optimum, the closed form is the fallback
+            converged = synthesis_run_from(pll_state, &synthesistarget, seed[PLL_RF], seed[PLL_CF], 20, &result);
+            numruns = result.evaluations;
+        }
+        if(!converged)
+        {
+            converged = synthesis_run(pll_state, &synthesistarget, 20, &result);
+            numruns += result.evaluations;
+        }
+        if(converged)
+        {
+            Rfvalue = result.Rf;
+            Cfvalue = result.Cf;
+            Cfxvalue = result.Cfx;
+        }
+        else
+        {
+            // the target was rejected (reported by synthesis_run) or the last iterate is not a design to report
+            if(result.evaluations > 0)
+            {
+                fprintf(stderr, "synthesis did not converge (f0dB = %g Hz, phase margin = %g Degree)\n", result.f0dB, result.phasemargin);
+            }
+            status = 1;
+        }
+    }
+    else if(budget > 0)
+    {
+        // best design within the time budget instead of the full grid
+        struct anytime* anytime = anytime_create();
+        anytime_set_range(anytime, PLL_RF, 100, 10e3);
+        anytime_set_range(anytime, PLL_CF, 20e-12, 200e-12);
+        anytime_set_time_budget(anytime, budget);
+        struct memo* memo = memo_create(4096);
+        anytime_set_memo(anytime, memo);
+        anytime_set_start(anytime, seeded ? seed : NULL);
+        struct anytime_result result;
+        if(anytime_run(anytime, pll_state, cost, &result))
+        {
+            printf("anytime: score = %g after %.1f ms, step = %.2g of the range (%s)\n", result.score, result.elapsed * 1e3, result.step, result.converged ? "converged" : "budget expired");
+            printf("memo cache: %zd hits, %zd misses (%.1f %%)\n", memo_get_hits(memo), memo_get_misses(memo), 100 * memo_get_hit_rate(memo));
+            Rfvalue = result.variables[PLL_RF];
+            Cfvalue = result.variables[PLL_CF];
+        }
+        else
+        {
+            fprintf(stderr, "no feasible design\n");
+            status = 1;
+        }
+        numruns = result.evaluations;
+        anytime_destroy(anytime);
+        memo_destroy(memo);
+    }
+    else if(multifidelity)
     {
-        double Cf = parameter_next(Cf_parameter);
-        while(!parameter_finished(Rf_parameter))
+        // screen the grid on coarse frequency grids, confirm the survivors on the production grid
+        struct sweep* grid = sweep_create();
+        sweep_set_axis(grid, PLL_RF, Rf_parameter);
+        sweep_set_axis(grid, PLL_CF, Cf_parameter);
+        sweep_set_shard(grid, shardindex, shardcount);
+        struct fidelity* fidelity = fidelity_create();
+        fidelity_add_level(fidelity, 5);
+        struct fidelity_result result;
+        if(fidelity_run(fidelity, grid, pll_state, cost, &result))
         {
-            double Rf = parameter_next(Rf_parameter);
-            pll_set_filter(pll_state, Rf, Cf, 0e-12);
-            //printf("Rf = %g, Cf = %g\n", Rf, Cf);
-            int valid = pll_calculate(pll_state);
-            ++numruns;
-            if(valid)
+            for(size_t i = 0; i < fidelity_get_num_levels(fidelity); ++i)
             {
-                double score = pll_get_score(pll_state, eval);
-                if(score < last_score)
+                struct fidelity_level level;
+                fidelity_get_level(fidelity, i, &level);
+                printf("fidelity %2u points per decade: %4zd candidates, ", level.pointsperdecade, level.evaluated);
+                // the production level has no next level to correlate with
+                if(i + 1 < fidelity_get_num_levels(fidelity))
                 {
-                    last_score = score;
-                    Rfvalue = Rf;
-                    Cfvalue = Cf;
+                    printf("rank correlation to next level = %5.3f, ", level.correlation);
                 }
+                printf("winner rank = %zd\n", level.winnerrank);
             }
+            printf("multi-fidelity cost: %.1f %% of the full grid\n", 100 * result.cost);
+            Rfvalue = result.variables[PLL_RF];
+            Cfvalue = result.variables[PLL_CF];
+            numruns = result.evaluations;
+        }
+        fidelity_destroy(fidelity);
+        sweep_destroy(grid);
+    }
+    else
+    {
+        // run optimization
+        struct sweep* sweep = sweep_create();
+        sweep_set_axis(sweep, PLL_RF, Rf_parameter);
+        sweep_set_axis(sweep, PLL_CF, Cf_parameter);
+        sweep_set_evaluator(sweep, cost);
+        sweep_set_order(sweep, SWEEP_ORDER_SERPENTINE);
+        sweep_set_threads(sweep, 4);
+        sweep_set_shard(sweep, shardindex, shardcount);
+        sweep_set_database(sweep, database);
+        struct summary* summary = summary_create();
+        struct writers writers = { summary, metricsfilename ? metrics_create() : NULL, NULL };
+        if(resultsfilename)
+        {
+            // every sweep point (CSV or JSON lines, depending on the extension)
+            writers.results = bulk_open(resultsfilename, bulk_format_from_filename(resultsfilename));
+        }
+        sweep_set_writer(sweep, _write_record, &writers);
+        if(batched)
+        {
+            sweep_run_batched(sweep, pll_state);
+        }
+        else
+        {
+            sweep_run_pipelined(sweep, pll_state);
+        }
+        if(summaryfilename)
+        {
+            summary_write(summary, summaryfilename);
+        }
+        summary_destroy(summary);
+        if(writers.results && !bulk_close(writers.results))
+        {
+            fprintf(stderr, "could not write results '%s'\n", resultsfilename);
+        }
+        if(writers.metrics)
+        {
+            // raw metrics for re-scoring with other cost functions (see the 'rescore' tool)
+            metrics_write(writers.metrics, metricsfilename, pll_get_configuration_hash(pll_state));
+            metrics_destroy(writers.metrics);
+        }
+        struct sweep_record best;
+        if(sweep_get_best(sweep, &best))
+        {
+            Rfvalue = best.variables[PLL_RF];
+            Cfvalue = best.variables[PLL_CF];
+        }
+        else
+        {
+            fprintf(stderr, "no feasible design\n");
+            status = 1;
+        }
+        struct sweep_statistics statistics;
+        sweep_get_statistics(sweep, &statistics);
+        numruns = statistics.evaluated;
+        sweep_destroy(sweep);
+    }
+
+    if(status == 0 && discrete && (synthesize || budget > 0))
+    {
+        // the continuous optimum is replaced by the best combination of the neighbouring series values
+        // (plain rounding to the nearest values can break the margins); the axes are built around the optimum
+        // because synthesis is not limited to the sweep ranges
+        struct sweep* rounding = sweep_create();
+        struct parameter* Rf_series = parameter_create_series(Rseries, Rfvalue / 2, Rfvalue * 2);
+        struct parameter* Cf_series = parameter_create_series(Cseries, Cfvalue / 2, Cfvalue * 2);
+        sweep_set_axis(rounding, PLL_RF, Rf_series);
+        sweep_set_axis(rounding, PLL_CF, Cf_series);
+        struct parameter* Cfx_parameter = NULL;
+        if(Cfxvalue > 0)
+        {
+            Cfx_parameter = parameter_create_series(Cseries, Cfxvalue / 2, Cfxvalue * 2);
+            sweep_set_axis(rounding, PLL_CFX, Cfx_parameter);
+        }
+        sweep_set_evaluator(rounding, cost);
+        double variables[PLL_NUM_VARIABLES];
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            variables[i] = pll_get_variable(pll_state, i);
+        }
+        variables[PLL_RF] = Rfvalue;
+        variables[PLL_CF] = Cfvalue;
+        variables[PLL_CFX] = Cfxvalue;
+        struct sweep_record rounded;
+        if(sweep_round(rounding, pll_state, variables, &rounded))
+        {
+            printf("rounded to E%d/E%d: Rf = %.1f Ohm -> %.1f Ohm, Cf = %.2f pF -> %.2f pF, score = %g\n", Rseries, Cseries, Rfvalue, rounded.variables[PLL_RF], Cfvalue / 1e-12, rounded.variables[PLL_CF] / 1e-12, rounded.score);
+            Rfvalue = rounded.variables[PLL_RF];
+            Cfvalue = rounded.variables[PLL_CF];
+            Cfxvalue = rounded.variables[PLL_CFX];
+        }
+        else
+        {
+            fprintf(stderr, "no valid design with E%d/E%d values next to the optimum\n", Rseries, Cseries);
+        }
+        sweep_destroy(rounding);
+        parameter_destroy(Rf_series);
+        parameter_destroy(Cf_series);
+        if(Cfx_parameter)
+        {
+            parameter_destroy(Cfx_parameter);
         }
-        parameter_reset(Rf_parameter);
+    }
+
+    if(database)
+    {
+        printf("database: %zu hits, %zu misses\n", database_get_hits(database), database_get_misses(database));
     }
 
     // final run to print results
-    pll_set_filter(pll_state, Rfvalue, Cfvalue, 0e-12);
-    int valid = pll_calculate(pll_state);
+    pll_set_filter(pll_state, Rfvalue, Cfvalue, Cfxvalue);
+    int valid = status == 0 && pll_calculate(pll_state);
     if(valid)
     {
         printf("completed after %zd runs\n", numruns);
-        printf("Rf = %.1f Ohm, Cf = %.1f pF\n\n", Rfvalue, Cfvalue / 1e-12);
+        if(Cfxvalue > 0)
+        {
+            printf("Rf = %.1f Ohm, Cf = %.1f pF, Cfx = %.2f pF\n\n", Rfvalue, Cfvalue / 1e-12, Cfxvalue / 1e-12);
+        }
+        else
+        {
+            printf("Rf = %.1f Ohm, Cf = %.1f pF\n\n", Rfvalue, Cfvalue / 1e-12);
+        }
         pll_print_result(pll_state);
+        if(reportfilename)
+        {
+            // LaTeX/pgfplots report of the final design (compile with pdflatex)
+            struct report* report = report_create(reportfilename);
+            if(report)
+            {
+                report_results(report, pll_state);
+                report_bode(report, pll_state, "Loop gain (maximum $K_{VCO}$)");
+                report_noise(report, pll_state, "Noise contributions (maximum $K_{VCO}$)");
+                if(!report_close(report))
+                {
+                    fprintf(stderr, "could not write report '%s'\n", reportfilename);
+                }
+            }
+        }
+        if(transientstep != 0)
+        {
+            struct transient* transient = transient_create();
+            transient_set_frequency_step(transient, transientstep);
+            transient_set_tolerance(transient, transienttolerance);
+            for(size_t corner = 0; corner < 2; ++corner)
+            {
+                struct transient_result result;
+                if(transient_simulate(transient, pll_state, corner, &result))
+                {
+                    printf("transient (%s Kvco): settling time = %.3g us%s, overshoot = %.1f %%, peak phase error = %.3g rad%s\n",
+                        corner == 0 ? "minimum" : "maximum",
+                        result.settlingtime / 1e-6,
+                        result.settled ? "" : " (not settled)",
+                        100 * result.overshoot,
+                        result.peakphaseerror,
+                        result.cycleslip ? " (cycle slip)" : ""
+                    );
+                }
+            }
+            transient_destroy(transient);
+        }
+        if(worstcase)
+        {
+            // sign-off over the whole tuning range, not only the corners
+            struct worstcase* search = worstcase_create(pll_state);
+            struct worstcase_result pm;
+            struct worstcase_result jitter;
+            worstcase_search(search, WORSTCASE_PHASEMARGIN, &pm);
+            worstcase_search(search, WORSTCASE_JRMS, &jitter);
+            printf("worst case: phase margin = %.2f Degree at Kvco = %.3g Hz/V (%zd evaluations)\n", pm.value, pm.Kvco, pm.evaluations);
+            printf("worst case: Jrms = %.2f fs at Kvco = %.3g Hz/V (%zd evaluations)\n", jitter.value / 1e-15, jitter.Kvco, jitter.evaluations);
+            worstcase_destroy(search);
+        }
+        if(database)
+        {
+            database_store_optimum(database, pll_state, costid, pll_get_score(pll_state, cost));
+        }
+        if(montecarlosamples > 0)
+        {
+            // component tolerances: 1 % resistors, 5 % capacitors, 10 % charge pump, 20 % Kvco, 5 % detector gain
+            struct montecarlo* montecarlo = montecarlo_create();
+            montecarlo_set_distribution(montecarlo, MONTECARLO_RF, MONTECARLO_NORMAL, 0.01 / 3);
+            montecarlo_set_distribution(montecarlo, MONTECARLO_CF, MONTECARLO_NORMAL, 0.05 / 3);
+            montecarlo_set_distribution(montecarlo, MONTECARLO_GM, MONTECARLO_NORMAL, 0.1 / 3);
+            montecarlo_set_distribution(montecarlo, MONTECARLO_KVCO, MONTECARLO_UNIFORM, 0.2);
+            montecarlo_set_distribution(montecarlo, MONTECARLO_DETECTORGAIN, MONTECARLO_NORMAL, 0.05 / 3);
+            montecarlo_set_threads(montecarlo, 4);
+            // pass: metric limits of --yield, independent of the cost function (which only must not fail)
+            montecarlo_set_limits(montecarlo, MONTECARLO_PHASEMARGIN, yieldphasemargin[0], yieldphasemargin[1]);
+            montecarlo_set_limits(montecarlo, MONTECARLO_JRMS, 0, yieldJrms);
+            montecarlo_run(montecarlo, pll_state, cost, montecarlosamples);
+            printf("Monte Carlo: yield = %.2f %% (+- %.2f %%) of %zd samples\n", 100 * montecarlo_get_yield(montecarlo), 100 * montecarlo_get_yield_error(montecarlo), montecarlo_get_samples(montecarlo));
+            printf("phase margin (1 / 50 / 99 %%): %.1f / %.1f / %.1f Degree\n",
+                montecarlo_get_percentile(montecarlo, MONTECARLO_PHASEMARGIN, 1),
+                montecarlo_get_percentile(montecarlo, MONTECARLO_PHASEMARGIN, 50),
+                montecarlo_get_percentile(montecarlo, MONTECARLO_PHASEMARGIN, 99)
+            );
+            printf("Jrms (1 / 50 / 99 %%): %.1f / %.1f / %.1f fs\n",
+                montecarlo_get_percentile(montecarlo, MONTECARLO_JRMS, 1) / 1e-15,
+                montecarlo_get_percentile(montecarlo, MONTECARLO_JRMS, 50) / 1e-15,
+                montecarlo_get_percentile(montecarlo, MONTECARLO_JRMS, 99) / 1e-15
+            );
+            montecarlo_destroy(montecarlo);
+        }
+    }
+
+    if(database)
+    {
+        database_close(database);
     }
 
     pll_cleanup(pll_state);
+    if(vconoise)
+    {
+        measurement_destroy(vconoise);
+    }
+    if(referencenoise)
+    {
+        measurement_destroy(referencenoise);
+    }
+    parameter_destroy(Rf_parameter);
+    parameter_destroy(Cf_parameter);
+
+    if(costexpression)
+    {
+        expression_destroy(costexpression);
+    }
+    return status;
 }
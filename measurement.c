@@ -0,0 +1,233 @@
+#include "measurement.h"
+
+#include <complex.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "memory.h"
+#include "noise.h"
+
+#define MEASUREMENT_MAGIC "STJBPN01"
+#define MEASUREMENT_HEADER 16
+
+struct measurement {
+    size_t size;
+    // binary files are used in place, text files are parsed into 'data'
+    const double* points; // f0, L0, f1, L1, ...
+    double* data;
+    void* mapping;
+    size_t mappingsize;
+    uint64_t hash;
+};
+
+static int _parse_text(struct measurement* measurement, const char* text, size_t length, const char* filename)
+{
+    size_t capacity = 1024;
+    measurement->data = memory_allocate(2 * capacity * sizeof(*measurement->data));
+    const char* ptr = text;
+    const char* end = text + length;
+    size_t line = 1;
+    while(ptr < end)
+    {
+        const char* eol = memchr(ptr, '\n', end - ptr);
+        if(!eol)
+        {
+            eol = end;
+        }
+        // skip leading whitespace, empty lines and comments
+        while(ptr < eol && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r'))
+        {
+            ++ptr;
+        }
+        if(ptr < eol && *ptr != '#')
+        {
+            char buf[128];
+            size_t n = eol - ptr < 127 ? eol - ptr : 127;
+            memcpy(buf, ptr, n);
+            buf[n] = 0;
+            for(size_t i = 0; i < n; ++i)
+            {
+                if(buf[i] == ',' || buf[i] == ';')
+                {
+                    buf[i] = ' ';
+                }
+            }
+            double f, L;
+            if(sscanf(buf, "%lg %lg", &f, &L) != 2)
+            {
+                // a header line is allowed as the first non-comment line
+                if(measurement->size > 0)
+                {
+                    fprintf(stderr, "measurement_load: could not parse line %zu of '%s'\n", line, filename);
+                    return 0;
+                }
+            }
+            else
+            {
+                if(measurement->size == capacity)
+                {
+                    capacity *= 2;
+                    measurement->data = memory_reallocate(measurement->data, 2 * capacity * sizeof(*measurement->data));
+                }
+                measurement->data[2 * measurement->size] = f;
+                measurement->data[2 * measurement->size + 1] = L;
+                ++measurement->size;
+            }
+        }
+        ptr = eol + 1;
+        ++line;
+    }
+    measurement->points = measurement->data;
+    return 1;
+}
+
+static int _check(const struct measurement* measurement, const char* filename)
+{
+    if(measurement->size < 2)
+    {
+        fprintf(stderr, "measurement_load: '%s' contains less than two points\n", filename);
+        return 0;
+    }
+    for(size_t i = 0; i < measurement->size; ++i)
+    {
+        if(measurement->points[2 * i] <= 0 || (i > 0 && measurement->points[2 * i] <= measurement->points[2 * (i - 1)]))
+        {
+            fprintf(stderr, "measurement_load: frequencies in '%s' must be positive and strictly ascending (point %zu)\n", filename, i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint64_t _hash(const struct measurement* measurement)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char* bytes = (const unsigned char*)measurement->points;
+    for(size_t i = 0; i < 2 * measurement->size * sizeof(double); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+struct measurement* measurement_load(const char* filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+    {
+        fprintf(stderr, "could not open file '%s' for reading\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        fprintf(stderr, "measurement_load: '%s' is empty\n", filename);
+        close(fd);
+        return NULL;
+    }
+    void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        fprintf(stderr, "measurement_load: could not map '%s'\n", filename);
+        return NULL;
+    }
+    madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+    struct measurement* measurement = memory_allocate_zeroed(1, sizeof(*measurement));
+    measurement->mapping = mapping;
+    measurement->mappingsize = st.st_size;
+    int ok;
+    if((size_t)st.st_size >= MEASUREMENT_HEADER && memcmp(mapping, MEASUREMENT_MAGIC, 8) == 0)
+    {
+        uint64_t count;
+        memcpy(&count, (const char*)mapping + 8, sizeof(count));
+        ok = count <= ((size_t)st.st_size - MEASUREMENT_HEADER) / (2 * sizeof(double));
+        if(!ok)
+        {
+            fprintf(stderr, "measurement_load: '%s' is truncated\n", filename);
+        }
+        measurement->size = count;
+        measurement->points = (const double*)((const char*)mapping + MEASUREMENT_HEADER);
+    }
+    else
+    {
+        ok = _parse_text(measurement, mapping, st.st_size, filename);
+        // the text is not needed anymore
+        munmap(measurement->mapping, measurement->mappingsize);
+        measurement->mapping = NULL;
+    }
+    if(!ok || !_check(measurement, filename))
+    {
+        measurement_destroy(measurement);
+        return NULL;
+    }
+    measurement->hash = _hash(measurement);
+    return measurement;
+}
+
+void measurement_destroy(struct measurement* measurement)
+{
+    if(measurement->mapping)
+    {
+        munmap(measurement->mapping, measurement->mappingsize);
+    }
+    memory_free(measurement->data);
+    memory_free(measurement);
+}
+
+int measurement_write_binary(const struct measurement* measurement, const char* filename)
+{
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    uint64_t count = measurement->size;
+    int ok = fwrite(MEASUREMENT_MAGIC, 8, 1, file) == 1;
+    ok = ok && fwrite(&count, sizeof(count), 1, file) == 1;
+    ok = ok && fwrite(measurement->points, 2 * sizeof(double), measurement->size, file) == measurement->size;
+    fclose(file);
+    return ok;
+}
+
+size_t measurement_get_size(const struct measurement* measurement)
+{
+    return measurement->size;
+}
+
+uint64_t measurement_get_hash(const struct measurement* measurement)
+{
+    return measurement->hash;
+}
+
+void measurement_add_PSD(const struct measurement* measurement, struct vector* S, struct vector* f)
+{
+    const double* p = measurement->points;
+    size_t size = measurement->size;
+    // both the grid and the measurement are sorted, so the segment is found by walking along
+    size_t segment = 0;
+    for(size_t i = 0; i < vector_size(f); ++i)
+    {
+        double freq = creal(vector_get(f, i));
+        while(segment < size - 2 && p[2 * (segment + 1)] < freq)
+        {
+            ++segment;
+        }
+        double f1 = p[2 * segment];
+        double f2 = p[2 * (segment + 1)];
+        double L1 = p[2 * segment + 1];
+        double L2 = p[2 * (segment + 1) + 1];
+        // L is already logarithmic, so log-log interpolation is linear in L over log(f)
+        double L = L1 + (L2 - L1) * log(freq / f1) / log(f2 / f1);
+        vector_set(S, i, vector_get(S, i) + noise_L_to_S(L));
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef PLL_MEASUREMENT_H
+#define PLL_MEASUREMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vector.h"
+
+// Measured phase noise profile L(f) in dBc/Hz.
+// Files are memory-mapped and can either be text (two columns 'f L', separated by commas or whitespace, '#' starts a comment)
+// or binary: the magic "STJBPN01", a little-endian uint64 point count and then 'count' pairs of doubles (f, L).
+// Frequencies must be strictly ascending.
+struct measurement;
+
+struct measurement* measurement_load(const char* filename);
+void measurement_destroy(struct measurement* measurement);
+int measurement_write_binary(const struct measurement* measurement, const char* filename);
+size_t measurement_get_size(const struct measurement* measurement);
+// hash of the data (used to identify a profile in a pll configuration)
+uint64_t measurement_get_hash(const struct measurement* measurement);
+// S += interpolated PSD (rad^2/Hz, log-log interpolation, end segments are extrapolated with their slope)
+void measurement_add_PSD(const struct measurement* measurement, struct vector* S, struct vector* f);
+
+#endif /* PLL_MEASUREMENT_H */
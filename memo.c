@@ -0,0 +1,318 @@
+#include "memo.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+struct key {
+    uint64_t confighash;
+    int64_t cells[PLL_NUM_VARIABLES];
+};
+
+struct entry {
+    struct key key;
+    struct pll_results results;
+    // hash chain
+    struct entry* next;
+    // LRU list (most recently used first)
+    struct entry* newer;
+    struct entry* older;
+};
+
+struct memo {
+    pthread_mutex_t mutex;
+    double tolerance;
+
+    // all entries are allocated up front, unused ones are kept in a free list (chained by 'next')
+    struct entry* entries;
+    struct entry* free;
+    size_t capacity;
+    size_t size;
+
+    struct entry** buckets;
+    size_t numbuckets;
+
+    struct entry* newest;
+    struct entry* oldest;
+
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+};
+
+struct memo* memo_create(size_t capacity)
+{
+    struct memo* memo = memory_allocate_zeroed(1, sizeof(*memo));
+    pthread_mutex_init(&memo->mutex, NULL);
+    memo->capacity = capacity > 0 ? capacity : 1;
+    memo->entries = memory_allocate_zeroed(memo->capacity, sizeof(*memo->entries));
+    // at least two buckets per entry (power of two)
+    memo->numbuckets = 1;
+    while(memo->numbuckets < 2 * memo->capacity)
+    {
+        memo->numbuckets *= 2;
+    }
+    memo->buckets = memory_allocate_zeroed(memo->numbuckets, sizeof(*memo->buckets));
+    memo_clear(memo);
+    memo->hits = 0;
+    memo->misses = 0;
+    memo->evictions = 0;
+    return memo;
+}
+
+void memo_destroy(struct memo* memo)
+{
+    pthread_mutex_destroy(&memo->mutex);
+    memory_free(memo->entries);
+    memory_free(memo->buckets);
+    memory_free(memo);
+}
+
+void memo_set_tolerance(struct memo* memo, double tolerance)
+{
+    memo->tolerance = tolerance;
+}
+
+void memo_clear(struct memo* memo)
+{
+    pthread_mutex_lock(&memo->mutex);
+    memset(memo->buckets, 0, memo->numbuckets * sizeof(*memo->buckets));
+    memo->free = NULL;
+    for(size_t i = memo->capacity; i > 0; --i)
+    {
+        memo->entries[i - 1].next = memo->free;
+        memo->free = &memo->entries[i - 1];
+    }
+    memo->size = 0;
+    memo->newest = NULL;
+    memo->oldest = NULL;
+    pthread_mutex_unlock(&memo->mutex);
+}
+
+// quantization cell of one variable: logarithmic cells of relative width 'tolerance' (keeping the sign),
+// the bit pattern of the value for exact matching
+static int64_t _cell(double value, double tolerance)
+{
+    if(value == 0.0)
+    {
+        return 0;
+    }
+    if(tolerance > 0)
+    {
+        int64_t cell = llround(log(fabs(value)) / log1p(tolerance));
+        // odd values only (0 is value == 0), the sign is folded into the second bit
+        return 4 * cell + (value < 0 ? 3 : 1);
+    }
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static void _make_key(const struct memo* memo, const struct pll_state* state, struct key* key)
+{
+    memset(key, 0, sizeof(*key));
+    key->confighash = pll_get_configuration_hash(state);
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        key->cells[i] = _cell(pll_get_variable(state, i), memo->tolerance);
+    }
+}
+
+static size_t _bucket(const struct memo* memo, const struct key* key)
+{
+    uint64_t hash = key->confighash;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        hash ^= (uint64_t)key->cells[i] + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash & (memo->numbuckets - 1);
+}
+
+static int _same_key(const struct key* a, const struct key* b)
+{
+    if(a->confighash != b->confighash)
+    {
+        return 0;
+    }
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(a->cells[i] != b->cells[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void _unlink(struct memo* memo, struct entry* entry)
+{
+    if(entry->newer)
+    {
+        entry->newer->older = entry->older;
+    }
+    else
+    {
+        memo->newest = entry->older;
+    }
+    if(entry->older)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else
+    {
+        memo->oldest = entry->newer;
+    }
+}
+
+static void _push_newest(struct memo* memo, struct entry* entry)
+{
+    entry->newer = NULL;
+    entry->older = memo->newest;
+    if(memo->newest)
+    {
+        memo->newest->newer = entry;
+    }
+    memo->newest = entry;
+    if(!memo->oldest)
+    {
+        memo->oldest = entry;
+    }
+}
+
+static struct entry* _find(struct memo* memo, const struct key* key)
+{
+    for(struct entry* entry = memo->buckets[_bucket(memo, key)]; entry; entry = entry->next)
+    {
+        if(_same_key(&entry->key, key))
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void _remove_from_bucket(struct memo* memo, struct entry* entry)
+{
+    struct entry** link = &memo->buckets[_bucket(memo, &entry->key)];
+    while(*link != entry)
+    {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+}
+
+int memo_lookup(struct memo* memo, const struct pll_state* state, struct pll_results* results)
+{
+    // the configuration hash is calculated outside of the lock
+    struct key key;
+    _make_key(memo, state, &key);
+    pthread_mutex_lock(&memo->mutex);
+    struct entry* entry = _find(memo, &key);
+    if(entry)
+    {
+        *results = entry->results;
+        _unlink(memo, entry);
+        _push_newest(memo, entry);
+        ++memo->hits;
+    }
+    else
+    {
+        ++memo->misses;
+    }
+    pthread_mutex_unlock(&memo->mutex);
+    return entry != NULL;
+}
+
+void memo_insert(struct memo* memo, const struct pll_state* state, const struct pll_results* results)
+{
+    struct key key;
+    _make_key(memo, state, &key);
+    pthread_mutex_lock(&memo->mutex);
+    struct entry* entry = _find(memo, &key);
+    if(entry)
+    {
+        // inserted by another thread in the meantime
+        _unlink(memo, entry);
+    }
+    else
+    {
+        if(memo->free)
+        {
+            entry = memo->free;
+            memo->free = entry->next;
+            ++memo->size;
+        }
+        else
+        {
+            // evict the least recently used entry
+            entry = memo->oldest;
+            _unlink(memo, entry);
+            _remove_from_bucket(memo, entry);
+            ++memo->evictions;
+        }
+        entry->key = key;
+        size_t bucket = _bucket(memo, &key);
+        entry->next = memo->buckets[bucket];
+        memo->buckets[bucket] = entry;
+    }
+    entry->results = *results;
+    _push_newest(memo, entry);
+    pthread_mutex_unlock(&memo->mutex);
+}
+
+int memo_calculate(struct memo* memo, struct pll_state* state, struct pll_results* results)
+{
+    if(memo_lookup(memo, state, results))
+    {
+        return 1;
+    }
+    int valid = pll_calculate(state);
+    if(valid)
+    {
+        pll_get_results(state, results);
+        memo_insert(memo, state, results);
+    }
+    return valid;
+}
+
+// the counters are updated under the lock by concurrent lookups and inserts, so they are read under it as well
+static size_t _read(struct memo* memo, const size_t* counter)
+{
+    pthread_mutex_lock(&memo->mutex);
+    size_t value = *counter;
+    pthread_mutex_unlock(&memo->mutex);
+    return value;
+}
+
+size_t memo_get_size(struct memo* memo)
+{
+    return _read(memo, &memo->size);
+}
+
+size_t memo_get_hits(struct memo* memo)
+{
+    return _read(memo, &memo->hits);
+}
+
+size_t memo_get_misses(struct memo* memo)
+{
+    return _read(memo, &memo->misses);
+}
+
+size_t memo_get_evictions(struct memo* memo)
+{
+    return _read(memo, &memo->evictions);
+}
+
+double memo_get_hit_rate(struct memo* memo)
+{
+    pthread_mutex_lock(&memo->mutex);
+    size_t hits = memo->hits;
+    size_t lookups = memo->hits + memo->misses;
+    pthread_mutex_unlock(&memo->mutex);
+    return lookups > 0 ? (double)hits / lookups : 0.0;
+}
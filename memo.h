@@ -0,0 +1,34 @@
+#ifndef PLL_MEMO_H
+#define PLL_MEMO_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Bounded in-memory cache of evaluation results in front of pll_calculate (for optimizers that revisit points).
+// Entries are keyed by the configuration hash of the state (see pll_get_configuration_hash, this includes the Kvco range)
+// and the design variables, quantized to a relative tolerance: all points within one quantization cell share the results
+// of the first point that was evaluated in it (tolerance 0: exact match).
+// The least recently used entry is evicted when the cache is full. All functions are thread-safe,
+// a point that is missed by two threads at the same time is calculated by both.
+
+struct memo;
+
+struct memo* memo_create(size_t capacity);
+void memo_destroy(struct memo* memo);
+// relative quantization tolerance of the design variables (default: 0), set it before the cache is used
+void memo_set_tolerance(struct memo* memo, double tolerance);
+// cached results for the current configuration and design variables of 'state'
+int memo_lookup(struct memo* memo, const struct pll_state* state, struct pll_results* results);
+void memo_insert(struct memo* memo, const struct pll_state* state, const struct pll_results* results);
+// lookup, otherwise run pll_calculate on 'state' and insert the result; returns the validity like pll_calculate
+int memo_calculate(struct memo* memo, struct pll_state* state, struct pll_results* results);
+void memo_clear(struct memo* memo);
+
+size_t memo_get_size(struct memo* memo);
+size_t memo_get_hits(struct memo* memo);
+size_t memo_get_misses(struct memo* memo);
+size_t memo_get_evictions(struct memo* memo);
+double memo_get_hit_rate(struct memo* memo);
+
+#endif /* PLL_MEMO_H */
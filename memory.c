@@ -0,0 +1,124 @@
+#include "memory.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every block starts with a header in front of the returned memory that stores the requested size and the offset
+// of the returned memory from the start of the block (the header size for plain blocks, the alignment otherwise).
+
+struct header {
+    size_t offset;
+    size_t size;
+};
+
+#define MEMORY_HEADER 16
+
+static atomic_size_t live;
+static atomic_size_t peak;
+static atomic_size_t allocations;
+static atomic_size_t frees;
+
+static void _account(size_t bytes)
+{
+    size_t current = atomic_fetch_add(&live, bytes) + bytes;
+    size_t maximum = atomic_load(&peak);
+    while(current > maximum && !atomic_compare_exchange_weak(&peak, &maximum, current))
+    {
+    }
+    atomic_fetch_add(&allocations, 1);
+}
+
+static void* _finish(unsigned char* block, size_t offset, size_t bytes)
+{
+    if(!block)
+    {
+        return NULL;
+    }
+    struct header* header = (struct header*)(block + offset - MEMORY_HEADER);
+    header->offset = offset;
+    header->size = bytes;
+    _account(bytes);
+    return block + offset;
+}
+
+static struct header* _get_header(void* memory)
+{
+    return (struct header*)((unsigned char*)memory - MEMORY_HEADER);
+}
+
+void* memory_allocate(size_t bytes)
+{
+    return _finish(malloc(MEMORY_HEADER + bytes), MEMORY_HEADER, bytes);
+}
+
+void* memory_allocate_zeroed(size_t count, size_t size)
+{
+    void* memory = memory_allocate(count * size);
+    if(memory)
+    {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void* memory_allocate_aligned(size_t alignment, size_t bytes)
+{
+    if(alignment < MEMORY_HEADER)
+    {
+        alignment = MEMORY_HEADER;
+    }
+    // aligned_alloc needs a multiple of the alignment
+    size_t size = (alignment + bytes + alignment - 1) / alignment * alignment;
+    return _finish(aligned_alloc(alignment, size), alignment, bytes);
+}
+
+void* memory_reallocate(void* memory, size_t bytes)
+{
+    if(!memory)
+    {
+        return memory_allocate(bytes);
+    }
+    struct header* header = _get_header(memory);
+    size_t size = header->size;
+    if(header->offset != MEMORY_HEADER)
+    {
+        // aligned blocks are moved (realloc does not keep the alignment)
+        void* new = memory_allocate_aligned(header->offset, bytes);
+        memcpy(new, memory, size < bytes ? size : bytes);
+        memory_free(memory);
+        return new;
+    }
+    unsigned char* block = realloc((unsigned char*)memory - MEMORY_HEADER, MEMORY_HEADER + bytes);
+    if(!block)
+    {
+        return NULL;
+    }
+    atomic_fetch_sub(&live, size);
+    return _finish(block, MEMORY_HEADER, bytes);
+}
+
+void memory_free(void* memory)
+{
+    if(!memory)
+    {
+        return;
+    }
+    struct header* header = _get_header(memory);
+    atomic_fetch_sub(&live, header->size);
+    atomic_fetch_add(&frees, 1);
+    free((unsigned char*)memory - header->offset);
+}
+
+void memory_get_statistics(struct memory_statistics* statistics)
+{
+    statistics->live = atomic_load(&live);
+    statistics->peak = atomic_load(&peak);
+    statistics->allocations = atomic_load(&allocations);
+    statistics->frees = atomic_load(&frees);
+}
+
+void memory_reset_peak(void)
+{
+    atomic_store(&peak, atomic_load(&live));
+}
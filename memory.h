@@ -0,0 +1,28 @@
+#ifndef PLL_MEMORY_H
+#define PLL_MEMORY_H
+
+#include <stddef.h>
+
+// Heap allocation with accounting: all modules of the library allocate through these functions, so the number of
+// live bytes and allocations can be queried at runtime (e.g. to check that a long sweep runs in bounded memory).
+// Memory of memory_allocate* must be released with memory_free (not free). All functions are thread-safe.
+
+struct memory_statistics {
+    size_t live;        // bytes currently allocated
+    size_t peak;        // maximum of 'live' since the start (or the last memory_reset_peak)
+    size_t allocations; // number of allocations (including reallocations)
+    size_t frees;
+};
+
+void* memory_allocate(size_t bytes);
+void* memory_allocate_zeroed(size_t count, size_t size);
+void* memory_reallocate(void* memory, size_t bytes);
+// 'alignment' is a power of two of at least 16
+void* memory_allocate_aligned(size_t alignment, size_t bytes);
+void memory_free(void* memory);
+
+// allocations per evaluation: difference of 'allocations' before and after a number of evaluations
+void memory_get_statistics(struct memory_statistics* statistics);
+void memory_reset_peak(void);
+
+#endif /* PLL_MEMORY_H */
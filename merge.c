@@ -0,0 +1,36 @@
+#include <stdio.h>
+
+#include "summary.h"
+
+// combine the summaries of several sweep shards into one
+// usage: merge SHARD1 [SHARD2 ...] (the merged summary is written to stdout)
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s SHARD1 [SHARD2 ...]\n", argv[0]);
+        return 1;
+    }
+    struct summary* merged = summary_create();
+    for(int i = 1; i < argc; ++i)
+    {
+        struct summary* summary = summary_read(argv[i]);
+        if(!summary)
+        {
+            summary_destroy(merged);
+            return 1;
+        }
+        summary_merge(merged, summary);
+        summary_destroy(summary);
+    }
+    summary_write_to(merged, stdout);
+
+    struct sweep_record best;
+    if(summary_get_best(merged, &best))
+    {
+        fprintf(stderr, "best: index %zu, Rf = %.1f Ohm, Cf = %.1f pF, score = %g\n", best.index, best.variables[PLL_RF], best.variables[PLL_CF] / 1e-12, best.score);
+    }
+    fprintf(stderr, "%zu points evaluated, %zu Pareto points\n", summary_get_evaluated(merged), summary_get_pareto_size(merged));
+    summary_destroy(merged);
+    return 0;
+}
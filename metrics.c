@@ -0,0 +1,328 @@
+#include "metrics.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+#define METRICS_MAGIC "STJBMC01"
+
+struct metrics {
+    size_t size;
+    size_t capacity;
+    size_t* index;
+    unsigned char* valid;
+    double* variables[PLL_NUM_VARIABLES];
+    double* columns[METRICS_NUM_COLUMNS][2];
+};
+
+struct metrics* metrics_create(void)
+{
+    struct metrics* metrics = memory_allocate_zeroed(1, sizeof(*metrics));
+    return metrics;
+}
+
+void metrics_destroy(struct metrics* metrics)
+{
+    memory_free(metrics->index);
+    memory_free(metrics->valid);
+    for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+    {
+        memory_free(metrics->variables[v]);
+    }
+    for(size_t c = 0; c < METRICS_NUM_COLUMNS; ++c)
+    {
+        memory_free(metrics->columns[c][0]);
+        memory_free(metrics->columns[c][1]);
+    }
+    memory_free(metrics);
+}
+
+static void _reserve(struct metrics* metrics, size_t capacity)
+{
+    if(capacity <= metrics->capacity)
+    {
+        return;
+    }
+    metrics->index = memory_reallocate(metrics->index, capacity * sizeof(*metrics->index));
+    metrics->valid = memory_reallocate(metrics->valid, capacity * sizeof(*metrics->valid));
+    for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+    {
+        metrics->variables[v] = memory_reallocate(metrics->variables[v], capacity * sizeof(double));
+    }
+    for(size_t c = 0; c < METRICS_NUM_COLUMNS; ++c)
+    {
+        metrics->columns[c][0] = memory_reallocate(metrics->columns[c][0], capacity * sizeof(double));
+        metrics->columns[c][1] = memory_reallocate(metrics->columns[c][1], capacity * sizeof(double));
+    }
+    metrics->capacity = capacity;
+}
+
+void metrics_add(struct metrics* metrics, const struct sweep_record* record)
+{
+    if(metrics->size == metrics->capacity)
+    {
+        _reserve(metrics, metrics->capacity > 0 ? 2 * metrics->capacity : 256);
+    }
+    size_t row = metrics->size;
+    metrics->index[row] = record->index;
+    metrics->valid[row] = record->valid ? 1 : 0;
+    for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+    {
+        metrics->variables[v][row] = record->variables[v];
+    }
+    const struct pll_results* results = &record->results;
+    for(size_t corner = 0; corner < 2; ++corner)
+    {
+        metrics->columns[METRICS_JRMS][corner][row] = results->Jrms[corner];
+        metrics->columns[METRICS_JRMS_VCO][corner][row] = results->Jrms_vco[corner];
+        metrics->columns[METRICS_JRMS_REF][corner][row] = results->Jrms_ref[corner];
+        metrics->columns[METRICS_JRMS_CP][corner][row] = results->Jrms_cp[corner];
+        metrics->columns[METRICS_JRMS_FILTER][corner][row] = results->Jrms_filter[corner];
+        metrics->columns[METRICS_UNITY_GAIN_FREQUENCY][corner][row] = results->f0dB[corner];
+        metrics->columns[METRICS_PHASEMARGIN][corner][row] = results->phasemargin[corner];
+        metrics->columns[METRICS_BANDWIDTH][corner][row] = results->fbw[corner];
+    }
+    ++metrics->size;
+}
+
+int metrics_writer(const struct sweep_record* record, void* metrics)
+{
+    metrics_add(metrics, record);
+    return 1;
+}
+
+size_t metrics_get_size(const struct metrics* metrics)
+{
+    return metrics->size;
+}
+
+const size_t* metrics_get_index(const struct metrics* metrics)
+{
+    return metrics->index;
+}
+
+const double* metrics_get_variable(const struct metrics* metrics, enum pll_variable variable)
+{
+    return metrics->variables[variable];
+}
+
+const double* metrics_get_column(const struct metrics* metrics, enum metrics_column column, size_t corner)
+{
+    return metrics->columns[column][corner];
+}
+
+void metrics_score(const struct metrics* metrics, evaluator eval, double* scores)
+{
+    const double* phasemargin = metrics->columns[METRICS_PHASEMARGIN][0];
+    const double* fbw = metrics->columns[METRICS_BANDWIDTH][0];
+    const double* Jrms = metrics->columns[METRICS_JRMS][0];
+    for(size_t row = 0; row < metrics->size; ++row)
+    {
+        scores[row] = metrics->valid[row] ? eval(phasemargin[row], fbw[row], Jrms[row]) : INFINITY;
+    }
+}
+
+static int _passes(const struct metrics* metrics, size_t row, const struct metrics_constraint* constraints, size_t numconstraints)
+{
+    if(!metrics->valid[row])
+    {
+        return 0;
+    }
+    for(size_t i = 0; i < numconstraints; ++i)
+    {
+        double value = metrics->columns[constraints[i].column][constraints[i].corner][row];
+        // NaN (undetermined metric) never passes
+        if(!(value >= constraints[i].lower && value <= constraints[i].upper))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+size_t metrics_filter(const struct metrics* metrics, const struct metrics_constraint* constraints, size_t numconstraints, unsigned char* pass)
+{
+    size_t count = 0;
+    for(size_t row = 0; row < metrics->size; ++row)
+    {
+        pass[row] = _passes(metrics, row, constraints, numconstraints);
+        count += pass[row];
+    }
+    return count;
+}
+
+// a NaN score can not be compared, so such a row is never the best one
+static int _better(const struct metrics* metrics, size_t row, double score, size_t best, double bestscore)
+{
+    if(isnan(score))
+    {
+        return 0;
+    }
+    return best == metrics->size || score < bestscore || (score == bestscore && metrics->index[row] < metrics->index[best]);
+}
+
+size_t metrics_best(const struct metrics* metrics, evaluator eval, const struct metrics_constraint* constraints, size_t numconstraints, double* score)
+{
+    const double* phasemargin = metrics->columns[METRICS_PHASEMARGIN][0];
+    const double* fbw = metrics->columns[METRICS_BANDWIDTH][0];
+    const double* Jrms = metrics->columns[METRICS_JRMS][0];
+    size_t best = metrics->size;
+    double bestscore = INFINITY;
+    for(size_t row = 0; row < metrics->size; ++row)
+    {
+        if(!_passes(metrics, row, constraints, numconstraints))
+        {
+            continue;
+        }
+        double s = eval(phasemargin[row], fbw[row], Jrms[row]);
+        if(_better(metrics, row, s, best, bestscore))
+        {
+            best = row;
+            bestscore = s;
+        }
+    }
+    if(score)
+    {
+        *score = bestscore;
+    }
+    return best;
+}
+
+size_t metrics_best_expression(const struct metrics* metrics, const struct expression* expression, const struct metrics_constraint* constraints, size_t numconstraints, double* score)
+{
+    // column of every symbol, only the referenced ones are loaded per row
+    const double* sources[EXPRESSION_NUM_SYMBOLS] = {
+        [EXPRESSION_PHASEMARGIN] = metrics->columns[METRICS_PHASEMARGIN][0],
+        [EXPRESSION_F0DB] = metrics->columns[METRICS_UNITY_GAIN_FREQUENCY][0],
+        [EXPRESSION_BANDWIDTH] = metrics->columns[METRICS_BANDWIDTH][0],
+        [EXPRESSION_JRMS] = metrics->columns[METRICS_JRMS][0],
+        [EXPRESSION_JRMS_VCO] = metrics->columns[METRICS_JRMS_VCO][0],
+        [EXPRESSION_JRMS_REF] = metrics->columns[METRICS_JRMS_REF][0],
+        [EXPRESSION_JRMS_CP] = metrics->columns[METRICS_JRMS_CP][0],
+        [EXPRESSION_JRMS_FILTER] = metrics->columns[METRICS_JRMS_FILTER][0],
+        [EXPRESSION_RF] = metrics->variables[PLL_RF],
+        [EXPRESSION_CF] = metrics->variables[PLL_CF],
+        [EXPRESSION_CFX] = metrics->variables[PLL_CFX],
+        [EXPRESSION_GM] = metrics->variables[PLL_GM],
+    };
+    unsigned int references = expression_get_references(expression);
+    size_t loads[EXPRESSION_NUM_SYMBOLS];
+    size_t numloads = 0;
+    for(size_t i = 0; i < EXPRESSION_NUM_SYMBOLS; ++i)
+    {
+        if(references & (1u << i))
+        {
+            loads[numloads++] = i;
+        }
+    }
+    double values[EXPRESSION_NUM_SYMBOLS];
+    size_t best = metrics->size;
+    double bestscore = INFINITY;
+    for(size_t row = 0; row < metrics->size; ++row)
+    {
+        if(!_passes(metrics, row, constraints, numconstraints))
+        {
+            continue;
+        }
+        for(size_t i = 0; i < numloads; ++i)
+        {
+            values[loads[i]] = sources[loads[i]][row];
+        }
+        double s = expression_evaluate(expression, values);
+        if(_better(metrics, row, s, best, bestscore))
+        {
+            best = row;
+            bestscore = s;
+        }
+    }
+    if(score)
+    {
+        *score = bestscore;
+    }
+    return best;
+}
+
+int metrics_write(const struct metrics* metrics, const char* filename, uint64_t confighash)
+{
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    uint64_t header[4] = { confighash, metrics->size, PLL_NUM_VARIABLES, METRICS_NUM_COLUMNS };
+    size_t size = metrics->size;
+    int ok = fwrite(METRICS_MAGIC, 8, 1, file) == 1;
+    ok = ok && fwrite(header, sizeof(header), 1, file) == 1;
+    for(size_t row = 0; ok && row < size; ++row)
+    {
+        uint64_t index = metrics->index[row];
+        ok = fwrite(&index, sizeof(index), 1, file) == 1;
+    }
+    ok = ok && fwrite(metrics->valid, 1, size, file) == size;
+    for(size_t v = 0; ok && v < PLL_NUM_VARIABLES; ++v)
+    {
+        ok = fwrite(metrics->variables[v], sizeof(double), size, file) == size;
+    }
+    for(size_t c = 0; ok && c < METRICS_NUM_COLUMNS; ++c)
+    {
+        ok = fwrite(metrics->columns[c][0], sizeof(double), size, file) == size;
+        ok = ok && fwrite(metrics->columns[c][1], sizeof(double), size, file) == size;
+    }
+    fclose(file);
+    return ok;
+}
+
+struct metrics* metrics_read(const char* filename, uint64_t* confighash)
+{
+    FILE* file = fopen(filename, "rb");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for reading\n", filename);
+        return NULL;
+    }
+    char magic[8];
+    uint64_t header[4];
+    if(fread(magic, 8, 1, file) != 1 || memcmp(magic, METRICS_MAGIC, 8) != 0 || fread(header, sizeof(header), 1, file) != 1 || header[2] != PLL_NUM_VARIABLES || header[3] != METRICS_NUM_COLUMNS)
+    {
+        fprintf(stderr, "metrics_read: '%s' is not a metrics file\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    struct metrics* metrics = metrics_create();
+    size_t size = header[1];
+    _reserve(metrics, size > 0 ? size : 1);
+    int ok = 1;
+    for(size_t row = 0; ok && row < size; ++row)
+    {
+        uint64_t index;
+        ok = fread(&index, sizeof(index), 1, file) == 1;
+        metrics->index[row] = index;
+    }
+    ok = ok && fread(metrics->valid, 1, size, file) == size;
+    for(size_t v = 0; ok && v < PLL_NUM_VARIABLES; ++v)
+    {
+        ok = fread(metrics->variables[v], sizeof(double), size, file) == size;
+    }
+    for(size_t c = 0; ok && c < METRICS_NUM_COLUMNS; ++c)
+    {
+        ok = fread(metrics->columns[c][0], sizeof(double), size, file) == size;
+        ok = ok && fread(metrics->columns[c][1], sizeof(double), size, file) == size;
+    }
+    fclose(file);
+    if(!ok)
+    {
+        fprintf(stderr, "metrics_read: '%s' is truncated\n", filename);
+        metrics_destroy(metrics);
+        return NULL;
+    }
+    metrics->size = size;
+    if(confighash)
+    {
+        *confighash = header[0];
+    }
+    return metrics;
+}
@@ -0,0 +1,64 @@
+#ifndef PLL_METRICS_H
+#define PLL_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "expression.h"
+#include "pll.h"
+#include "sweep.h"
+
+// Column store of the raw metrics of a sweep (one row per evaluated point, one column per metric and corner).
+// The results of pll_calculate do not depend on the cost function, so a sweep only has to be run once:
+// any number of evaluators and constraint sets can afterwards be applied to the stored columns.
+// Rows are kept in the order they were added (completion order for pipelined sweeps), ties are resolved by the grid index.
+
+enum metrics_column {
+    METRICS_JRMS,
+    METRICS_JRMS_VCO,
+    METRICS_JRMS_REF,
+    METRICS_JRMS_CP,
+    METRICS_JRMS_FILTER,
+    METRICS_UNITY_GAIN_FREQUENCY,
+    METRICS_PHASEMARGIN,
+    METRICS_BANDWIDTH,
+    METRICS_NUM_COLUMNS
+};
+
+// lower <= value <= upper on one column (use -INFINITY/INFINITY for one-sided constraints)
+struct metrics_constraint {
+    enum metrics_column column;
+    size_t corner;
+    double lower;
+    double upper;
+};
+
+struct metrics;
+
+struct metrics* metrics_create(void);
+void metrics_destroy(struct metrics* metrics);
+// invalid records are stored as well (they never pass)
+void metrics_add(struct metrics* metrics, const struct sweep_record* record);
+// sweep_writer adapter, 'metrics' is a struct metrics*
+int metrics_writer(const struct sweep_record* record, void* metrics);
+
+size_t metrics_get_size(const struct metrics* metrics);
+const size_t* metrics_get_index(const struct metrics* metrics);
+const double* metrics_get_variable(const struct metrics* metrics, enum pll_variable variable);
+const double* metrics_get_column(const struct metrics* metrics, enum metrics_column column, size_t corner);
+
+// scores of all rows with 'eval' (minimum Kvco corner, like pll_get_score), invalid rows get INFINITY
+void metrics_score(const struct metrics* metrics, evaluator eval, double* scores);
+// marks the rows that are valid and fulfill all constraints (pass[row] = 1), returns the number of passing rows
+size_t metrics_filter(const struct metrics* metrics, const struct metrics_constraint* constraints, size_t numconstraints, unsigned char* pass);
+// best (lowest score, lowest grid index on ties) row that fulfills all constraints (constraints may be NULL),
+// rows with a NaN score are skipped, returns the row or metrics_get_size() if no row passes
+size_t metrics_best(const struct metrics* metrics, evaluator eval, const struct metrics_constraint* constraints, size_t numconstraints, double* score);
+// same as metrics_best with a cost expression, which can use all metrics (minimum Kvco corner) and design variables
+size_t metrics_best_expression(const struct metrics* metrics, const struct expression* expression, const struct metrics_constraint* constraints, size_t numconstraints, double* score);
+
+// binary file (columns stored contiguously), 'confighash' identifies the configuration (see pll_get_configuration_hash)
+int metrics_write(const struct metrics* metrics, const char* filename, uint64_t confighash);
+struct metrics* metrics_read(const char* filename, uint64_t* confighash);
+
+#endif /* PLL_METRICS_H */
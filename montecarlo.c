@@ -0,0 +1,332 @@
+#include "montecarlo.h"
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "batch.h"
+#include "constants.h"
+#include "memory.h"
+#include "pll_internal.h"
+
+#define MONTECARLO_CHUNK 256
+
+struct montecarlo {
+    enum montecarlo_distribution distributions[MONTECARLO_NUM_PARAMETERS];
+    double tolerances[MONTECARLO_NUM_PARAMETERS];
+    uint64_t seed;
+    unsigned int numthreads;
+    double threshold;
+    double lower[MONTECARLO_NUM_METRICS];
+    double upper[MONTECARLO_NUM_METRICS];
+
+    size_t numsamples;
+    size_t passed;
+    double* metrics[MONTECARLO_NUM_METRICS]; // sorted after the run
+};
+
+struct montecarlo* montecarlo_create(void)
+{
+    struct montecarlo* montecarlo = memory_allocate_zeroed(1, sizeof(*montecarlo));
+    montecarlo->seed = 1;
+    montecarlo->numthreads = 1;
+    montecarlo->threshold = DBL_MAX;
+    for(size_t m = 0; m < MONTECARLO_NUM_METRICS; ++m)
+    {
+        montecarlo->lower[m] = -INFINITY;
+        montecarlo->upper[m] = INFINITY;
+    }
+    return montecarlo;
+}
+
+void montecarlo_destroy(struct montecarlo* montecarlo)
+{
+    for(size_t m = 0; m < MONTECARLO_NUM_METRICS; ++m)
+    {
+        memory_free(montecarlo->metrics[m]);
+    }
+    memory_free(montecarlo);
+}
+
+void montecarlo_set_distribution(struct montecarlo* montecarlo, enum montecarlo_parameter parameter, enum montecarlo_distribution distribution, double tolerance)
+{
+    montecarlo->distributions[parameter] = distribution;
+    montecarlo->tolerances[parameter] = tolerance;
+}
+
+void montecarlo_set_seed(struct montecarlo* montecarlo, uint64_t seed)
+{
+    montecarlo->seed = seed;
+}
+
+void montecarlo_set_threads(struct montecarlo* montecarlo, unsigned int numthreads)
+{
+    montecarlo->numthreads = numthreads > 0 ? numthreads : 1;
+}
+
+void montecarlo_set_threshold(struct montecarlo* montecarlo, double threshold)
+{
+    montecarlo->threshold = threshold;
+}
+
+void montecarlo_set_limits(struct montecarlo* montecarlo, enum montecarlo_metric metric, double lower, double upper)
+{
+    montecarlo->lower[metric] = lower;
+    montecarlo->upper[metric] = upper;
+}
+
+// metrics of one corner within their limits (metrics without a limit may be NaN)
+static int _within_limits(const struct montecarlo* montecarlo, const double* values)
+{
+    for(size_t m = 0; m < MONTECARLO_NUM_METRICS; ++m)
+    {
+        int limited = montecarlo->lower[m] > -INFINITY || montecarlo->upper[m] < INFINITY;
+        if(limited && !(values[m] >= montecarlo->lower[m] && values[m] <= montecarlo->upper[m]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// worse of the two Kvco corners, NaN if either corner is undetermined (fmin/fmax would drop it)
+static double _worst(double lhs, double rhs, double (*pick)(double, double))
+{
+    return isnan(lhs) || isnan(rhs) ? NAN : pick(lhs, rhs);
+}
+
+/*
+ * Counter-based random numbers: the output is a pure function of (seed, sample, stream),
+ * computed with the splitmix64 finalizer applied to the combined counter.
+ */
+
+static uint64_t _mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// uniform in (0, 1)
+static double _uniform(uint64_t seed, uint64_t sample, uint64_t stream)
+{
+    uint64_t x = _mix(_mix(seed + 0x9e3779b97f4a7c15ULL * (stream + 1)) ^ sample);
+    return ((x >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+static double _normal(uint64_t seed, uint64_t sample, uint64_t stream)
+{
+    // Box-Muller, every parameter uses two streams
+    double u1 = _uniform(seed, sample, 2 * stream);
+    double u2 = _uniform(seed, sample, 2 * stream + 1);
+    return sqrt(-2 * log(u1)) * cos(2 * CONSTANTS_PI * u2);
+}
+
+double montecarlo_get_sample(const struct montecarlo* montecarlo, double nominal, enum montecarlo_parameter parameter, size_t sample)
+{
+    double tolerance = montecarlo->tolerances[parameter];
+    switch(montecarlo->distributions[parameter])
+    {
+        case MONTECARLO_UNIFORM:
+            return nominal * (1 + tolerance * (2 * _uniform(montecarlo->seed, sample, 2 * parameter) - 1));
+        case MONTECARLO_NORMAL:
+            return nominal * (1 + tolerance * _normal(montecarlo->seed, sample, parameter));
+        case MONTECARLO_LOGNORMAL:
+            return nominal * exp(tolerance * _normal(montecarlo->seed, sample, parameter));
+        case MONTECARLO_FIXED:
+        default:
+            return nominal;
+    }
+}
+
+/*
+ * Evaluation
+ */
+
+struct job {
+    struct montecarlo* montecarlo;
+    const struct pll_state* state;
+    evaluator eval;
+    atomic_size_t next;
+    atomic_size_t passed;
+};
+
+static void _evaluate_chunk(struct job* job, size_t first, size_t count)
+{
+    struct montecarlo* montecarlo = job->montecarlo;
+    const struct pll_state* state = job->state;
+    double values[MONTECARLO_NUM_PARAMETERS][MONTECARLO_CHUNK];
+    double nominal[MONTECARLO_NUM_PARAMETERS] = {
+        state->Rf, state->Cf, state->Cfx, state->gm, 1.0, state->detectorgain
+    };
+    // Kvco is drawn as relative factor and applied to both corners
+    for(size_t p = 0; p < MONTECARLO_NUM_PARAMETERS; ++p)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            values[p][i] = montecarlo_get_sample(montecarlo, nominal[p], p, first + i);
+        }
+    }
+    double Kvco[MONTECARLO_CHUNK];
+    double phasemargin[2][MONTECARLO_CHUNK];
+    double f0dB[2][MONTECARLO_CHUNK];
+    double fbw[2][MONTECARLO_CHUNK];
+    double Jrms[2][MONTECARLO_CHUNK];
+    struct batch_input input = {
+        values[MONTECARLO_RF], values[MONTECARLO_CF], values[MONTECARLO_CFX], values[MONTECARLO_GM], Kvco, values[MONTECARLO_DETECTORGAIN]
+    };
+    for(size_t corner = 0; corner < 2; ++corner)
+    {
+        double cornerKvco = corner == 0 ? state->min_Kvco : state->max_Kvco;
+        for(size_t i = 0; i < count; ++i)
+        {
+            Kvco[i] = cornerKvco * values[MONTECARLO_KVCO][i];
+        }
+        struct batch_output output = { phasemargin[corner], f0dB[corner], fbw[corner], Jrms[corner] };
+        batch_calculate(state, &input, &output, count, corner);
+    }
+    size_t passed = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        int pass = 1;
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            // NaN metrics (no crossing) never pass
+            double score = job->eval ? job->eval(phasemargin[corner][i], fbw[corner][i], Jrms[corner][i]) : 0.0;
+            double values[MONTECARLO_NUM_METRICS] = { phasemargin[corner][i], f0dB[corner][i], fbw[corner][i], Jrms[corner][i] };
+            if(!(score < montecarlo->threshold) || isnan(phasemargin[corner][i]) || !_within_limits(montecarlo, values))
+            {
+                pass = 0;
+            }
+        }
+        passed += pass;
+        size_t idx = first + i;
+        montecarlo->metrics[MONTECARLO_PHASEMARGIN][idx] = _worst(phasemargin[0][i], phasemargin[1][i], fmin);
+        montecarlo->metrics[MONTECARLO_UNITY_GAIN_FREQUENCY][idx] = _worst(f0dB[0][i], f0dB[1][i], fmin);
+        montecarlo->metrics[MONTECARLO_BANDWIDTH][idx] = _worst(fbw[0][i], fbw[1][i], fmax);
+        montecarlo->metrics[MONTECARLO_JRMS][idx] = _worst(Jrms[0][i], Jrms[1][i], fmax);
+    }
+    atomic_fetch_add(&job->passed, passed);
+}
+
+static void* _worker(void* arg)
+{
+    struct job* job = arg;
+    size_t numsamples = job->montecarlo->numsamples;
+    while(1)
+    {
+        size_t first = atomic_fetch_add(&job->next, MONTECARLO_CHUNK);
+        if(first >= numsamples)
+        {
+            break;
+        }
+        size_t count = numsamples - first < MONTECARLO_CHUNK ? numsamples - first : MONTECARLO_CHUNK;
+        _evaluate_chunk(job, first, count);
+    }
+    return NULL;
+}
+
+static int _compare_double(const void* lhs, const void* rhs)
+{
+    double a = *(const double*)lhs;
+    double b = *(const double*)rhs;
+    // NaN sorts last
+    if(isnan(a) || isnan(b))
+    {
+        return isnan(a) - isnan(b);
+    }
+    return (a > b) - (a < b);
+}
+
+int montecarlo_run(struct montecarlo* montecarlo, const struct pll_state* state, evaluator eval, size_t numsamples)
+{
+    if(!state->context || numsamples == 0)
+    {
+        return 0;
+    }
+    montecarlo->numsamples = numsamples;
+    for(size_t m = 0; m < MONTECARLO_NUM_METRICS; ++m)
+    {
+        memory_free(montecarlo->metrics[m]);
+        montecarlo->metrics[m] = memory_allocate(numsamples * sizeof(*montecarlo->metrics[m]));
+    }
+    struct job job;
+    job.montecarlo = montecarlo;
+    job.state = state;
+    job.eval = eval;
+    atomic_init(&job.next, 0);
+    atomic_init(&job.passed, 0);
+    // the state is only read (batch_calculate), so all workers share it
+    pthread_t* threads = memory_allocate(montecarlo->numthreads * sizeof(*threads));
+    for(unsigned int i = 1; i < montecarlo->numthreads; ++i)
+    {
+        pthread_create(&threads[i], NULL, _worker, &job);
+    }
+    _worker(&job);
+    for(unsigned int i = 1; i < montecarlo->numthreads; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    memory_free(threads);
+    montecarlo->passed = atomic_load(&job.passed);
+    for(size_t m = 0; m < MONTECARLO_NUM_METRICS; ++m)
+    {
+        qsort(montecarlo->metrics[m], numsamples, sizeof(double), _compare_double);
+    }
+    return 1;
+}
+
+size_t montecarlo_get_samples(const struct montecarlo* montecarlo)
+{
+    return montecarlo->numsamples;
+}
+
+size_t montecarlo_get_passed(const struct montecarlo* montecarlo)
+{
+    return montecarlo->passed;
+}
+
+double montecarlo_get_yield(const struct montecarlo* montecarlo)
+{
+    if(montecarlo->numsamples == 0)
+    {
+        return 0.0;
+    }
+    return (double)montecarlo->passed / montecarlo->numsamples;
+}
+
+double montecarlo_get_yield_error(const struct montecarlo* montecarlo)
+{
+    if(montecarlo->numsamples == 0)
+    {
+        return 0.0;
+    }
+    double yield = montecarlo_get_yield(montecarlo);
+    return sqrt(yield * (1 - yield) / montecarlo->numsamples);
+}
+
+double montecarlo_get_percentile(const struct montecarlo* montecarlo, enum montecarlo_metric metric, double percentile)
+{
+    if(montecarlo->numsamples == 0)
+    {
+        return NAN;
+    }
+    const double* values = montecarlo->metrics[metric];
+    double position = percentile / 100 * (montecarlo->numsamples - 1);
+    if(position <= 0)
+    {
+        return values[0];
+    }
+    size_t idx = (size_t)position;
+    if(idx >= montecarlo->numsamples - 1)
+    {
+        return values[montecarlo->numsamples - 1];
+    }
+    double frac = position - idx;
+    return values[idx] + frac * (values[idx + 1] - values[idx]);
+}
@@ -0,0 +1,65 @@
+#ifndef PLL_MONTECARLO_H
+#define PLL_MONTECARLO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pll.h"
+
+// Monte Carlo yield analysis around the nominal design of an initialized pll_state.
+// Every sample draws its variations from a counter-based random stream (seed, sample index, parameter),
+// so the results do not depend on the number of threads or the order of evaluation.
+// Samples are evaluated with the batched evaluator (both Kvco corners) and pass if both corners meet the metric limits
+// and their score is below the threshold.
+
+enum montecarlo_parameter {
+    MONTECARLO_RF,
+    MONTECARLO_CF,
+    MONTECARLO_CFX,
+    MONTECARLO_GM,
+    MONTECARLO_KVCO,
+    MONTECARLO_DETECTORGAIN,
+    MONTECARLO_NUM_PARAMETERS
+};
+
+enum montecarlo_distribution {
+    MONTECARLO_FIXED, // no variation
+    MONTECARLO_UNIFORM, // nominal * (1 + u), u in [-tolerance, tolerance]
+    MONTECARLO_NORMAL, // nominal * (1 + tolerance * n), n standard normal
+    MONTECARLO_LOGNORMAL // nominal * exp(tolerance * n)
+};
+
+// worst value of both Kvco corners, NaN if either corner is undetermined
+enum montecarlo_metric {
+    MONTECARLO_PHASEMARGIN, // minimum
+    MONTECARLO_UNITY_GAIN_FREQUENCY, // minimum
+    MONTECARLO_BANDWIDTH, // maximum
+    MONTECARLO_JRMS, // maximum
+    MONTECARLO_NUM_METRICS
+};
+
+struct montecarlo;
+
+struct montecarlo* montecarlo_create(void);
+void montecarlo_destroy(struct montecarlo* montecarlo);
+void montecarlo_set_distribution(struct montecarlo* montecarlo, enum montecarlo_parameter parameter, enum montecarlo_distribution distribution, double tolerance);
+void montecarlo_set_seed(struct montecarlo* montecarlo, uint64_t seed);
+void montecarlo_set_threads(struct montecarlo* montecarlo, unsigned int numthreads);
+// a sample passes if its score is below 'threshold' (default: DBL_MAX, the fail value of the evaluators)
+void montecarlo_set_threshold(struct montecarlo* montecarlo, double threshold);
+// a sample passes if the metric of both corners lies within [lower, upper] (default: no limit, +-INFINITY),
+// an undetermined (NaN) metric fails a limited metric; independent of the cost function
+void montecarlo_set_limits(struct montecarlo* montecarlo, enum montecarlo_metric metric, double lower, double upper);
+int montecarlo_run(struct montecarlo* montecarlo, const struct pll_state* state, evaluator eval, size_t numsamples);
+
+size_t montecarlo_get_samples(const struct montecarlo* montecarlo);
+size_t montecarlo_get_passed(const struct montecarlo* montecarlo);
+double montecarlo_get_yield(const struct montecarlo* montecarlo);
+// standard error of the yield estimate (binomial)
+double montecarlo_get_yield_error(const struct montecarlo* montecarlo);
+// 'percentile' in [0, 100], linear interpolation between the sorted samples
+double montecarlo_get_percentile(const struct montecarlo* montecarlo, enum montecarlo_metric metric, double percentile);
+// value of one parameter of one sample (reproduces the draw of the run)
+double montecarlo_get_sample(const struct montecarlo* montecarlo, double nominal, enum montecarlo_parameter parameter, size_t sample);
+
+#endif /* PLL_MONTECARLO_H */
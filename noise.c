@@ -1,3 +1,5 @@
+#include "noise.h"
+
 #include <math.h>
 
 #include "vector.h"
@@ -97,6 +99,110 @@ double noise_trapzS(struct vector* f, struct vector* S)
     return A;
 }
 
+// area of one log-log interpolated segment [flower, fupper] (values Slower, Supper), restricted to [a, b] within the segment
+// (with a = flower and b = fupper this is exactly the summand of noise_trapzS)
+double noise_segment_area(double flower, double fupper, double Slower, double Supper, double a, double b)
+{
+    double m = log(Supper / Slower) / log(fupper / flower);
+    if(fabs(m + 1) < 1e-12)
+    {
+        return 0.5 * Slower * flower * log(b / a);
+    }
+    return 0.5 * Slower / (m + 1) * flower * (pow(b / flower, (m + 1)) - pow(a / flower, (m + 1)));
+}
+
+// first index i with f[i] >= value (f is sorted ascending)
+static size_t _lower_bound(struct vector* f, double value)
+{
+    size_t low = 0;
+    size_t high = vector_size(f);
+    while(low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if(creal(vector_get(f, mid)) < value)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// same as noise_trapzS, but only over the band [flower, fupper] (clipped to the range of f)
+// the segments containing the band edges are integrated partially along the interpolated curve
+double noise_trapzS_band(struct vector* f, struct vector* S, double flower, double fupper)
+{
+    size_t size = vector_size(f);
+    double fmin = creal(vector_get(f, 0));
+    double fmax = creal(vector_get(f, size - 1));
+    flower = flower < fmin ? fmin : flower;
+    fupper = fupper > fmax ? fmax : fupper;
+    if(fupper <= flower)
+    {
+        return 0.0;
+    }
+    // grid points inside the band: [first, last)
+    size_t first = _lower_bound(f, flower);
+    size_t last = _lower_bound(f, fupper);
+    if(last < size && creal(vector_get(f, last)) == fupper)
+    {
+        ++last;
+    }
+    if(last <= first)
+    {
+        // band lies within one segment
+        size_t i = first - 1;
+        return noise_segment_area(creal(vector_get(f, i)), creal(vector_get(f, i + 1)), creal(vector_get(S, i)), creal(vector_get(S, i + 1)), flower, fupper);
+    }
+    double A = 0;
+    if(last - first > 1)
+    {
+        // interior grid points, views do not allocate
+        struct vector fview = vector_view(f, first, last - first);
+        struct vector Sview = vector_view(S, first, last - first);
+        A += noise_trapzS(&fview, &Sview);
+    }
+    if(first > 0 && creal(vector_get(f, first)) > flower)
+    {
+        size_t i = first - 1;
+        A += noise_segment_area(creal(vector_get(f, i)), creal(vector_get(f, i + 1)), creal(vector_get(S, i)), creal(vector_get(S, i + 1)), flower, creal(vector_get(f, first)));
+    }
+    if(last < size)
+    {
+        size_t i = last - 1;
+        A += noise_segment_area(creal(vector_get(f, i)), creal(vector_get(f, i + 1)), creal(vector_get(S, i)), creal(vector_get(S, i + 1)), creal(vector_get(f, i)), fupper);
+    }
+    return A;
+}
+
+// integrate several bands in one pass over the data, 'areas' receives one value per band
+void noise_trapzS_bands(struct vector* f, struct vector* S, const struct noise_band* bands, size_t numbands, double* areas)
+{
+    for(size_t j = 0; j < numbands; ++j)
+    {
+        areas[j] = 0;
+    }
+    for(size_t i = 0; i < vector_size(f) - 1; ++i)
+    {
+        double flower = creal(vector_get(f, i));
+        double fupper = creal(vector_get(f, i + 1));
+        double Slower = creal(vector_get(S, i));
+        double Supper = creal(vector_get(S, i + 1));
+        for(size_t j = 0; j < numbands; ++j)
+        {
+            double a = bands[j].flower > flower ? bands[j].flower : flower;
+            double b = bands[j].fupper < fupper ? bands[j].fupper : fupper;
+            if(b > a)
+            {
+                areas[j] += noise_segment_area(flower, fupper, Slower, Supper, a, b);
+            }
+        }
+    }
+}
+
 // this function yields the same results as RMSjitterL, but operates on linear data
 // the interpolation is still done on the logarithmic data
 // the calculation was optimized so it looks a little different
@@ -107,6 +213,18 @@ double noise_RMSjitterS(double f0, struct vector* f, struct vector* S)
     return J;
 }
 
+double noise_RMSjitterS_band(double f0, struct vector* f, struct vector* S, double flower, double fupper)
+{
+    double A = noise_trapzS_band(f, S, flower, fupper);
+    double J = sqrt(2 * A) / (2 * CONSTANTS_PI * f0);
+    return J;
+}
+
+double noise_area_to_RMSjitter(double f0, double A)
+{
+    return sqrt(2 * A) / (2 * CONSTANTS_PI * f0);
+}
+
 /*
 function M.trapz(x, y)
     local sum = 0
@@ -3,13 +3,26 @@
 
 #include "vector.h"
 
-struct vector* noise_PSD_constant(struct vector* S, struct vector* f, double S0);
-struct vector* noise_PSD_white_flicker(struct vector* S, struct vector* f, double Sfloor, double fc);
-struct vector* noise_PSD_10dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
-struct vector* noise_PSD_20dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
-struct vector* noise_PSD_30dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
+void noise_PSD_constant(struct vector* S, struct vector* f, double S0);
+void noise_PSD_white_flicker(struct vector* S, struct vector* f, double Sfloor, double fc);
+void noise_PSD_10dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
+void noise_PSD_20dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
+void noise_PSD_30dB_per_decade(struct vector* S, struct vector* f, double df0, double S0);
 double noise_L_to_S(double L);
 double noise_trapzS(struct vector* f, struct vector* S);
 double noise_RMSjitterS(double f0, struct vector* f, struct vector* S);
 
+// integration band (e.g. 10 kHz - 100 MHz of a jitter specification)
+struct noise_band {
+    double flower;
+    double fupper;
+};
+
+// area of one log-log interpolated segment [flower, fupper] (values Slower, Supper) restricted to [a, b] within the segment
+double noise_segment_area(double flower, double fupper, double Slower, double Supper, double a, double b);
+double noise_trapzS_band(struct vector* f, struct vector* S, double flower, double fupper);
+void noise_trapzS_bands(struct vector* f, struct vector* S, const struct noise_band* bands, size_t numbands, double* areas);
+double noise_RMSjitterS_band(double f0, struct vector* f, struct vector* S, double flower, double fupper);
+double noise_area_to_RMSjitter(double f0, double A);
+
 #endif /* PLL_NOISE */
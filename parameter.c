@@ -1,38 +1,205 @@
 #include "parameter.h"
 
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
 
 struct parameter {
     double start;
     double end;
     double step;
     double current;
+    // discrete axis (NULL for a continuous one)
+    double* values;
+    size_t count;
+    size_t position;
+};
+
+// E24 in two significant digits (E12 and E6 are every second and fourth value), it does not follow the rounded geometric
+// series like E48 and above
+static const unsigned int e24[24] = {
+    10, 11, 12, 13, 15, 16, 18, 20, 22, 24, 27, 30, 33, 36, 39, 43, 47, 51, 56, 62, 68, 75, 82, 91
 };
 
+// mantissa of the i-th value of a series and its number of significant digits
+static unsigned int _mantissa(enum parameter_series series, size_t i, int* digits)
+{
+    if(series <= PARAMETER_E24)
+    {
+        *digits = 2;
+        return e24[i * (PARAMETER_E24 / series)];
+    }
+    *digits = 3;
+    unsigned int mantissa = (unsigned int)floor(100 * pow(10, (double)i / series) + 0.5);
+    // the only value of the standard that deviates from the rounded series
+    return mantissa == 919 ? 920 : mantissa;
+}
+
 struct parameter* parameter_create(double start, double end, double step)
 {
-    struct parameter* parameter = malloc(sizeof(*parameter));
+    struct parameter* parameter = memory_allocate(sizeof(*parameter));
     parameter->start = start;
     parameter->end = end;
     parameter->step = step;
     parameter->current = start;
+    parameter->values = NULL;
+    parameter->count = 0;
+    parameter->position = 0;
     return parameter;
 }
 
+struct parameter* parameter_create_series(enum parameter_series series, double start, double end)
+{
+    if(start <= 0 || end < start)
+    {
+        return NULL;
+    }
+    int first = (int)floor(log10(start)) - 1;
+    int last = (int)floor(log10(end)) + 1;
+    size_t capacity = (size_t)(last - first + 1) * series;
+    double* values = memory_allocate(capacity * sizeof(*values));
+    size_t count = 0;
+    for(int decade = first; decade <= last; ++decade)
+    {
+        for(size_t i = 0; i < (size_t)series; ++i)
+        {
+            int digits;
+            unsigned int mantissa = _mantissa(series, i, &digits);
+            // dividing by an exact power of ten gives the double nearest to the decimal value
+            int exponent = decade - (digits - 1);
+            double value = exponent < 0 ? mantissa / pow(10, -exponent) : mantissa * pow(10, exponent);
+            if(value >= start * (1 - 1e-9) && value <= end * (1 + 1e-9))
+            {
+                values[count++] = value;
+            }
+        }
+    }
+    if(count == 0)
+    {
+        memory_free(values);
+        return NULL;
+    }
+    struct parameter* parameter = parameter_create(values[0], values[count - 1], 0);
+    parameter->values = values;
+    parameter->count = count;
+    return parameter;
+}
+
+void parameter_destroy(struct parameter* parameter)
+{
+    memory_free(parameter->values);
+    memory_free(parameter);
+}
+
+int parameter_series_from_name(const char* name, enum parameter_series* series)
+{
+    static const enum parameter_series all[] = { PARAMETER_E6, PARAMETER_E12, PARAMETER_E24, PARAMETER_E48, PARAMETER_E96, PARAMETER_E192 };
+    if(name[0] != 'E' && name[0] != 'e')
+    {
+        return 0;
+    }
+    char* end;
+    unsigned long number = strtoul(name + 1, &end, 10);
+    for(size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i)
+    {
+        if(*end == '\0' && number == (unsigned long)all[i])
+        {
+            *series = all[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int parameter_finished(struct parameter* parameter)
 {
+    if(parameter->values)
+    {
+        return parameter->position >= parameter->count;
+    }
     return parameter->current > parameter->end;
 }
 
 void parameter_reset(struct parameter* parameter)
 {
     parameter->current = parameter->start;
+    parameter->position = 0;
 }
 
 double parameter_next(struct parameter* parameter)
 {
+    if(parameter->values)
+    {
+        return parameter->values[parameter->position++];
+    }
     double ret = parameter->current;
     parameter->current += parameter->step;
     return ret;
 }
 
+
+size_t parameter_get_count(const struct parameter* parameter)
+{
+    if(parameter->values)
+    {
+        return parameter->count;
+    }
+    // small tolerance so that accumulated rounding in 'end' does not drop the last point
+    return (size_t)floor((parameter->end - parameter->start) / parameter->step + 1e-9) + 1;
+}
+
+double parameter_get_value(const struct parameter* parameter, size_t idx)
+{
+    if(parameter->values)
+    {
+        return parameter->values[idx];
+    }
+    return parameter->start + idx * parameter->step;
+}
+
+size_t parameter_get_neighbors(const struct parameter* parameter, double value, size_t* indices)
+{
+    size_t count = parameter_get_count(parameter);
+    size_t upper;
+    if(parameter->values)
+    {
+        // first value that is not below 'value'
+        size_t lower = 0;
+        upper = count;
+        while(lower < upper)
+        {
+            size_t middle = lower + (upper - lower) / 2;
+            if(parameter->values[middle] < value)
+            {
+                lower = middle + 1;
+            }
+            else
+            {
+                upper = middle;
+            }
+        }
+    }
+    else
+    {
+        double position = (value - parameter->start) / parameter->step;
+        upper = position <= 0 ? 0 : position >= count - 1 ? count : (size_t)ceil(position - 1e-9);
+    }
+    if(upper == 0 || upper == count)
+    {
+        indices[0] = upper == 0 ? 0 : count - 1;
+        return 1;
+    }
+    for(size_t i = upper - 1; i <= upper; ++i)
+    {
+        if(fabs(parameter_get_value(parameter, i) - value) <= 1e-9 * fabs(value))
+        {
+            indices[0] = i;
+            return 1;
+        }
+    }
+    indices[0] = upper - 1;
+    indices[1] = upper;
+    return 2;
+}
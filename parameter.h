@@ -1,10 +1,33 @@
 #ifndef PLL_PARAMETER
 #define PLL_PARAMETER
 
+#include <stddef.h>
+
+// preferred number series (IEC 60063) of discrete components, the value is the number of values per decade
+enum parameter_series {
+    PARAMETER_E6 = 6,
+    PARAMETER_E12 = 12,
+    PARAMETER_E24 = 24,
+    PARAMETER_E48 = 48,
+    PARAMETER_E96 = 96,
+    PARAMETER_E192 = 192
+};
+
 struct parameter;
 struct parameter* parameter_create(double start, double end, double step);
+// discrete axis: the values of 'series' within [start, end] in increasing order (NULL if there is none)
+struct parameter* parameter_create_series(enum parameter_series series, double start, double end);
+void parameter_destroy(struct parameter* parameter);
+// "E6" ... "E192", returns 0 for an unknown name
+int parameter_series_from_name(const char* name, enum parameter_series* series);
 double parameter_next(struct parameter* parameter);
 void parameter_reset(struct parameter* parameter);
 int parameter_finished(struct parameter* parameter);
+// random access (used by the sweep driver), values are start + idx * step or the idx-th series value
+size_t parameter_get_count(const struct parameter* parameter);
+double parameter_get_value(const struct parameter* parameter, size_t idx);
+// indices of the values next to 'value' (the largest value below and the smallest value above it) for rounding a
+// continuous optimum to the axis, returns the number of indices (1 if 'value' is on the axis or outside of its range)
+size_t parameter_get_neighbors(const struct parameter* parameter, double value, size_t* indices);
 
 #endif /* PLL_PARAMETER */
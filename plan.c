@@ -0,0 +1,279 @@
+#include "plan.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "constants.h"
+#include "memory.h"
+#include "noise.h"
+#include "pll_internal.h"
+#include "transfer.h"
+#include "vector.h"
+
+struct plan {
+    double* references;
+    size_t numreferences;
+    unsigned int maxN;
+    unsigned int maxM;
+    double minfrequency;
+    double ratio;
+
+    struct plan_result* results;
+    size_t numresults;
+    size_t* ranking;
+};
+
+struct plan* plan_create(void)
+{
+    struct plan* plan = memory_allocate_zeroed(1, sizeof(*plan));
+    plan->maxN = 8;
+    plan->maxM = 8;
+    plan->ratio = 0.1;
+    return plan;
+}
+
+void plan_destroy(struct plan* plan)
+{
+    memory_free(plan->references);
+    memory_free(plan->results);
+    memory_free(plan->ranking);
+    memory_free(plan);
+}
+
+void plan_add_reference(struct plan* plan, double fref)
+{
+    plan->references = memory_reallocate(plan->references, (plan->numreferences + 1) * sizeof(*plan->references));
+    plan->references[plan->numreferences] = fref;
+    ++plan->numreferences;
+}
+
+void plan_set_divider_range(struct plan* plan, unsigned int maxN, unsigned int maxM)
+{
+    plan->maxN = maxN > 0 ? maxN : 1;
+    plan->maxM = maxM > 0 ? maxM : 1;
+}
+
+void plan_set_min_detector_frequency(struct plan* plan, double frequency)
+{
+    plan->minfrequency = frequency;
+}
+
+void plan_set_bandwidth_ratio(struct plan* plan, double ratio)
+{
+    plan->ratio = ratio;
+}
+
+static void _enumerate(struct plan* plan, double fsig)
+{
+    memory_free(plan->results);
+    plan->results = NULL;
+    plan->numresults = 0;
+    for(size_t r = 0; r < plan->numreferences; ++r)
+    {
+        double fref = plan->references[r];
+        for(unsigned int M = 1; M <= plan->maxM; ++M)
+        {
+            if(fref / M < plan->minfrequency)
+            {
+                break;
+            }
+            for(unsigned int N = 1; N <= plan->maxN; ++N)
+            {
+                // remaining multiplication must be a positive integer
+                double multiple = fsig * M / (fref * N);
+                if(multiple < 1 - 1e-9 || fabs(multiple - round(multiple)) > 1e-9 * multiple)
+                {
+                    continue;
+                }
+                plan->results = memory_reallocate(plan->results, (plan->numresults + 1) * sizeof(*plan->results));
+                struct plan_result* result = &plan->results[plan->numresults];
+                result->fref = fref;
+                result->N = N;
+                result->M = M;
+                result->valid = 0;
+                result->score = INFINITY;
+                ++plan->numresults;
+            }
+        }
+    }
+}
+
+struct rank {
+    const struct plan_result* result;
+    size_t index;
+};
+
+static int _compare_rank(const void* lhs, const void* rhs)
+{
+    const struct plan_result* ra = ((const struct rank*)lhs)->result;
+    const struct plan_result* rb = ((const struct rank*)rhs)->result;
+    size_t a = ((const struct rank*)lhs)->index;
+    size_t b = ((const struct rank*)rhs)->index;
+    if(ra->valid != rb->valid)
+    {
+        return rb->valid - ra->valid;
+    }
+    if(ra->score != rb->score)
+    {
+        return ra->score < rb->score ? -1 : 1;
+    }
+    // ties are ranked in enumeration order
+    return (a > b) - (a < b);
+}
+
+// area under a PSD over the jitter integration band (see pll_calculate)
+static double _integrate(const struct pll_state* state, struct vector* S)
+{
+    if(state->jitterband.fupper > state->jitterband.flower)
+    {
+        return noise_trapzS_band(state->f, S, state->jitterband.flower, state->jitterband.fupper);
+    }
+    return noise_trapzS(state->f, S);
+}
+
+size_t plan_run(struct plan* plan, const struct pll_state* state, const struct parameter* Rf, const struct parameter* Cf, evaluator eval)
+{
+    _enumerate(plan, state->fsig);
+
+    const struct context* context = state->context;
+    size_t samples = context->samples;
+    struct vector* Hfilter = vector_create(samples, 0);
+    struct vector* Hfilter_denominator = vector_create(samples, 0);
+    struct vector* Hvco = vector_create(samples, 0);
+    struct vector* Hloop = vector_create(samples, 0);
+    struct vector* Stot = vector_create(samples, 0);
+    struct workspace* workspace = workspace_create(2 * samples * sizeof(double complex));
+    double* FV2 = memory_allocate(samples * sizeof(*FV2));
+    double* Hfilter2 = memory_allocate(samples * sizeof(*Hfilter2));
+    const double complex* loop = vector_data(Hloop);
+    const double complex* filter = vector_data(Hfilter);
+    const double complex* vco = vector_data(Hvco);
+    const double complex* Sref = vector_data(context->Sref);
+    const double complex* Svco = vector_data(context->Svco);
+    const double complex* Scp = vector_data(context->Scp);
+    const double complex* Sphasedetector = vector_data(context->Sphasedetector);
+    double complex* S = vector_data(Stot);
+    double g = state->detectorgain * state->gm;
+
+    // Hvco does not depend on the filter either (minimum Kvco, see pll_get_score)
+    vector_set_all(Hvco, 2 * CONSTANTS_PI * state->min_Kvco);
+    vector_divide(Hvco, state->s);
+
+    size_t numRf = parameter_get_count(Rf);
+    size_t numCf = parameter_get_count(Cf);
+    for(size_t i = 0; i < numCf; ++i)
+    {
+        for(size_t j = 0; j < numRf; ++j)
+        {
+            double Rfvalue = parameter_get_value(Rf, j);
+            double Cfvalue = parameter_get_value(Cf, i);
+
+            // open loop, shared by all plans (see pll_calculate)
+            vector_copy_values(Hfilter_denominator, state->s);
+            vector_multiply(Hfilter_denominator, state->s);
+            vector_scale(Hfilter_denominator, Rfvalue * Cfvalue * state->Cfx);
+            vector_add_scaled(Hfilter_denominator, state->s, Cfvalue + state->Cfx);
+            vector_copy_values(Hfilter, state->s);
+            vector_scale(Hfilter, Rfvalue * Cfvalue);
+            vector_add_scalar(Hfilter, 1);
+            vector_divide(Hfilter, Hfilter_denominator);
+            vector_copy_values(Hloop, Hfilter);
+            vector_scale(Hloop, g);
+            vector_multiply(Hloop, Hvco);
+            vector_multiply(Hloop, context->Hparasitic);
+
+            workspace_reset(workspace);
+            double f0dB;
+            double phasemargin;
+            double fbw = NAN;
+            if(!transfer_unity_gain_frequency(state->f, Hloop, &f0dB) || !transfer_phase_margin(workspace, state->f, Hloop, &phasemargin))
+            {
+                continue;
+            }
+            transfer_lowpass_bandwidth(state->f, Hloop, &fbw);
+            for(size_t k = 0; k < samples; ++k)
+            {
+                double complex FV = state->gm * filter[k] * vco[k];
+                FV2[k] = creal(FV) * creal(FV) + cimag(FV) * cimag(FV);
+                Hfilter2[k] = creal(filter[k]) * creal(filter[k]) + cimag(filter[k]) * cimag(filter[k]);
+            }
+            double Sfilter0 = 1.657e-20 * Rfvalue;
+
+            // closed loop and noise scaling per plan
+            for(size_t p = 0; p < plan->numresults; ++p)
+            {
+                struct plan_result* result = &plan->results[p];
+                if(f0dB > plan->ratio * result->fref / result->M)
+                {
+                    continue;
+                }
+                unsigned int k = state->fsig / result->fref;
+                double kM = k / result->M; // integer division, like in pll_calculate
+                double invN = 1.0 / result->N;
+                for(size_t l = 0; l < samples; ++l)
+                {
+                    double lr = creal(loop[l]);
+                    double li = cimag(loop[l]);
+                    double dr = 1 + invN * lr;
+                    double di = invN * li;
+                    double dmag2 = dr * dr + di * di;
+                    double clmag2 = (lr * lr + li * li) / dmag2;
+                    S[l] = kM * kM * clmag2 * creal(Sref[l])
+                        + creal(Svco[l]) / dmag2
+                        + clmag2 / (g * g) * creal(Scp[l])
+                        + FV2[l] / dmag2 * creal(Sphasedetector[l])
+                        + clmag2 / (g * g * Hfilter2[l]) * Sfilter0;
+                }
+                double Jrms = noise_area_to_RMSjitter(state->fsig, _integrate(state, Stot));
+                double score = eval(phasemargin, fbw, Jrms);
+                if(!result->valid || score < result->score)
+                {
+                    result->valid = 1;
+                    result->Rf = Rfvalue;
+                    result->Cf = Cfvalue;
+                    result->score = score;
+                    result->phasemargin = phasemargin;
+                    result->f0dB = f0dB;
+                    result->fbw = fbw;
+                    result->Jrms = Jrms;
+                }
+            }
+        }
+    }
+
+    memory_free(FV2);
+    memory_free(Hfilter2);
+    vector_destroy(Hfilter);
+    vector_destroy(Hfilter_denominator);
+    vector_destroy(Hvco);
+    vector_destroy(Hloop);
+    vector_destroy(Stot);
+    workspace_destroy(workspace);
+
+    struct rank* ranks = memory_allocate(plan->numresults * sizeof(*ranks));
+    for(size_t p = 0; p < plan->numresults; ++p)
+    {
+        ranks[p].result = &plan->results[p];
+        ranks[p].index = p;
+    }
+    qsort(ranks, plan->numresults, sizeof(*ranks), _compare_rank);
+    memory_free(plan->ranking);
+    plan->ranking = memory_allocate(plan->numresults * sizeof(*plan->ranking));
+    for(size_t p = 0; p < plan->numresults; ++p)
+    {
+        plan->ranking[p] = ranks[p].index;
+    }
+    memory_free(ranks);
+    return plan->numresults;
+}
+
+size_t plan_get_count(const struct plan* plan)
+{
+    return plan->numresults;
+}
+
+const struct plan_result* plan_get_result(const struct plan* plan, size_t rank)
+{
+    return &plan->results[plan->ranking[rank]];
+}
@@ -0,0 +1,49 @@
+#ifndef PLL_PLAN_H
+#define PLL_PLAN_H
+
+#include <stddef.h>
+
+#include "parameter.h"
+#include "pll.h"
+
+// Frequency plan explorer: enumerates reference frequencies and divider settings (fref, N, M) for a target output frequency
+// and finds the best loop filter (Rf, Cf) of every plan.
+// A plan is feasible if the detector frequency fref / M is at least the minimum detector frequency and
+// fsig * M / (fref * N) is an integer (the remaining multiplication of a sampling phase detector, 1 for a classical PLL).
+// The open loop (Hloop, unity-gain frequency, phase margin, bandwidth) does not depend on the plan,
+// so it is calculated once per filter and shared by all plans, only the closed loop and the noise scaling are recomputed.
+// Like pll_get_score, plans are scored with the minimum Kvco corner. All other settings (including Cfx) are taken from the state,
+// the reference noise is assumed to be the same for all candidate references.
+
+struct plan_result {
+    double fref;
+    unsigned int N;
+    unsigned int M;
+    int valid; // 0 if no filter passes the bandwidth limit
+    double Rf;
+    double Cf;
+    double score;
+    double phasemargin;
+    double f0dB;
+    double fbw;
+    double Jrms;
+};
+
+struct plan;
+
+struct plan* plan_create(void);
+void plan_destroy(struct plan* plan);
+void plan_add_reference(struct plan* plan, double fref);
+// dividers are enumerated from 1 to the maximum (default: 8 for both)
+void plan_set_divider_range(struct plan* plan, unsigned int maxN, unsigned int maxM);
+void plan_set_min_detector_frequency(struct plan* plan, double frequency);
+// a filter is only accepted for a plan if its unity-gain frequency is at most ratio * fref / M (default: 0.1)
+void plan_set_bandwidth_ratio(struct plan* plan, double ratio);
+// enumerates the feasible plans for the output frequency of 'state' and optimizes the filter of each plan over the grid Rf x Cf,
+// returns the number of feasible plans
+size_t plan_run(struct plan* plan, const struct pll_state* state, const struct parameter* Rf, const struct parameter* Cf, evaluator eval);
+size_t plan_get_count(const struct plan* plan);
+// plans are ranked by score (invalid plans last), rank 0 is the best plan
+const struct plan_result* plan_get_result(const struct plan* plan, size_t rank);
+
+#endif /* PLL_PLAN_H */
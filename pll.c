@@ -1,111 +1,80 @@
 #include "pll.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "constants.h"
+#include "context.h"
 #include "engineering.h"
+#include "measurement.h"
+#include "memory.h"
 #include "noise.h"
+#include "pll_internal.h"
 #include "transfer.h"
 #include "vector.h"
 
-struct pll_state {
-    int flowerexp;
-    int fupperexp;
-    unsigned int pointsperdecade;
-    double fref;
-    double fsig;
+struct pll_state* pll_create(void)
+{
+    struct pll_state* state = memory_allocate_zeroed(1, sizeof(*state));
+    state->numparpoles = 0;
+    return state;
+}
 
-    unsigned int N;
-    unsigned int M;
+static struct vector* _make_1pole_tf(struct workspace* workspace, const struct vector* s, complex double pole);
+static void _select_kernel(struct pll_state* state);
 
-    struct vector* f;
-    struct vector* s;
+static void _fill_context(struct context* context, const struct pll_state* state)
+{
+    // Hparasitic
+    struct workspace* workspace = workspace_create(2 * context->samples * sizeof(double complex) + 128);
+    for(size_t i = 0; i < state->numparpoles; ++i)
+    {
+        struct vector* tf = _make_1pole_tf(workspace, context->s, state->parpoles[i]);
+        vector_multiply(context->Hparasitic, tf);
+        workspace_reset(workspace);
+    }
+    workspace_destroy(workspace);
 
-    // Phase Detector
-    double detectorgain;
-    double Sphasedetector0;
-    struct vector* Hdetector;
-    struct vector* Nphasedetector;
-    struct vector* Sphasedetector;
-    struct vector* Stot_phasedetector;
+    // Reference
+    if(state->refprofile)
+    {
+        measurement_add_PSD(state->refprofile, context->Sref, context->f);
+    }
+    else
+    {
+        noise_PSD_20dB_per_decade(context->Sref, context->f, state->dfref0, state->Sref0);
+        noise_PSD_30dB_per_decade(context->Sref, context->f, state->dfref0fc, state->dfref0 / state->dfref0fc * state->Sref0);
+    }
 
-    // Charge Pump
-    double gm;
-    double Scp0;
-    double fccp;
-    struct vector* Hcp;
-    struct vector* Ncp;
-    struct vector* Scp;
-    struct vector* Stot_cp;
-
-    // oscillator
-    double min_Kvco;
-    double max_Kvco;
-    double Svco0;
-    double dfvco0;
-    double dfvco0fc;
-    struct vector* Hvco;
-    struct vector* Nvco;
-    struct vector* Svco;
-    struct vector* Stot_vco;
-
-    // Filter
-    double Rf;
-    double Cf;
-    double Cfx;
-    struct vector* Nfilter;
-    struct vector* Sfilter;
-    struct vector* Stot_filter;
+    // VCO
+    if(state->vcoprofile)
+    {
+        measurement_add_PSD(state->vcoprofile, context->Svco, context->f);
+    }
+    else
+    {
+        noise_PSD_20dB_per_decade(context->Svco, context->f, state->dfvco0, state->Svco0);
+        noise_PSD_30dB_per_decade(context->Svco, context->f, state->dfvco0fc, state->dfvco0 / state->dfvco0fc * state->Svco0);
+    }
 
-    // Reference
-    double Sref0;
-    double dfref0;
-    double dfref0fc;
-    struct vector* Href;
-    struct vector* Nref;
-    struct vector* Sref;
-    struct vector* Stot_ref;
-
-    // Parasitic Poles
-    double* parpoles;
-    size_t numparpoles;
-    struct vector* Hparasitic;
-
-    // Loop Transfer Functions
-    struct vector* Hloop;
-    struct vector* Hclosedloop;
-    struct vector* Hclosedloop_denominator;
-    struct vector* Stot;
-
-    // Results (one each for both min_Kvco and max_Kvco)
-    double Jrms[2];
-    double Jrms_vco[2];
-    double Jrms_ref[2];
-    double Jrms_cp[2];
-    double Jrms_filter[2];
-    double f0dB[2];
-    double phasemargin[2];
-    double fbw[2];
-};
+    // Charge Pump
+    noise_PSD_white_flicker(context->Scp, context->f, state->Scp0, state->fccp);
 
-struct pll_state* pll_create(void)
-{
-    struct pll_state* state = malloc(sizeof(*state));
-    state->numparpoles = 0;
-    return state;
+    // Phase Detector
+    vector_set_all(context->Sphasedetector, state->Sphasedetector0);
 }
 
-void pll_initialize(struct pll_state* state)
+static void _create_buffers(struct pll_state* state)
 {
-    unsigned int samples = (state->fupperexp - state->flowerexp) * state->pointsperdecade;
-    state->f = vector_logspace(state->flowerexp, state->fupperexp, samples);
-    state->s = vector_copy(state->f);
-    vector_scale(state->s, 2 * CONSTANTS_PI * CONSTANTS_I);
+    size_t samples = state->context->samples;
+    state->f = state->context->f;
+    state->s = state->context->s;
     state->Hvco = vector_create(samples, 0);
-    state->Hdetector = vector_create(samples, 0);
-    state->Hcp = vector_create(samples, 0);
-    state->Hparasitic = vector_create(samples, 0);
+    state->Hfilter = vector_create(samples, 0);
+    state->Hfilter_denominator = vector_create(samples, 0);
+    state->filtervalid = 0;
     state->Hloop = vector_create(samples, 0);
     state->Hclosedloop = vector_create(samples, 0);
     state->Hclosedloop_denominator = vector_create(samples, 0);
@@ -116,27 +85,24 @@ void pll_initialize(struct pll_state* state)
     state->Stot_cp = vector_create(samples, 0);
     state->Stot_phasedetector = vector_create(samples, 0);
     state->Stot_filter = vector_create(samples, 0);
-    state->Sref = vector_create(samples, 0);
-    state->Svco = vector_create(samples, 0);
-    state->Scp = vector_create(samples, 0);
-    state->Sphasedetector = vector_create(samples, 0);
-    state->Sfilter = vector_create(samples, 0);
     state->Nref = vector_create(samples, 0);
     state->Nvco = vector_create(samples, 0);
     state->Ncp = vector_create(samples, 0);
     state->Nphasedetector = vector_create(samples, 0);
     state->Nfilter = vector_create(samples, 0);
+    state->workspace = workspace_create(2 * samples * sizeof(double complex) + 256);
 }
 
-void pll_cleanup(struct pll_state* state)
+static void _destroy_buffers(struct pll_state* state)
 {
-    vector_destroy(state->f);
-    vector_destroy(state->s);
+    if(!state->context)
+    {
+        return;
+    }
     vector_destroy(state->Hvco);
-    vector_destroy(state->Hcp);
-    vector_destroy(state->Hparasitic);
+    vector_destroy(state->Hfilter);
+    vector_destroy(state->Hfilter_denominator);
     vector_destroy(state->Hloop);
-    vector_destroy(state->Hdetector);
     vector_destroy(state->Hclosedloop);
     vector_destroy(state->Hclosedloop_denominator);
     vector_destroy(state->Stot);
@@ -145,17 +111,101 @@ void pll_cleanup(struct pll_state* state)
     vector_destroy(state->Stot_cp);
     vector_destroy(state->Stot_phasedetector);
     vector_destroy(state->Stot_filter);
-    vector_destroy(state->Sref);
-    vector_destroy(state->Svco);
-    vector_destroy(state->Scp);
-    vector_destroy(state->Sphasedetector);
-    vector_destroy(state->Sfilter);
     vector_destroy(state->Nref);
     vector_destroy(state->Nvco);
     vector_destroy(state->Ncp);
     vector_destroy(state->Nphasedetector);
     vector_destroy(state->Nfilter);
-    free(state);
+    workspace_destroy(state->workspace);
+    context_release(state->context);
+    state->context = NULL;
+}
+
+// the configuration of the context changed after initialization: the next pll_calculate rebuilds it
+// (other states that share the old context keep it)
+static void _invalidate_context(struct pll_state* state)
+{
+    if(state->context)
+    {
+        state->contextstale = 1;
+    }
+}
+
+void pll_initialize(struct pll_state* state)
+{
+    struct context* context = context_create(state->flowerexp, state->fupperexp, state->pointsperdecade);
+    _fill_context(context, state);
+    pll_initialize_shared(state, context);
+    context_release(context);
+}
+
+void pll_initialize_shared(struct pll_state* state, struct context* context)
+{
+    // retained before the old context is released, which may be the same one
+    context_retain(context);
+    _destroy_buffers(state);
+    state->context = context;
+    state->contextstale = 0;
+    state->flowerexp = context->flowerexp;
+    state->fupperexp = context->fupperexp;
+    state->pointsperdecade = context->pointsperdecade;
+    _create_buffers(state);
+    _select_kernel(state);
+}
+
+struct context* pll_get_context(struct pll_state* state)
+{
+    return state->context;
+}
+
+struct pll_state* pll_clone(const struct pll_state* state)
+{
+    struct pll_state* clone = memory_allocate(sizeof(*clone));
+    *clone = *state;
+    if(state->numparpoles > 0)
+    {
+        clone->parpoles = memory_allocate(state->numparpoles * sizeof(*clone->parpoles));
+        for(size_t i = 0; i < state->numparpoles; ++i)
+        {
+            clone->parpoles[i] = state->parpoles[i];
+        }
+    }
+    if(state->numbands > 0)
+    {
+        clone->bands = memory_allocate(state->numbands * sizeof(*clone->bands));
+        clone->Jrms_bands = memory_allocate(2 * state->numbands * sizeof(*clone->Jrms_bands));
+        for(size_t i = 0; i < state->numbands; ++i)
+        {
+            clone->bands[i] = state->bands[i];
+            clone->Jrms_bands[2 * i] = state->Jrms_bands[2 * i];
+            clone->Jrms_bands[2 * i + 1] = state->Jrms_bands[2 * i + 1];
+        }
+    }
+    clone->context = NULL;
+    if(state->contextstale)
+    {
+        pll_initialize(clone);
+    }
+    else if(state->context)
+    {
+        pll_initialize_shared(clone, state->context);
+    }
+    return clone;
+}
+
+void pll_cleanup(struct pll_state* state)
+{
+    _destroy_buffers(state);
+    if(state->numparpoles > 0)
+    {
+        memory_free(state->parpoles);
+    }
+    if(state->numbands > 0)
+    {
+        memory_free(state->bands);
+        memory_free(state->Jrms_bands);
+    }
+    memory_free(state);
 }
 
 void pll_set_eval_frequencies(struct pll_state* state, int flowerexp, int fupperexp, unsigned int pointsperdecade)
@@ -163,6 +213,7 @@ void pll_set_eval_frequencies(struct pll_state* state, int flowerexp, int fupper
     state->flowerexp = flowerexp;
     state->fupperexp = fupperexp;
     state->pointsperdecade = pointsperdecade;
+    _invalidate_context(state);
 }
 
 void pll_set_input_output_frequencies(struct pll_state* state, double fref, double fsig)
@@ -174,25 +225,57 @@ void pll_set_input_output_frequencies(struct pll_state* state, double fref, doub
 void pll_set_feedback_divider(struct pll_state* state, unsigned int factor)
 {
     state->N = factor;
+    _select_kernel(state);
 }
 
 void pll_set_reference_divider(struct pll_state* state, unsigned int factor)
 {
     state->M = factor;
+    _select_kernel(state);
 }
 
 void pll_add_parasitic_pole(struct pll_state* state, double pole)
 {
     if(state->numparpoles == 0)
     {
-        state->parpoles = malloc(1 * sizeof(*state->parpoles));
+        state->parpoles = memory_allocate(1 * sizeof(*state->parpoles));
     }
     else
     {
-        state->parpoles = realloc(state->parpoles, (state->numparpoles + 1) * sizeof(*state->parpoles));
+        state->parpoles = memory_reallocate(state->parpoles, (state->numparpoles + 1) * sizeof(*state->parpoles));
     }
     state->parpoles[state->numparpoles] = pole;
     ++state->numparpoles;
+    _invalidate_context(state);
+}
+
+void pll_set_jitter_band(struct pll_state* state, double flower, double fupper)
+{
+    state->jitterband.flower = flower;
+    state->jitterband.fupper = fupper;
+    _select_kernel(state);
+}
+
+size_t pll_add_jitter_band(struct pll_state* state, double flower, double fupper)
+{
+    state->bands = memory_reallocate(state->bands, (state->numbands + 1) * sizeof(*state->bands));
+    state->Jrms_bands = memory_reallocate(state->Jrms_bands, 2 * (state->numbands + 1) * sizeof(*state->Jrms_bands));
+    state->bands[state->numbands].flower = flower;
+    state->bands[state->numbands].fupper = fupper;
+    state->Jrms_bands[2 * state->numbands] = 0.0;
+    state->Jrms_bands[2 * state->numbands + 1] = 0.0;
+    ++state->numbands;
+    return state->numbands - 1;
+}
+
+size_t pll_get_num_jitter_bands(const struct pll_state* state)
+{
+    return state->numbands;
+}
+
+double pll_get_band_jitter(const struct pll_state* state, size_t band, size_t corner)
+{
+    return state->Jrms_bands[2 * band + corner];
 }
 
 void pll_set_phase_detector_gain(struct pll_state* state, double gain)
@@ -203,6 +286,7 @@ void pll_set_phase_detector_gain(struct pll_state* state, double gain)
 void pll_set_phase_detector_noise(struct pll_state* state, double S0)
 {
     state->Sphasedetector0 = S0;
+    _invalidate_context(state);
 }
 
 void pll_set_vco_gain(struct pll_state* state, double min_Kvco, double max_Kvco)
@@ -216,6 +300,8 @@ void pll_set_vco_noise(struct pll_state* state, double f0, double L0, double fc)
     state->dfvco0 = f0;
     state->Svco0 = noise_L_to_S(L0);
     state->dfvco0fc = fc;
+    state->vcoprofile = NULL;
+    _invalidate_context(state);
 }
 
 void pll_set_reference_noise(struct pll_state* state, double f0, double L0, double fc)
@@ -223,6 +309,20 @@ void pll_set_reference_noise(struct pll_state* state, double f0, double L0, doub
     state->dfref0 = f0;
     state->Sref0 = noise_L_to_S(L0);
     state->dfref0fc = fc;
+    state->refprofile = NULL;
+    _invalidate_context(state);
+}
+
+void pll_set_vco_noise_profile(struct pll_state* state, const struct measurement* profile)
+{
+    state->vcoprofile = profile;
+    _invalidate_context(state);
+}
+
+void pll_set_reference_noise_profile(struct pll_state* state, const struct measurement* profile)
+{
+    state->refprofile = profile;
+    _invalidate_context(state);
 }
 
 void pll_set_filter(struct pll_state* state, double Rf, double Cf, double Cfx)
@@ -241,6 +341,158 @@ void pll_set_chargepump_noise(struct pll_state* state, double S0, double fc)
 {
     state->Scp0 = S0;
     state->fccp = fc;
+    _invalidate_context(state);
+}
+
+void pll_set_variable(struct pll_state* state, enum pll_variable variable, double value)
+{
+    switch(variable)
+    {
+        case PLL_RF:
+            state->Rf = value;
+            break;
+        case PLL_CF:
+            state->Cf = value;
+            break;
+        case PLL_CFX:
+            state->Cfx = value;
+            break;
+        case PLL_GM:
+            state->gm = value;
+            break;
+        default:
+            break;
+    }
+}
+
+double pll_get_variable(const struct pll_state* state, enum pll_variable variable)
+{
+    switch(variable)
+    {
+        case PLL_RF:
+            return state->Rf;
+        case PLL_CF:
+            return state->Cf;
+        case PLL_CFX:
+            return state->Cfx;
+        case PLL_GM:
+            return state->gm;
+        default:
+            return 0.0;
+    }
+}
+
+static int _compare_double(const void* lhs, const void* rhs)
+{
+    double a = *(const double*)lhs;
+    double b = *(const double*)rhs;
+    return (a > b) - (a < b);
+}
+
+static double _canonical(double value)
+{
+    // -0.0 and 0.0 must describe the same configuration
+    return value == 0.0 ? 0.0 : value;
+}
+
+size_t pll_get_configuration(const struct pll_state* state, double* values, size_t capacity)
+{
+    double fixed[] = {
+        state->flowerexp,
+        state->fupperexp,
+        state->pointsperdecade,
+        state->fref,
+        state->fsig,
+        state->N,
+        state->M,
+        state->detectorgain,
+        state->Sphasedetector0,
+        state->Scp0,
+        state->fccp,
+        state->min_Kvco,
+        state->max_Kvco,
+        state->Svco0,
+        state->dfvco0,
+        state->dfvco0fc,
+        state->Sref0,
+        state->dfref0,
+        state->dfref0fc,
+        state->jitterband.flower,
+        state->jitterband.fupper,
+        // measured profiles are identified by their data (53 bits of the hash are exactly representable)
+        state->vcoprofile ? (double)(measurement_get_hash(state->vcoprofile) >> 11) : 0.0,
+        state->refprofile ? (double)(measurement_get_hash(state->refprofile) >> 11) : 0.0,
+    };
+    size_t numfixed = sizeof(fixed) / sizeof(fixed[0]);
+    size_t count = numfixed + state->numparpoles;
+    double poles[state->numparpoles + 1];
+    for(size_t i = 0; i < state->numparpoles; ++i)
+    {
+        poles[i] = state->parpoles[i];
+    }
+    qsort(poles, state->numparpoles, sizeof(*poles), _compare_double);
+    for(size_t i = 0; i < count && i < capacity; ++i)
+    {
+        values[i] = _canonical(i < numfixed ? fixed[i] : poles[i - numfixed]);
+    }
+    return count;
+}
+
+uint64_t pll_get_configuration_hash(const struct pll_state* state)
+{
+    double values[64];
+    size_t count = pll_get_configuration(state, values, 64);
+    // FNV-1a over the bit patterns (poles beyond the buffer still change the count)
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < count && i < 64; ++i)
+    {
+        uint64_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        for(size_t j = 0; j < 8; ++j)
+        {
+            hash ^= (bits >> (8 * j)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    }
+    hash ^= count;
+    hash *= 1099511628211ULL;
+    return hash;
+}
+
+// area under a PSD over the jitter integration band
+static double _integrate(const struct pll_state* state, struct vector* S)
+{
+    if(state->jitterband.fupper > state->jitterband.flower)
+    {
+        return noise_trapzS_band(state->f, S, state->jitterband.flower, state->jitterband.fupper);
+    }
+    return noise_trapzS(state->f, S);
+}
+
+// integrated total noise and contributions (indices of the 'areas' of the corner kernels)
+#define PLL_NUM_AREAS 5
+enum {
+    AREA_TOTAL,
+    AREA_VCO,
+    AREA_REF,
+    AREA_CP,
+    AREA_FILTER
+};
+
+static void _integrate_areas(const struct pll_state* state, double* areas)
+{
+    areas[AREA_TOTAL] = _integrate(state, state->Stot);
+    areas[AREA_VCO] = _integrate(state, state->Stot_vco);
+    areas[AREA_REF] = _integrate(state, state->Stot_ref);
+    areas[AREA_CP] = _integrate(state, state->Stot_cp);
+    areas[AREA_FILTER] = _integrate(state, state->Stot_filter);
+}
+
+// area of one interval of noise_trapzS (power law through both points), ratio = fupper / flower
+static inline double _power_law_area(double S1, double S2, double flower, double ratio, double logratio)
+{
+    double m = log(S2 / S1) / logratio;
+    return 0.5 * S1 / (m + 1) * flower * (pow(ratio, (m + 1)) - 1);
 }
 
 static void _effective_noise(struct vector* result, const struct vector* NTF, const struct vector* S)
@@ -251,29 +503,231 @@ static void _effective_noise(struct vector* result, const struct vector* NTF, co
     vector_multiply(result, S);
 }
 
-static struct vector* _make_1pole_tf(const struct vector* s, complex double pole)
+static struct vector* _make_1pole_tf(struct workspace* workspace, const struct vector* s, complex double pole)
 {
-    struct vector* tfden = vector_copy(s);
+    struct vector* tfden = vector_copy_in(workspace, s);
     vector_scale(tfden, -1 / (2 * CONSTANTS_PI * pole));
     vector_add_scalar(tfden, 1);
-    struct vector* tf = vector_copy(s);
+    struct vector* tf = vector_copy_in(workspace, s);
     vector_set_all(tf, 1);
     vector_divide(tf, tfden);
     vector_destroy(tfden);
     return tf;
 }
 
+// vector implementation of one Kvco corner (the reference for the specialized kernels)
+static void _calculate_generic(struct pll_state* state, double Kvco, unsigned int k, double* areas)
+{
+    // Hvco: 2 * pi * Kvco / s
+    vector_set_all(state->Hvco, 2 * CONSTANTS_PI * Kvco);
+    vector_divide(state->Hvco, state->s);
+
+    // Hloop: detectorgain * gm * Hfilter * Hvco * Hparasitic
+    // (the poles of the detector and the charge pump are included in Hparasitic)
+    vector_copy_values(state->Hloop, state->Hfilter);
+    vector_scale(state->Hloop, state->detectorgain * state->gm);
+    vector_multiply(state->Hloop, state->Hvco);
+    vector_multiply(state->Hloop, state->context->Hparasitic);
+
+    // Hclosedloop: Hloop / (1 + 1 / N * Hloop)
+    vector_copy_values(state->Hclosedloop_denominator, state->Hloop);
+    vector_scale(state->Hclosedloop_denominator, 1.0 / state->N);
+    vector_add_scalar(state->Hclosedloop_denominator, 1);
+    vector_copy_values(state->Hclosedloop, state->Hloop);
+    vector_divide(state->Hclosedloop, state->Hclosedloop_denominator);
+
+    /*
+     * Noise Transfer Functions and Effective Noise Contributions (Power Spectral Densities) *
+     */
+
+    // Reference (Sref is precomputed in the context)
+    // Nref: k / M * Hclosedloop
+    vector_copy_values(state->Nref, state->Hclosedloop);
+    vector_scale(state->Nref, k / state->M);
+    _effective_noise(state->Stot_ref, state->Nref, state->context->Sref);
+
+    // VCO (Svco is precomputed in the context)
+    // Nvco: 1 / (1 + 1 / N * Hloop)
+    vector_set_all(state->Nvco, 1);
+    vector_divide(state->Nvco, state->Hclosedloop_denominator);
+    _effective_noise(state->Stot_vco, state->Nvco, state->context->Svco);
+
+
+    // Charge Pump (Scp is precomputed in the context)
+    // Ncp: Hclosedloop / (detectorgain * gm)
+    vector_copy_values(state->Ncp, state->Hclosedloop);
+    vector_scale(state->Ncp, 1 / (state->detectorgain * state->gm));
+    _effective_noise(state->Stot_cp, state->Ncp, state->context->Scp);
+
+    // Phase Detector (Sphasedetector is precomputed in the context)
+    // Nphasedetector: gm * Hfilter * Hvco / (1 + 1 / N * Hloop)
+    vector_set_all(state->Nphasedetector, 1);
+    vector_scale(state->Nphasedetector, state->gm);
+    vector_multiply(state->Nphasedetector, state->Hfilter);
+    vector_multiply(state->Nphasedetector, state->Hvco);
+    vector_divide(state->Nphasedetector, state->Hclosedloop_denominator);
+    _effective_noise(state->Stot_phasedetector, state->Nphasedetector, state->context->Sphasedetector);
+
+    // Filter (white noise, Sfilter = Sfilter0 is applied as a scalar)
+    double Sfilter0 = 1.657e-20 * state->Rf;
+    // Nfilter: 1 / (detectorgain * gm * Hfilter) * Hclosedloop
+    vector_copy_values(state->Nfilter, state->Hclosedloop);
+    vector_scale(state->Nfilter, 1 / (state->detectorgain * state->gm));
+    vector_divide(state->Nfilter, state->Hfilter);
+    vector_copy_values(state->Stot_filter, state->Nfilter);
+    vector_abs_squared(state->Stot_filter);
+    vector_scale(state->Stot_filter, Sfilter0);
+
+    // Total PLL Noise
+    vector_set_all(state->Stot, 0);
+    vector_add(state->Stot, state->Stot_ref);
+    vector_add(state->Stot, state->Stot_vco);
+    vector_add(state->Stot, state->Stot_cp);
+    vector_add(state->Stot, state->Stot_phasedetector);
+    vector_add(state->Stot, state->Stot_filter);
+
+    _integrate_areas(state, areas);
+}
+
+static inline double _abs_squared(double complex value)
+{
+    return creal(value) * creal(value) + cimag(value) * cimag(value);
+}
+
+#define PLL_KERNEL_NAME _calculate_p0_u0_b0
+#define PLL_KERNEL_PARASITIC 0
+#define PLL_KERNEL_UNITY 0
+#define PLL_KERNEL_BANDED 0
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p0_u0_b1
+#define PLL_KERNEL_PARASITIC 0
+#define PLL_KERNEL_UNITY 0
+#define PLL_KERNEL_BANDED 1
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p0_u1_b0
+#define PLL_KERNEL_PARASITIC 0
+#define PLL_KERNEL_UNITY 1
+#define PLL_KERNEL_BANDED 0
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p0_u1_b1
+#define PLL_KERNEL_PARASITIC 0
+#define PLL_KERNEL_UNITY 1
+#define PLL_KERNEL_BANDED 1
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p1_u0_b0
+#define PLL_KERNEL_PARASITIC 1
+#define PLL_KERNEL_UNITY 0
+#define PLL_KERNEL_BANDED 0
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p1_u0_b1
+#define PLL_KERNEL_PARASITIC 1
+#define PLL_KERNEL_UNITY 0
+#define PLL_KERNEL_BANDED 1
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p1_u1_b0
+#define PLL_KERNEL_PARASITIC 1
+#define PLL_KERNEL_UNITY 1
+#define PLL_KERNEL_BANDED 0
+#include "pll_kernel.h"
+
+#define PLL_KERNEL_NAME _calculate_p1_u1_b1
+#define PLL_KERNEL_PARASITIC 1
+#define PLL_KERNEL_UNITY 1
+#define PLL_KERNEL_BANDED 1
+#include "pll_kernel.h"
+
+// Hfilter in one pass, the s * s term vanishes without Cfx (same operations as the vector implementation)
+static void _calculate_filter(struct pll_state* state)
+{
+    size_t samples = state->context->samples;
+    const double complex* s = vector_data(state->s);
+    double complex* Hfilter = vector_data(state->Hfilter);
+    double complex zero = state->Rf * state->Cf;
+    double complex capacitance = state->Cf + state->Cfx;
+    if(state->Cfx != 0)
+    {
+        double complex product = state->Rf * state->Cf * state->Cfx;
+        for(size_t i = 0; i < samples; ++i)
+        {
+            Hfilter[i] = (s[i] * zero + 1) / (s[i] * s[i] * product + capacitance * s[i]);
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < samples; ++i)
+        {
+            Hfilter[i] = (s[i] * zero + 1) / (capacitance * s[i]);
+        }
+    }
+}
+
+static void _select_kernel(struct pll_state* state)
+{
+    static void (*const kernels[2][2][2])(struct pll_state*, double, unsigned int, double*) = {
+        { { _calculate_p0_u0_b0, _calculate_p0_u0_b1 }, { _calculate_p0_u1_b0, _calculate_p0_u1_b1 } },
+        { { _calculate_p1_u0_b0, _calculate_p1_u0_b1 }, { _calculate_p1_u1_b0, _calculate_p1_u1_b1 } }
+    };
+    int parasitic = state->numparpoles > 0;
+    int unity = state->N == 1 && state->M == 1;
+    int banded = state->jitterband.fupper > state->jitterband.flower;
+    state->kernel = state->generic ? _calculate_generic : kernels[parasitic][unity][banded];
+}
+
+void pll_set_generic_kernel(struct pll_state* state, int generic)
+{
+    state->generic = generic;
+    _select_kernel(state);
+}
+
 int pll_calculate(struct pll_state* state)
 {
     unsigned int k = state->fsig / state->fref; // multiple between input and output
 
+    if(state->contextstale)
+    {
+        pll_initialize(state);
+    }
+
+    // the filter does not depend on Kvco, so it is shared by both corners
+    // (and kept from the previous call if the filter values did not change)
+    state->reused = PLL_REUSE_NONE;
+    if(state->filtervalid && state->filterkey[0] == state->Rf && state->filterkey[1] == state->Cf && state->filterkey[2] == state->Cfx)
+    {
+        state->reused |= PLL_REUSE_FILTER;
+    }
+    else
+    {
+        if(state->generic)
+        {
+            // Hfilter (1 + s * Cf * Rf) / (s * (Cf + Cfx) + s * s * Rf * Cf * Cfx)
+            vector_copy_values(state->Hfilter_denominator, state->s);
+            vector_multiply(state->Hfilter_denominator, state->s);
+            vector_scale(state->Hfilter_denominator, state->Rf * state->Cf * state->Cfx);
+            vector_add_scaled(state->Hfilter_denominator, state->s, state->Cf + state->Cfx);
+            vector_copy_values(state->Hfilter, state->s);
+            vector_scale(state->Hfilter, state->Rf * state->Cf);
+            vector_add_scalar(state->Hfilter, 1);
+            vector_divide(state->Hfilter, state->Hfilter_denominator);
+        }
+        else
+        {
+            _calculate_filter(state);
+        }
+        state->filterkey[0] = state->Rf;
+        state->filterkey[1] = state->Cf;
+        state->filterkey[2] = state->Cfx;
+        state->filtervalid = 1;
+    }
+
     for(size_t i = 0; i < 2; ++i)
     {
-        /*
-         * Loop Gain Transfer Functions *
-         */
-        
-        // Hvco: 2 * pi * Kvco / s
+        // loop transfer functions and effective noise contributions
         double Kvco;
         if(i == 0)
         {
@@ -283,131 +737,67 @@ int pll_calculate(struct pll_state* state)
         {
             Kvco = state->max_Kvco;
         }
-        vector_set_all(state->Hvco, 2 * CONSTANTS_PI * Kvco);
-        vector_divide(state->Hvco, state->s);
-
-        // Hfilter (1 + s * Cf * Rf) / (s * (Cf + Cfx) + s * s * Rf * Cf * Cfx)
-        struct vector* Hfilter_denominator1 = vector_copy(state->s);
-        vector_scale(Hfilter_denominator1, state->Cf + state->Cfx);
-        struct vector* Hfilter_denominator = vector_copy(state->s);
-        vector_multiply(Hfilter_denominator, state->s);
-        vector_scale(Hfilter_denominator, state->Rf * state->Cf * state->Cfx);
-        vector_add(Hfilter_denominator, Hfilter_denominator1);
-        struct vector* Hfilter = vector_copy(state->s);
-        vector_scale(Hfilter, state->Rf * state->Cf);
-        vector_add_scalar(Hfilter, 1);
-        vector_divide(Hfilter, Hfilter_denominator);
-
-        // Hparasitic
-        vector_set_all(state->Hparasitic, 1);
-        for(size_t i = 0; i < sizeof(state->parpoles) / sizeof(state->parpoles[0]); ++i)
-        {
-            struct vector* tf = _make_1pole_tf(state->s, state->parpoles[i]);
-            vector_multiply(state->Hparasitic, tf);
-            vector_destroy(tf);
-        }
+        double areas[PLL_NUM_AREAS];
+        state->kernel(state, Kvco, k, areas);
 
-        // Hdetector: detectorgain (poles are included in Hparasitic)
-        vector_set_all(state->Hdetector, state->detectorgain);
-
-        // Hcp: gm (poles are included in Hparasitic)
-        vector_set_all(state->Hcp, state->gm);
-
-        // Hloop: Hdetector * Hcp * Hfilter * Hvco * Hparasitic
-        vector_set_all(state->Hloop, 1);
-        vector_multiply(state->Hloop, state->Hdetector);
-        vector_multiply(state->Hloop, state->Hcp);
-        vector_multiply(state->Hloop, Hfilter);
-        vector_multiply(state->Hloop, state->Hvco);
-        vector_multiply(state->Hloop, state->Hparasitic);
-
-        // Hclosedloop: Hloop / (1 + 1 / N * Hloop)
-        vector_copy_values(state->Hclosedloop_denominator, state->Hloop);
-        vector_scale(state->Hclosedloop_denominator, 1.0 / state->N);
-        vector_add_scalar(state->Hclosedloop_denominator, 1);
-        vector_copy_values(state->Hclosedloop, state->Hloop);
-        vector_divide(state->Hclosedloop, state->Hclosedloop_denominator);
-
-        /*
-         * Noise Transfer Functions and Effective Noise Contributions (Power Spectral Densities) *
-         */
-
-        // Reference
-        vector_set_all(state->Sref, 0);
-        noise_PSD_20dB_per_decade(state->Sref, state->f, state->dfref0, state->Sref0);
-        noise_PSD_30dB_per_decade(state->Sref, state->f, state->dfref0fc, state->dfref0 / state->dfref0fc * state->Sref0);
-        // Nref: k / M * Hclosedloop
-        state->Nref = vector_copy(state->Hclosedloop);
-        vector_scale(state->Nref, k / state->M);
-        _effective_noise(state->Stot_ref, state->Nref, state->Sref);
-
-        // VCO
-        vector_set_all(state->Svco, 0);
-        noise_PSD_20dB_per_decade(state->Svco, state->f, state->dfvco0, state->Svco0);
-        noise_PSD_30dB_per_decade(state->Svco, state->f, state->dfvco0fc, state->dfvco0 / state->dfvco0fc * state->Svco0);
-        // Nvco: 1 / (1 + 1 / N * Hloop)
-        vector_set_all(state->Nvco, 1);
-        vector_divide(state->Nvco, state->Hclosedloop_denominator);
-        _effective_noise(state->Stot_vco, state->Nvco, state->Svco);
-
-
-        // Charge Pump
-        vector_set_all(state->Scp, 0);
-        noise_PSD_white_flicker(state->Scp, state->f, state->Scp0, state->fccp);
-        // Ncp: Hclosedloop / (detectorgain * gm)
-        vector_copy_values(state->Ncp, state->Hclosedloop);
-        vector_scale(state->Ncp, 1 / (state->detectorgain * state->gm));
-        _effective_noise(state->Stot_cp, state->Ncp, state->Scp);
-
-        // Phase Detector
-        vector_set_all(state->Sphasedetector, state->Sphasedetector0);
-        // Nphasedetector: gm * Hfilter * Hvco / (1 + 1 / N * Hloop)
-        vector_set_all(state->Nphasedetector, 1);
-        vector_scale(state->Nphasedetector, state->gm);
-        vector_multiply(state->Nphasedetector, Hfilter);
-        vector_multiply(state->Nphasedetector, state->Hvco);
-        vector_divide(state->Nphasedetector, state->Hclosedloop_denominator);
-        _effective_noise(state->Stot_phasedetector, state->Nphasedetector, state->Sphasedetector);
-
-        // Filter
-        double Sfilter0 = 1.657e-20 * state->Rf;
-        vector_set_all(state->Sfilter, 0);
-        noise_PSD_constant(state->Sfilter, state->f, Sfilter0);
-        // Nfilter: 1 / (detectorgain * gm * Hfilter) * Hclosedloop
-        vector_copy_values(state->Nfilter, state->Hclosedloop);
-        vector_scale(state->Nfilter, 1 / (state->detectorgain * state->gm));
-        vector_divide(state->Nfilter, Hfilter);
-        _effective_noise(state->Stot_filter, state->Nfilter, state->Sfilter);
-
-        // Total PLL Noise
-        vector_set_all(state->Stot, 0);
-        vector_add(state->Stot, state->Stot_ref);
-        vector_add(state->Stot, state->Stot_vco);
-        vector_add(state->Stot, state->Stot_cp);
-        vector_add(state->Stot, state->Stot_phasedetector);
-        vector_add(state->Stot, state->Stot_filter);
-
-        state->Jrms[i] = noise_RMSjitterS(state->fsig, state->f, state->Stot);
+        double Atot = areas[AREA_TOTAL];
+        state->Jrms[i] = noise_area_to_RMSjitter(state->fsig, Atot);
         transfer_unity_gain_frequency(state->f, state->Hloop, &state->f0dB[i]);
-        transfer_phase_margin(state->f, state->Hloop, &state->phasemargin[i]);
+        transfer_phase_margin(state->workspace, state->f, state->Hloop, &state->phasemargin[i]);
         transfer_lowpass_bandwidth(state->f, state->Hloop, &state->fbw[i]);
         
         // integrated jitter contributions (FIXME: is this really correct? Does this need a sqrt somewhere?)
-        double Atot = noise_trapzS(state->f, state->Stot);
-        state->Jrms_vco[i] = state->Jrms[i] * noise_trapzS(state->f, state->Stot_vco) / Atot;
-        state->Jrms_ref[i] = state->Jrms[i] * noise_trapzS(state->f, state->Stot_ref) / Atot;
-        state->Jrms_cp[i] = state->Jrms[i] * noise_trapzS(state->f, state->Stot_cp) / Atot;
-        state->Jrms_filter[i] = state->Jrms[i] * noise_trapzS(state->f, state->Stot_filter) / Atot;
+        state->Jrms_vco[i] = state->Jrms[i] * areas[AREA_VCO] / Atot;
+        state->Jrms_ref[i] = state->Jrms[i] * areas[AREA_REF] / Atot;
+        state->Jrms_cp[i] = state->Jrms[i] * areas[AREA_CP] / Atot;
+        state->Jrms_filter[i] = state->Jrms[i] * areas[AREA_FILTER] / Atot;
+
+        // additional jitter bands (all in one pass over Stot)
+        if(state->numbands > 0)
+        {
+            double areas[state->numbands];
+            noise_trapzS_bands(state->f, state->Stot, state->bands, state->numbands, areas);
+            for(size_t j = 0; j < state->numbands; ++j)
+            {
+                state->Jrms_bands[2 * j + i] = noise_area_to_RMSjitter(state->fsig, areas[j]);
+            }
+        }
     }
 
+    workspace_reset(state->workspace);
     return 1;
 }
 
+unsigned int pll_get_reused(const struct pll_state* state)
+{
+    return state->reused;
+}
+
 double pll_get_score(struct pll_state* state, evaluator eval)
 {
     return eval(state->phasemargin[0], state->fbw[0], state->Jrms[0]);
 }
 
+double pll_get_results_score(const struct pll_results* results, evaluator eval)
+{
+    return eval(results->phasemargin[0], results->fbw[0], results->Jrms[0]);
+}
+
+void pll_get_results(const struct pll_state* state, struct pll_results* results)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        results->Jrms[i] = state->Jrms[i];
+        results->Jrms_vco[i] = state->Jrms_vco[i];
+        results->Jrms_ref[i] = state->Jrms_ref[i];
+        results->Jrms_cp[i] = state->Jrms_cp[i];
+        results->Jrms_filter[i] = state->Jrms_filter[i];
+        results->f0dB[i] = state->f0dB[i];
+        results->phasemargin[i] = state->phasemargin[i];
+        results->fbw[i] = state->fbw[i];
+    }
+}
+
 void pll_print_result(struct pll_state* state)
 {
     for(size_t i = 0; i < 2; ++i)
@@ -421,14 +811,23 @@ void pll_print_result(struct pll_state* state)
 
             printf("%s\n", "* Results with Maximum Kvco *");
         }
-        char* Jrms_formatted = engineering_format(state->Jrms[i], "s", 1);
-        char* Jrms_vco_formatted = engineering_format(state->Jrms_vco[i], "s", 1);
-        char* Jrms_ref_formatted = engineering_format(state->Jrms_ref[i], "s", 1);
-        char* Jrms_cp_formatted = engineering_format(state->Jrms_cp[i], "s", 1);
-        char* Jrms_filter_formatted = engineering_format(state->Jrms_filter[i], "s", 1);
-        char* f0dB_formatted = engineering_format(state->f0dB[i], "Hz", 1);
-        char* phasemargin_formatted = engineering_format(state->phasemargin[i], "Degree", 1);
-        char* fbw_formatted = engineering_format(state->fbw[i], "Hz", 1);
+        // formatted on the stack (no allocation per call)
+        char Jrms_formatted[ENGINEERING_FORMAT_SIZE];
+        char Jrms_vco_formatted[ENGINEERING_FORMAT_SIZE];
+        char Jrms_ref_formatted[ENGINEERING_FORMAT_SIZE];
+        char Jrms_cp_formatted[ENGINEERING_FORMAT_SIZE];
+        char Jrms_filter_formatted[ENGINEERING_FORMAT_SIZE];
+        char f0dB_formatted[ENGINEERING_FORMAT_SIZE];
+        char phasemargin_formatted[ENGINEERING_FORMAT_SIZE];
+        char fbw_formatted[ENGINEERING_FORMAT_SIZE];
+        engineering_format_buffer(Jrms_formatted, sizeof(Jrms_formatted), state->Jrms[i], "s", 1);
+        engineering_format_buffer(Jrms_vco_formatted, sizeof(Jrms_vco_formatted), state->Jrms_vco[i], "s", 1);
+        engineering_format_buffer(Jrms_ref_formatted, sizeof(Jrms_ref_formatted), state->Jrms_ref[i], "s", 1);
+        engineering_format_buffer(Jrms_cp_formatted, sizeof(Jrms_cp_formatted), state->Jrms_cp[i], "s", 1);
+        engineering_format_buffer(Jrms_filter_formatted, sizeof(Jrms_filter_formatted), state->Jrms_filter[i], "s", 1);
+        engineering_format_buffer(f0dB_formatted, sizeof(f0dB_formatted), state->f0dB[i], "Hz", 1);
+        engineering_format_buffer(phasemargin_formatted, sizeof(phasemargin_formatted), state->phasemargin[i], "Degree", 1);
+        engineering_format_buffer(fbw_formatted, sizeof(fbw_formatted), state->fbw[i], "Hz", 1);
         printf("Jrms        = %s\n", Jrms_formatted);
         printf("Jrms vco    = %s (%.1f %%)\n", Jrms_vco_formatted, 100 * state->Jrms_vco[i] / state->Jrms[i]);
         printf("Jrms ref    = %s (%.1f %%)\n", Jrms_ref_formatted, 100 * state->Jrms_ref[i] / state->Jrms[i]);
@@ -438,11 +837,6 @@ void pll_print_result(struct pll_state* state)
         printf("phase margin = %s\n", phasemargin_formatted);
         printf("fbw = %s\n", fbw_formatted);
         printf("%s\n", "*****************************");
-        free(Jrms_formatted);
-        free(Jrms_vco_formatted);
-        free(f0dB_formatted);
-        free(phasemargin_formatted);
-        free(fbw_formatted);
 
     }
 }
@@ -2,8 +2,11 @@
 #define PLL_PLL_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 struct pll_state;
+struct context;
+struct measurement;
 
 // cost function
 // receives (in this order):
@@ -12,23 +15,82 @@ struct pll_state;
 // double Jrms
 typedef double (*evaluator)(double, double, double);
 
+// design variables that are typically optimized (see pll_set_variable)
+enum pll_variable {
+    PLL_RF,
+    PLL_CF,
+    PLL_CFX,
+    PLL_GM,
+    PLL_NUM_VARIABLES
+};
+
+// intermediates that pll_calculate took over from the previous call (bit mask, see pll_get_reused)
+enum pll_reuse {
+    PLL_REUSE_NONE = 0,
+    PLL_REUSE_FILTER = 1 // Hfilter (Rf, Cf and Cfx unchanged)
+};
+
+// results of pll_calculate (one each for both min_Kvco and max_Kvco)
+struct pll_results {
+    double Jrms[2];
+    double Jrms_vco[2];
+    double Jrms_ref[2];
+    double Jrms_cp[2];
+    double Jrms_filter[2];
+    double f0dB[2];
+    double phasemargin[2];
+    double fbw[2];
+};
+
 struct pll_state* pll_create(void);
+// computes the grid, the parasitic poles and the source PSDs into the (shared) context of the state.
+// Setters of these (evaluation frequencies, parasitic poles, noise sources and profiles) called after initialization
+// make the next pll_calculate rebuild a context of its own, states that share the old context are not affected.
 void pll_initialize(struct pll_state* state);
+// initialize a state with an already filled context (the context is shared, not copied)
+void pll_initialize_shared(struct pll_state* state, struct context* context);
+struct context* pll_get_context(struct pll_state* state);
+// create an independent copy of a state, sharing the (immutable) context of an initialized state
+struct pll_state* pll_clone(const struct pll_state* state);
 void pll_cleanup(struct pll_state* state);
 void pll_set_input_output_frequencies(struct pll_state* state, double fref, double fsig);
 void pll_set_eval_frequencies(struct pll_state* state, int flowerexp, int fupperexp, unsigned int pointsperdecade);
 void pll_set_feedback_divider(struct pll_state* state, unsigned int factor);
 void pll_set_reference_divider(struct pll_state* state, unsigned int factor);
 void pll_add_parasitic_pole(struct pll_state* state, double pole);
+// integrate jitter only over [flower, fupper] (both 0: whole evaluation range)
+void pll_set_jitter_band(struct pll_state* state, double flower, double fupper);
+// additional integration bands that are evaluated in every pll_calculate, returns the band index
+size_t pll_add_jitter_band(struct pll_state* state, double flower, double fupper);
+size_t pll_get_num_jitter_bands(const struct pll_state* state);
+double pll_get_band_jitter(const struct pll_state* state, size_t band, size_t corner);
 void pll_set_phase_detector_gain(struct pll_state* state, double gain);
 void pll_set_vco_gain(struct pll_state* state, double min_Kvco, double max_Kvco);
 void pll_set_vco_noise(struct pll_state* state, double f0, double S0, double fc);
 void pll_set_reference_noise(struct pll_state* state, double f0, double S0, double fc);
+// use measured L(f) data instead of the analytic models (the profile is not copied and must outlive the state)
+void pll_set_vco_noise_profile(struct pll_state* state, const struct measurement* profile);
+void pll_set_reference_noise_profile(struct pll_state* state, const struct measurement* profile);
 void pll_set_filter(struct pll_state* state, double Rs, double Cs, double Cx);
 void pll_set_chargepump_gain(struct pll_state* state, double gm);
 void pll_set_chargepump_noise(struct pll_state* state, double S0, double fc);
+void pll_set_variable(struct pll_state* state, enum pll_variable variable, double value);
+double pll_get_variable(const struct pll_state* state, enum pll_variable variable);
+// canonical description of the configuration (everything but the design variables):
+// fixed fields followed by the sorted parasitic poles, returns the number of values (at most 'capacity' are written)
+size_t pll_get_configuration(const struct pll_state* state, double* values, size_t capacity);
+uint64_t pll_get_configuration_hash(const struct pll_state* state);
 int pll_calculate(struct pll_state* state);
+// pll_calculate runs fused kernels that are specialized at compile time for the loop topology (parasitic poles or not,
+// N = M = 1 or not, jitter band or whole range, selected by pll_initialize and the divider and band setters) and for Cfx = 0.
+// They agree with the generic vector implementation to rounding, which can be forced (e.g. as a reference).
+void pll_set_generic_kernel(struct pll_state* state, int generic);
+// intermediates reused by the last pll_calculate (PLL_REUSE_* bits)
+unsigned int pll_get_reused(const struct pll_state* state);
+void pll_get_results(const struct pll_state* state, struct pll_results* results);
 double pll_get_score(struct pll_state* state, evaluator eval);
+// same as pll_get_score, but for stored results
+double pll_get_results_score(const struct pll_results* results, evaluator eval);
 void pll_print_result(struct pll_state* state);
 
 #endif /* PLL_PLL_H */
@@ -0,0 +1,112 @@
+#ifndef PLL_PLL_INTERNAL_H
+#define PLL_PLL_INTERNAL_H
+
+// definition of the pll state for the evaluation modules of the library (not part of the public interface)
+
+#include <stddef.h>
+
+#include "context.h"
+#include "noise.h"
+#include "vector.h"
+
+struct measurement;
+
+struct pll_state {
+    int flowerexp;
+    int fupperexp;
+    unsigned int pointsperdecade;
+    double fref;
+    double fsig;
+
+    unsigned int N;
+    unsigned int M;
+
+    // shared read-only data (grid, parasitic response, source PSDs)
+    struct context* context;
+    int contextstale; // a setter changed the configuration of the context, rebuilt by the next pll_calculate
+    struct vector* f;
+    struct vector* s;
+
+    // Phase Detector
+    double detectorgain;
+    double Sphasedetector0;
+    struct vector* Nphasedetector;
+    struct vector* Stot_phasedetector;
+
+    // Charge Pump
+    double gm;
+    double Scp0;
+    double fccp;
+    struct vector* Ncp;
+    struct vector* Stot_cp;
+
+    // oscillator
+    double min_Kvco;
+    double max_Kvco;
+    double Svco0;
+    double dfvco0;
+    double dfvco0fc;
+    const struct measurement* vcoprofile; // replaces the analytic model if set
+    struct vector* Hvco;
+    struct vector* Nvco;
+    struct vector* Stot_vco;
+
+    // Filter
+    double Rf;
+    double Cf;
+    double Cfx;
+    struct vector* Hfilter;
+    struct vector* Hfilter_denominator;
+    double filterkey[3]; // Rf, Cf and Cfx of the values in Hfilter
+    int filtervalid;
+    struct vector* Nfilter;
+    struct vector* Stot_filter;
+
+    // Reference
+    double Sref0;
+    double dfref0;
+    double dfref0fc;
+    const struct measurement* refprofile; // replaces the analytic model if set
+    struct vector* Nref;
+    struct vector* Stot_ref;
+
+    // Parasitic Poles
+    double* parpoles;
+    size_t numparpoles;
+
+    // Jitter integration band (whole range if fupper <= flower) and additional bands (e.g. jitter masks)
+    struct noise_band jitterband;
+    struct noise_band* bands;
+    size_t numbands;
+    double* Jrms_bands; // numbands * 2
+
+    // Loop Transfer Functions
+    struct vector* Hloop;
+    struct vector* Hclosedloop;
+    struct vector* Hclosedloop_denominator;
+    struct vector* Stot;
+
+    // evaluation of one Kvco corner including the integrated noise (areas): a kernel specialized for the topology
+    // (see pll_kernel.h) or the generic vector implementation
+    // (the specialized kernels do not store the noise transfer functions, Hvco and the denominators)
+    void (*kernel)(struct pll_state* state, double Kvco, unsigned int k, double* areas);
+    int generic; // always use the vector implementation
+
+    // temporaries of pll_calculate (reset at the end of each call, one per state and therefore per thread)
+    struct workspace* workspace;
+
+    // intermediates reused by the last pll_calculate (PLL_REUSE_* bits)
+    unsigned int reused;
+
+    // Results (one each for both min_Kvco and max_Kvco)
+    double Jrms[2];
+    double Jrms_vco[2];
+    double Jrms_ref[2];
+    double Jrms_cp[2];
+    double Jrms_filter[2];
+    double f0dB[2];
+    double phasemargin[2];
+    double fbw[2];
+};
+
+#endif /* PLL_PLL_INTERNAL_H */
@@ -0,0 +1,109 @@
+// Template of the fused evaluation kernel of one Kvco corner of pll_calculate (no include guard: pll.c includes it
+// once per specialization). Parameters (removed again at the end):
+//   PLL_KERNEL_NAME       name of the generated function
+//   PLL_KERNEL_PARASITIC  0: no parasitic poles (Hparasitic is all ones and is not read)
+//   PLL_KERNEL_UNITY      1: N = M = 1 (no divider scaling)
+//   PLL_KERNEL_BANDED     0: jitter over the whole range, the spectra are integrated in the same pass
+// The kernel computes Hloop, Hclosedloop, the effective noise contributions and their integrals in one pass over the grid
+// with the operations of the vector implementation in the same order, except that |x|^2 is re^2 + im^2 instead of the
+// square of cabs (the results agree to rounding, see the regression suite). Only Hloop, Hclosedloop, the Stot_* vectors
+// and Stot are stored, the noise transfer functions, Hvco and Hclosedloop_denominator stay in registers.
+
+static void PLL_KERNEL_NAME(struct pll_state* state, double Kvco, unsigned int k, double* areas)
+{
+    size_t samples = state->context->samples;
+    const double complex* s = vector_data(state->s);
+    const double complex* Hfilter = vector_data(state->Hfilter);
+#if PLL_KERNEL_PARASITIC
+    const double complex* Hparasitic = vector_data(state->context->Hparasitic);
+#endif
+    const double complex* Sref = vector_data(state->context->Sref);
+    const double complex* Svco = vector_data(state->context->Svco);
+    const double complex* Scp = vector_data(state->context->Scp);
+    const double complex* Sphasedetector = vector_data(state->context->Sphasedetector);
+    double complex* Hloop = vector_data(state->Hloop);
+    double complex* Hclosedloop = vector_data(state->Hclosedloop);
+    double complex* Stot_ref = vector_data(state->Stot_ref);
+    double complex* Stot_vco = vector_data(state->Stot_vco);
+    double complex* Stot_cp = vector_data(state->Stot_cp);
+    double complex* Stot_phasedetector = vector_data(state->Stot_phasedetector);
+    double complex* Stot_filter = vector_data(state->Stot_filter);
+    double complex* Stot = vector_data(state->Stot);
+
+    double complex vcogain = 2 * CONSTANTS_PI * Kvco;
+    double complex loopgain = state->detectorgain * state->gm;
+    double complex cpgain = 1 / (state->detectorgain * state->gm);
+    double complex gm = state->gm;
+    double Sfilter0 = 1.657e-20 * state->Rf;
+#if PLL_KERNEL_UNITY
+    double complex refgain = k;
+#else
+    double complex feedback = 1.0 / state->N;
+    double complex refgain = k / state->M; // integer division, like in the vector implementation
+#endif
+#if !PLL_KERNEL_BANDED
+    const double complex* f = vector_data(state->f);
+    double previous[PLL_NUM_AREAS];
+    for(size_t j = 0; j < PLL_NUM_AREAS; ++j)
+    {
+        areas[j] = 0;
+    }
+#endif
+
+    for(size_t i = 0; i < samples; ++i)
+    {
+        double complex vco = vcogain / s[i];
+        double complex loop = Hfilter[i] * loopgain * vco;
+#if PLL_KERNEL_PARASITIC
+        loop *= Hparasitic[i];
+#endif
+#if PLL_KERNEL_UNITY
+        double complex denominator = loop + 1;
+#else
+        double complex denominator = loop * feedback + 1;
+#endif
+        double complex closed = loop / denominator;
+        Hloop[i] = loop;
+        Hclosedloop[i] = closed;
+
+        double complex ref = _abs_squared(closed * refgain) * Sref[i];
+        double complex osc = _abs_squared((double complex)1 / denominator) * Svco[i];
+        double complex cp = closed * cpgain;
+        double complex pump = _abs_squared(cp) * Scp[i];
+        double complex detector = _abs_squared(gm * Hfilter[i] * vco / denominator) * Sphasedetector[i];
+        double complex filter = _abs_squared(cp / Hfilter[i]) * Sfilter0;
+        double complex total = ref + osc + pump + detector + filter;
+        Stot_ref[i] = ref;
+        Stot_vco[i] = osc;
+        Stot_cp[i] = pump;
+        Stot_phasedetector[i] = detector;
+        Stot_filter[i] = filter;
+        Stot[i] = total;
+
+#if !PLL_KERNEL_BANDED
+        double current[PLL_NUM_AREAS] = { creal(total), creal(osc), creal(ref), creal(pump), creal(filter) };
+        if(i > 0)
+        {
+            double flower = creal(f[i - 1]);
+            double ratio = creal(f[i]) / flower;
+            double logratio = log(ratio);
+            for(size_t j = 0; j < PLL_NUM_AREAS; ++j)
+            {
+                areas[j] += _power_law_area(previous[j], current[j], flower, ratio, logratio);
+            }
+        }
+        for(size_t j = 0; j < PLL_NUM_AREAS; ++j)
+        {
+            previous[j] = current[j];
+        }
+#endif
+    }
+#if PLL_KERNEL_BANDED
+    _integrate_areas(state, areas);
+#endif
+}
+
+#undef PLL_KERNEL_NAME
+#undef PLL_KERNEL_PARASITIC
+#undef PLL_KERNEL_UNITY
+#undef PLL_KERNEL_BANDED
@@ -0,0 +1,773 @@
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "expression.h"
+#include "measurement.h"
+#include "memory.h"
+#include "noise.h"
+#include "parameter.h"
+#include "plan.h"
+#include "pll.h"
+#include "pll_internal.h"
+#include "vector.h"
+#include "worstcase.h"
+
+// accuracy-vs-speed regression suite: every evaluation mode is run on a corpus of configurations and designs and compared
+// to golden data, reporting the maximum relative error per metric and the speedup
+// regression.golden was computed with the pll_calculate of the first commit (only its parasitic pole loop corrected,
+// the band configuration integrated over the band separately), so the reference path is checked against it as well
+// the cost expressions are checked as well: precedence and parse errors on fixed cases, and the bytecode against the same
+// formula in C on the golden metrics
+// the additional jitter bands are checked against noise_trapzS_band of the total spectrum integrated over each band separately
+// usage: regression [--generate] [FILE] (default: regression.golden)
+// --generate writes the golden data with the current reference path, only do this after the reference path was verified
+// (e.g. against the Octave model in main.m); the exit status is 1 if a mode exceeds its tolerance
+
+#define REGRESSION_MAX_POLES 2
+#define REGRESSION_MIN_TIME 0.2 // seconds of evaluations per mode for the timing
+
+struct configuration {
+    const char* name;
+    double fref;
+    double fsig;
+    unsigned int N;
+    unsigned int M;
+    double min_Kvco;
+    double max_Kvco;
+    double poles[REGRESSION_MAX_POLES];
+    size_t numpoles;
+    double flower; // jitter band (both 0: whole range)
+    double fupper;
+    int flowerexp;
+    int fupperexp;
+    unsigned int pointsperdecade;
+};
+
+struct design {
+    double Rf;
+    double Cf;
+    double Cfx;
+};
+
+static const struct configuration configurations[] = {
+    { "main",       875e6,   56e9, 1, 1, 1.2e9, 1.2e9, { -1e10, -1e13 }, 2, 0, 0, 3, 12, 10 },
+    { "no-poles",   875e6,   56e9, 1, 1, 1.2e9, 1.2e9, { 0 },            0, 0, 0, 3, 12, 10 },
+    { "kvco-range", 875e6,   56e9, 1, 1, 0.2e9, 1.2e9, { -1e10, -1e13 }, 2, 0, 0, 3, 12, 10 },
+    { "divided",    437.5e6, 56e9, 2, 1, 1.2e9, 1.2e9, { -5e9 },         1, 0, 0, 3, 12, 10 },
+    { "band",       875e6,   56e9, 1, 1, 1.2e9, 1.2e9, { -1e10, -1e13 }, 2, 1e4, 1e8, 3, 12, 10 },
+    { "fine-grid",  875e6,   56e9, 1, 1, 1.2e9, 1.2e9, { -1e10 },        1, 0, 0, 4, 11, 20 },
+};
+#define REGRESSION_NUM_CONFIGURATIONS (sizeof(configurations) / sizeof(configurations[0]))
+
+static const struct design designs[] = {
+    { 1.0e3, 200e-12, 0 },
+    { 500,   60e-12,  0 },
+    { 2.0e3, 100e-12, 10e-12 },
+    { 5.0e3, 30e-12,  1.5e-12 },
+};
+#define REGRESSION_NUM_DESIGNS (sizeof(designs) / sizeof(designs[0]))
+
+// golden data of one design: results of both corners and the spectra of the maximum Kvco corner
+struct golden {
+    struct pll_results results;
+    size_t samples;
+    double* Stot;
+    double* Hloop; // magnitude
+};
+
+// evaluation mode: evaluates all designs on a prepared state, metrics that a mode does not provide are NaN
+struct mode {
+    const char* name;
+    unsigned int pointsperdecade; // 0: grid of the configuration
+    double tolerance; // maximum accepted relative error of all compared metrics (INFINITY: report only)
+    int spectra; // the mode is pll_calculate on the golden grid, so the spectra are compared as well
+    void (*evaluate)(struct pll_state* state, struct pll_results* results);
+    int (*prepare)(struct pll_state* state); // optional, after the state of a configuration was created (0: failed)
+};
+
+static struct pll_state* _create_state(const struct configuration* configuration, unsigned int pointsperdecade)
+{
+    struct pll_state* state = pll_create();
+    pll_set_eval_frequencies(state, configuration->flowerexp, configuration->fupperexp, pointsperdecade ? pointsperdecade : configuration->pointsperdecade);
+    pll_set_input_output_frequencies(state, configuration->fref, configuration->fsig);
+    pll_set_feedback_divider(state, configuration->N);
+    pll_set_reference_divider(state, configuration->M);
+    pll_set_phase_detector_gain(state, 0.45);
+    pll_set_vco_gain(state, configuration->min_Kvco, configuration->max_Kvco);
+    pll_set_vco_noise(state, 1e6, -90.0, 1e5);
+    pll_set_reference_noise(state, 1e3, -139, 1e-3);
+    for(size_t i = 0; i < configuration->numpoles; ++i)
+    {
+        pll_add_parasitic_pole(state, configuration->poles[i]);
+    }
+    pll_set_jitter_band(state, configuration->flower, configuration->fupper);
+    pll_set_chargepump_gain(state, 200e-6);
+    pll_set_chargepump_noise(state, 1e-22, 1e7);
+    pll_set_filter(state, designs[0].Rf, designs[0].Cf, designs[0].Cfx);
+    pll_initialize(state);
+    return state;
+}
+
+static void _set_nan(struct pll_results* results)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        results->Jrms[i] = NAN;
+        results->Jrms_vco[i] = NAN;
+        results->Jrms_ref[i] = NAN;
+        results->Jrms_cp[i] = NAN;
+        results->Jrms_filter[i] = NAN;
+        results->f0dB[i] = NAN;
+        results->phasemargin[i] = NAN;
+        results->fbw[i] = NAN;
+    }
+}
+
+static void _evaluate_calculate(struct pll_state* state, struct pll_results* results)
+{
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+        pll_calculate(state);
+        pll_get_results(state, &results[d]);
+    }
+}
+
+// every mode has its own states, so the state stays on the generic path for the spectra as well
+static void _evaluate_reference(struct pll_state* state, struct pll_results* results)
+{
+    pll_set_generic_kernel(state, 1);
+    _evaluate_calculate(state, results);
+}
+
+static void _evaluate_batch(struct pll_state* state, struct pll_results* results)
+{
+    double Rf[REGRESSION_NUM_DESIGNS];
+    double Cf[REGRESSION_NUM_DESIGNS];
+    double Cfx[REGRESSION_NUM_DESIGNS];
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        _set_nan(&results[d]);
+        Rf[d] = designs[d].Rf;
+        Cf[d] = designs[d].Cf;
+        Cfx[d] = designs[d].Cfx;
+    }
+    struct batch_input input = { Rf, Cf, Cfx, NULL, NULL, NULL };
+    for(size_t corner = 0; corner < 2; ++corner)
+    {
+        double phasemargin[REGRESSION_NUM_DESIGNS];
+        double f0dB[REGRESSION_NUM_DESIGNS];
+        double fbw[REGRESSION_NUM_DESIGNS];
+        double Jrms[REGRESSION_NUM_DESIGNS];
+        struct batch_output output = { phasemargin, f0dB, fbw, Jrms };
+        batch_calculate(state, &input, &output, REGRESSION_NUM_DESIGNS, corner);
+        for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+        {
+            results[d].phasemargin[corner] = phasemargin[d];
+            results[d].f0dB[corner] = f0dB[d];
+            results[d].fbw[corner] = fbw[d];
+            results[d].Jrms[corner] = Jrms[d];
+        }
+    }
+}
+
+static void _evaluate_worstcase(struct pll_state* state, struct pll_results* results)
+{
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        _set_nan(&results[d]);
+        pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+        struct worstcase* worstcase = worstcase_create(state);
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            double values[WORSTCASE_NUM_METRICS];
+            worstcase_evaluate(worstcase, corner == 0 ? state->min_Kvco : state->max_Kvco, values);
+            results[d].phasemargin[corner] = values[WORSTCASE_PHASEMARGIN];
+            results[d].f0dB[corner] = values[WORSTCASE_UNITY_GAIN_FREQUENCY];
+            results[d].fbw[corner] = values[WORSTCASE_BANDWIDTH];
+            results[d].Jrms[corner] = values[WORSTCASE_JRMS];
+        }
+        worstcase_destroy(worstcase);
+    }
+}
+
+static double _score_phasemargin(double phasemargin, double fbw, double Jrms)
+{
+    (void)fbw;
+    (void)Jrms;
+    return -phasemargin;
+}
+
+// frequency plan: every design is a one-point filter grid, the plan of the configuration (its fref, N and M) is picked from
+// the enumeration, plans are only scored with the minimum Kvco, so the maximum corner is run with a fixed Kvco
+static void _evaluate_plan(struct pll_state* state, struct pll_results* results)
+{
+    double min_Kvco = state->min_Kvco;
+    double max_Kvco = state->max_Kvco;
+    struct plan* plan = plan_create();
+    plan_add_reference(plan, state->fref);
+    plan_set_divider_range(plan, state->N, state->M);
+    plan_set_bandwidth_ratio(plan, INFINITY);
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        _set_nan(&results[d]);
+        pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+        struct parameter* Rf = parameter_create(designs[d].Rf, designs[d].Rf, 1);
+        struct parameter* Cf = parameter_create(designs[d].Cf, designs[d].Cf, 1);
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            double Kvco = corner == 0 ? min_Kvco : max_Kvco;
+            pll_set_vco_gain(state, Kvco, Kvco);
+            size_t count = plan_run(plan, state, Rf, Cf, _score_phasemargin);
+            for(size_t p = 0; p < count; ++p)
+            {
+                const struct plan_result* result = plan_get_result(plan, p);
+                if(result->valid && result->N == state->N && result->M == state->M)
+                {
+                    results[d].phasemargin[corner] = result->phasemargin;
+                    results[d].f0dB[corner] = result->f0dB;
+                    results[d].fbw[corner] = result->fbw;
+                    results[d].Jrms[corner] = result->Jrms;
+                }
+            }
+        }
+        parameter_destroy(Rf);
+        parameter_destroy(Cf);
+    }
+    pll_set_vco_gain(state, min_Kvco, max_Kvco);
+    plan_destroy(plan);
+}
+
+// measured profiles: the analytic L(f) of the configuration is sampled on its grid and loaded back from a text file,
+// the log-log interpolation reproduces the samples, so the results must match the analytic models to rounding
+static struct measurement* profiles[2];
+
+static struct measurement* _sample_profile(struct vector* f, struct vector* S)
+{
+    char filename[] = "/tmp/regression-profile-XXXXXX";
+    int descriptor = mkstemp(filename);
+    FILE* file = descriptor >= 0 ? fdopen(descriptor, "w") : NULL;
+    if(!file)
+    {
+        fprintf(stderr, "regression: could not create a temporary profile\n");
+        return NULL;
+    }
+    for(size_t k = 0; k < vector_size(f); ++k)
+    {
+        fprintf(file, "%.17g %.17g\n", creal(vector_get(f, k)), 10 * log10(creal(vector_get(S, k)) / 2));
+    }
+    fclose(file);
+    struct measurement* profile = measurement_load(filename);
+    remove(filename);
+    return profile;
+}
+
+static int _prepare_profiles(struct pll_state* state)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        if(profiles[i])
+        {
+            measurement_destroy(profiles[i]);
+        }
+    }
+    profiles[0] = _sample_profile(state->f, state->context->Svco);
+    profiles[1] = _sample_profile(state->f, state->context->Sref);
+    if(!profiles[0] || !profiles[1])
+    {
+        return 0;
+    }
+    pll_set_vco_noise_profile(state, profiles[0]);
+    pll_set_reference_noise_profile(state, profiles[1]);
+    pll_initialize(state);
+    return 1;
+}
+
+static const struct mode modes[] = {
+    { "reference",           0, 1e-12,    1, _evaluate_reference, NULL },
+    { "specialized kernels", 0, 1e-12,    1, _evaluate_calculate, NULL },
+    { "measured profiles",   0, 1e-9,     1, _evaluate_calculate, _prepare_profiles },
+    { "batch",               0, 1e-9,     0, _evaluate_batch,     NULL },
+    { "worstcase probe",     0, 1e-9,     0, _evaluate_worstcase, NULL },
+    { "frequency plan",      0, 1e-9,     0, _evaluate_plan,      NULL },
+    { "coarse grid (5/dec)", 5, INFINITY, 0, _evaluate_calculate, NULL },
+};
+#define REGRESSION_NUM_MODES (sizeof(modes) / sizeof(modes[0]))
+
+static double _elapsed(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
+
+// relative error, a metric that only one side could determine counts as infinite error
+static double _relative_error(double value, double golden)
+{
+    if(isnan(value) || isnan(golden))
+    {
+        return isnan(value) && isnan(golden) ? 0.0 : INFINITY;
+    }
+    if(value == golden)
+    {
+        return 0.0;
+    }
+    return fabs(value - golden) / fabs(golden);
+}
+
+static double _max(double a, double b)
+{
+    return a > b || isnan(b) ? a : b;
+}
+
+static void _capture_spectra(const struct pll_state* state, struct golden* golden)
+{
+    golden->samples = vector_size(state->Stot);
+    golden->Stot = memory_allocate(golden->samples * sizeof(*golden->Stot));
+    golden->Hloop = memory_allocate(golden->samples * sizeof(*golden->Hloop));
+    const double complex* S = vector_data(state->Stot);
+    const double complex* H = vector_data(state->Hloop);
+    for(size_t k = 0; k < golden->samples; ++k)
+    {
+        golden->Stot[k] = creal(S[k]);
+        golden->Hloop[k] = cabs(H[k]);
+    }
+}
+
+static int _generate(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    fprintf(file, "# golden data of the reference path (regression --generate)\n");
+    for(size_t c = 0; c < REGRESSION_NUM_CONFIGURATIONS; ++c)
+    {
+        struct pll_state* state = _create_state(&configurations[c], 0);
+        pll_set_generic_kernel(state, 1);
+        for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+        {
+            pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+            pll_calculate(state);
+            struct golden golden;
+            pll_get_results(state, &golden.results);
+            _capture_spectra(state, &golden);
+            const struct pll_results* r = &golden.results;
+            fprintf(file, "design %s %zu %zu\n", configurations[c].name, d, golden.samples);
+            for(size_t i = 0; i < 2; ++i)
+            {
+                fprintf(file, "%.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n", r->Jrms[i], r->Jrms_vco[i], r->Jrms_ref[i], r->Jrms_cp[i], r->Jrms_filter[i], r->f0dB[i], r->phasemargin[i], r->fbw[i]);
+            }
+            for(size_t k = 0; k < golden.samples; ++k)
+            {
+                fprintf(file, "%.17g %.17g\n", golden.Stot[k], golden.Hloop[k]);
+            }
+            memory_free(golden.Stot);
+            memory_free(golden.Hloop);
+        }
+        pll_cleanup(state);
+    }
+    fclose(file);
+    printf("golden data of %zu configurations with %zu designs each written to '%s'\n", REGRESSION_NUM_CONFIGURATIONS, REGRESSION_NUM_DESIGNS, filename);
+    return 1;
+}
+
+// golden[c * REGRESSION_NUM_DESIGNS + d]
+static int _load(const char* filename, struct golden* golden)
+{
+    FILE* file = fopen(filename, "r");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for reading\n", filename);
+        return 0;
+    }
+    char line[256];
+    int ok = fgets(line, sizeof(line), file) != NULL && line[0] == '#';
+    size_t loaded = 0;
+    for(size_t c = 0; ok && c < REGRESSION_NUM_CONFIGURATIONS; ++c)
+    {
+        for(size_t d = 0; ok && d < REGRESSION_NUM_DESIGNS; ++d)
+        {
+            struct golden* g = &golden[c * REGRESSION_NUM_DESIGNS + d];
+            char name[64];
+            size_t index;
+            ok = fscanf(file, " design %63s %zu %zu", name, &index, &g->samples) == 3 && strcmp(name, configurations[c].name) == 0 && index == d;
+            struct pll_results* r = &g->results;
+            for(size_t i = 0; ok && i < 2; ++i)
+            {
+                ok = fscanf(file, "%lf %lf %lf %lf %lf %lf %lf %lf", &r->Jrms[i], &r->Jrms_vco[i], &r->Jrms_ref[i], &r->Jrms_cp[i], &r->Jrms_filter[i], &r->f0dB[i], &r->phasemargin[i], &r->fbw[i]) == 8;
+            }
+            if(!ok)
+            {
+                break;
+            }
+            g->Stot = memory_allocate(g->samples * sizeof(*g->Stot));
+            g->Hloop = memory_allocate(g->samples * sizeof(*g->Hloop));
+            ++loaded;
+            for(size_t k = 0; ok && k < g->samples; ++k)
+            {
+                ok = fscanf(file, "%lf %lf", &g->Stot[k], &g->Hloop[k]) == 2;
+            }
+        }
+    }
+    fclose(file);
+    if(!ok)
+    {
+        fprintf(stderr, "regression: '%s' does not match the corpus (regenerate it with --generate)\n", filename);
+        for(size_t i = 0; i < loaded; ++i)
+        {
+            memory_free(golden[i].Stot);
+            memory_free(golden[i].Hloop);
+        }
+    }
+    return ok;
+}
+
+enum column {
+    COLUMN_PHASEMARGIN,
+    COLUMN_F0DB,
+    COLUMN_FBW,
+    COLUMN_JRMS,
+    COLUMN_CONTRIBUTIONS,
+    COLUMN_SPECTRUM,
+    NUM_COLUMNS
+};
+
+static void _compare(const struct pll_results* results, const struct pll_results* golden, double* errors)
+{
+    for(size_t i = 0; i < 2; ++i)
+    {
+        errors[COLUMN_PHASEMARGIN] = _max(errors[COLUMN_PHASEMARGIN], _relative_error(results->phasemargin[i], golden->phasemargin[i]));
+        errors[COLUMN_F0DB] = _max(errors[COLUMN_F0DB], _relative_error(results->f0dB[i], golden->f0dB[i]));
+        errors[COLUMN_FBW] = _max(errors[COLUMN_FBW], _relative_error(results->fbw[i], golden->fbw[i]));
+        errors[COLUMN_JRMS] = _max(errors[COLUMN_JRMS], _relative_error(results->Jrms[i], golden->Jrms[i]));
+        if(!isnan(results->Jrms_vco[i]))
+        {
+            errors[COLUMN_CONTRIBUTIONS] = _max(errors[COLUMN_CONTRIBUTIONS], _relative_error(results->Jrms_vco[i], golden->Jrms_vco[i]));
+            errors[COLUMN_CONTRIBUTIONS] = _max(errors[COLUMN_CONTRIBUTIONS], _relative_error(results->Jrms_ref[i], golden->Jrms_ref[i]));
+            errors[COLUMN_CONTRIBUTIONS] = _max(errors[COLUMN_CONTRIBUTIONS], _relative_error(results->Jrms_cp[i], golden->Jrms_cp[i]));
+            errors[COLUMN_CONTRIBUTIONS] = _max(errors[COLUMN_CONTRIBUTIONS], _relative_error(results->Jrms_filter[i], golden->Jrms_filter[i]));
+        }
+    }
+}
+
+// spectra (maximum Kvco corner) of the reference path for all designs of a configuration
+static void _compare_spectra(struct pll_state* state, const struct golden* golden, double* errors)
+{
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+        pll_calculate(state);
+        struct golden current;
+        _capture_spectra(state, &current);
+        if(current.samples != golden[d].samples)
+        {
+            errors[COLUMN_SPECTRUM] = INFINITY;
+        }
+        for(size_t k = 0; k < current.samples && k < golden[d].samples; ++k)
+        {
+            errors[COLUMN_SPECTRUM] = _max(errors[COLUMN_SPECTRUM], _relative_error(current.Stot[k], golden[d].Stot[k]));
+            errors[COLUMN_SPECTRUM] = _max(errors[COLUMN_SPECTRUM], _relative_error(current.Hloop[k], golden[d].Hloop[k]));
+        }
+        memory_free(current.Stot);
+        memory_free(current.Hloop);
+    }
+}
+
+// constant expressions (the whole expression is folded) and their values, invalid expressions must be rejected
+struct expression_case {
+    const char* text;
+    int valid;
+    double value;
+};
+
+static const struct expression_case expressioncases[] = {
+    { "1 + 2 * 3",            1, 7 },
+    { "(1 + 2) * 3",          1, 9 },
+    { "2 - 3 - 4",            1, -5 },
+    { "8 / 4 / 2",            1, 1 },
+    { "-2 ^ 2",               1, -4 },
+    { "2 ^ 3 ^ 2",            1, 512 },
+    { "1 + 2 < 4",            1, 1 },
+    { "1 < 2 == 1",           1, 1 },
+    { "1 || 0 && 0",          1, 1 },
+    { "!0 + 1",               1, 2 },
+    { "2 != 2 ? 5 : 6",       1, 6 },
+    { "0 ? 1 : 0 ? 2 : 3",    1, 3 },
+    { "1 ? nan : 4",          1, NAN },
+    { "min(3, max(1, 2))",    1, 2 },
+    { "pow(2, 10) - 2^10",    1, 0 },
+    { "log10(1e3) + abs(-1)", 1, 4 },
+    { "1 +",                  0, 0 },
+    { "(1 + 2",               0, 0 },
+    { "foo * 2",              0, 0 },
+    { "min(1)",               0, 0 },
+    { "1 2",                  0, 0 },
+    { "",                     0, 0 },
+};
+#define REGRESSION_NUM_EXPRESSION_CASES (sizeof(expressioncases) / sizeof(expressioncases[0]))
+
+// the cost function of the expression example (see expression.h) on all symbols
+#define REGRESSION_COST_EXPRESSION "10*abs(pm-70) + (fbw>2e6 ? inf : 0) + jrms/50e-15 + (jrms_vco+jrms_ref+jrms_cp+jrms_filter)/1e-13 + f0db/1e9 + rf*cf/1e-9 + sqrt(cfx*1e12) - log(gm)"
+
+static double _cost_reference(const double* v)
+{
+    return 10 * fabs(v[EXPRESSION_PHASEMARGIN] - 70) + (v[EXPRESSION_BANDWIDTH] > 2e6 ? INFINITY : 0) + v[EXPRESSION_JRMS] / 50e-15
+        + (v[EXPRESSION_JRMS_VCO] + v[EXPRESSION_JRMS_REF] + v[EXPRESSION_JRMS_CP] + v[EXPRESSION_JRMS_FILTER]) / 1e-13
+        + v[EXPRESSION_F0DB] / 1e9 + v[EXPRESSION_RF] * v[EXPRESSION_CF] / 1e-9 + sqrt(v[EXPRESSION_CFX] * 1e12) - log(v[EXPRESSION_GM]);
+}
+
+// returns the number of failed checks
+static size_t _check_expressions(const struct golden* golden)
+{
+    size_t failed = 0;
+    for(size_t i = 0; i < REGRESSION_NUM_EXPRESSION_CASES; ++i)
+    {
+        const struct expression_case* c = &expressioncases[i];
+        int invalid = !c->valid;
+        struct expression* expression = expression_compile(c->text);
+        if(!expression)
+        {
+            if(!invalid)
+            {
+                fprintf(stderr, "regression: expression '%s' was rejected\n", c->text);
+                ++failed;
+            }
+            continue;
+        }
+        double values[EXPRESSION_NUM_SYMBOLS] = { 0 };
+        double value = expression_evaluate(expression, values);
+        if(invalid || _relative_error(value, c->value) != 0.0 || expression_get_num_instructions(expression) != 0)
+        {
+            fprintf(stderr, "regression: expression '%s' = %g (%zu instructions), expected %s%g\n", c->text, value, expression_get_num_instructions(expression), invalid ? "an error instead of " : "", c->value);
+            ++failed;
+        }
+        expression_destroy(expression);
+    }
+
+    struct expression* cost = expression_compile(REGRESSION_COST_EXPRESSION);
+    if(!cost)
+    {
+        return failed + 1;
+    }
+    for(size_t i = 0; i < REGRESSION_NUM_CONFIGURATIONS * REGRESSION_NUM_DESIGNS; ++i)
+    {
+        const struct pll_results* r = &golden[i].results;
+        const struct design* design = &designs[i % REGRESSION_NUM_DESIGNS];
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            double values[EXPRESSION_NUM_SYMBOLS] = {
+                [EXPRESSION_PHASEMARGIN] = r->phasemargin[corner],
+                [EXPRESSION_F0DB] = r->f0dB[corner],
+                [EXPRESSION_BANDWIDTH] = r->fbw[corner],
+                [EXPRESSION_JRMS] = r->Jrms[corner],
+                [EXPRESSION_JRMS_VCO] = r->Jrms_vco[corner],
+                [EXPRESSION_JRMS_REF] = r->Jrms_ref[corner],
+                [EXPRESSION_JRMS_CP] = r->Jrms_cp[corner],
+                [EXPRESSION_JRMS_FILTER] = r->Jrms_filter[corner],
+                [EXPRESSION_RF] = design->Rf,
+                [EXPRESSION_CF] = design->Cf,
+                [EXPRESSION_CFX] = design->Cfx,
+                [EXPRESSION_GM] = 200e-6,
+            };
+            double value = expression_evaluate(cost, values);
+            double reference = _cost_reference(values);
+            if(_relative_error(value, reference) > 1e-15)
+            {
+                fprintf(stderr, "regression: cost expression = %.17g, expected %.17g (design %zu, corner %zu)\n", value, reference, i, corner);
+                ++failed;
+            }
+        }
+    }
+    expression_destroy(cost);
+    return failed;
+}
+
+// overlapping, nested, narrower than a grid step and partly outside of the grid
+static const struct noise_band bands[] = {
+    { 1e4, 1e8 },
+    { 1e3, 1e5 },
+    { 1e6, 1e10 },
+    { 1.2e5, 1.3e5 },
+    { 1e2, 1e14 },
+    { 5e7, 5e7 },
+};
+#define REGRESSION_NUM_BANDS (sizeof(bands) / sizeof(bands[0]))
+#define REGRESSION_BAND_TOLERANCE 1e-12
+#define REGRESSION_BAND_CONFIGURATION 2 // kvco-range, the corners differ
+
+// the total spectrum of the last calculated corner is kept in the state, so every corner is calculated on its own state
+// with both Kvco at the corner and compared to the same corner of a state that evaluates both corners in one calculation
+static size_t _check_bands(void)
+{
+    size_t failed = 0;
+    struct configuration configuration = configurations[REGRESSION_BAND_CONFIGURATION];
+    struct pll_state* state = _create_state(&configuration, 0);
+    for(size_t j = 0; j < REGRESSION_NUM_BANDS; ++j)
+    {
+        pll_add_jitter_band(state, bands[j].flower, bands[j].fupper);
+    }
+    for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+    {
+        pll_set_filter(state, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+        pll_calculate(state);
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            configuration.min_Kvco = corner ? configurations[REGRESSION_BAND_CONFIGURATION].max_Kvco : configurations[REGRESSION_BAND_CONFIGURATION].min_Kvco;
+            configuration.max_Kvco = configuration.min_Kvco;
+            struct pll_state* single = _create_state(&configuration, 0);
+            pll_set_filter(single, designs[d].Rf, designs[d].Cf, designs[d].Cfx);
+            pll_calculate(single);
+            for(size_t j = 0; j < REGRESSION_NUM_BANDS; ++j)
+            {
+                double reference = noise_area_to_RMSjitter(configuration.fsig, noise_trapzS_band(single->f, single->Stot, bands[j].flower, bands[j].fupper));
+                double value = pll_get_band_jitter(state, j, corner);
+                if(_relative_error(value, reference) > REGRESSION_BAND_TOLERANCE)
+                {
+                    fprintf(stderr, "regression: band %zu [%g, %g] Hz: Jrms = %.17g, expected %.17g (design %zu, corner %zu)\n", j, bands[j].flower, bands[j].fupper, value, reference, d, corner);
+                    ++failed;
+                }
+            }
+            pll_cleanup(single);
+        }
+    }
+    pll_cleanup(state);
+    return failed;
+}
+
+static void _print_error(double error, int available)
+{
+    if(!available)
+    {
+        printf(" %9s", "-");
+    }
+    else
+    {
+        printf(" %9.2e", error);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int generate = 0;
+    const char* filename = "regression.golden";
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--generate") == 0)
+        {
+            generate = 1;
+        }
+        else if(argv[i][0] != '-')
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--generate] [FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(generate)
+    {
+        return _generate(filename) ? 0 : 1;
+    }
+
+    struct golden golden[REGRESSION_NUM_CONFIGURATIONS * REGRESSION_NUM_DESIGNS];
+    if(!_load(filename, golden))
+    {
+        return 1;
+    }
+    printf("%zu configurations x %zu designs, maximum relative error against '%s'\n\n", REGRESSION_NUM_CONFIGURATIONS, REGRESSION_NUM_DESIGNS, filename);
+    printf("%-20s %9s %9s %9s %9s %9s %9s %12s %8s\n", "mode", "PM", "f0dB", "fbw", "Jrms", "Jrms part", "spectrum", "us/design", "speedup");
+
+    int ok = 1;
+    double reference = 0.0;
+    for(size_t m = 0; m < REGRESSION_NUM_MODES; ++m)
+    {
+        const struct mode* mode = &modes[m];
+        double errors[NUM_COLUMNS] = { 0 };
+        int contributions = 0;
+        double elapsed = 0.0;
+        size_t evaluated = 0;
+        for(size_t c = 0; c < REGRESSION_NUM_CONFIGURATIONS; ++c)
+        {
+            struct pll_state* state = _create_state(&configurations[c], mode->pointsperdecade);
+            if(mode->prepare && !mode->prepare(state))
+            {
+                errors[COLUMN_JRMS] = INFINITY;
+            }
+            const struct golden* g = &golden[c * REGRESSION_NUM_DESIGNS];
+            struct pll_results results[REGRESSION_NUM_DESIGNS];
+            mode->evaluate(state, results);
+            for(size_t d = 0; d < REGRESSION_NUM_DESIGNS; ++d)
+            {
+                _compare(&results[d], &g[d].results, errors);
+                contributions = contributions || !isnan(results[d].Jrms_vco[0]);
+            }
+            if(mode->spectra)
+            {
+                _compare_spectra(state, g, errors);
+            }
+
+            // timing: repeat the whole set of designs (the per-design setup of a mode is part of its cost)
+            size_t repetitions = 0;
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            double time = 0.0;
+            while(time < REGRESSION_MIN_TIME / REGRESSION_NUM_CONFIGURATIONS)
+            {
+                mode->evaluate(state, results);
+                ++repetitions;
+                time = _elapsed(&start);
+            }
+            elapsed += time;
+            evaluated += repetitions * REGRESSION_NUM_DESIGNS;
+            pll_cleanup(state);
+        }
+        double perdesign = elapsed / evaluated;
+        if(m == 0)
+        {
+            reference = perdesign;
+        }
+        printf("%-20s", mode->name);
+        for(size_t i = 0; i < NUM_COLUMNS; ++i)
+        {
+            int available = i < COLUMN_CONTRIBUTIONS || (i == COLUMN_CONTRIBUTIONS && contributions) || (i == COLUMN_SPECTRUM && mode->spectra);
+            _print_error(errors[i], available);
+        }
+        double worst = _max(_max(errors[COLUMN_PHASEMARGIN], errors[COLUMN_F0DB]), _max(errors[COLUMN_FBW], errors[COLUMN_JRMS]));
+        worst = _max(worst, _max(errors[COLUMN_CONTRIBUTIONS], errors[COLUMN_SPECTRUM]));
+        int pass = !(worst > mode->tolerance);
+        printf(" %12.2f %7.2fx%s\n", 1e6 * perdesign, reference / perdesign, pass ? "" : "  FAIL");
+        ok = ok && pass;
+    }
+
+    for(size_t i = 0; i < 2; ++i)
+    {
+        if(profiles[i])
+        {
+            measurement_destroy(profiles[i]);
+        }
+    }
+    for(size_t i = 0; i < REGRESSION_NUM_CONFIGURATIONS * REGRESSION_NUM_DESIGNS; ++i)
+    {
+        memory_free(golden[i].Stot);
+        memory_free(golden[i].Hloop);
+    }
+    size_t failed = _check_expressions(golden);
+    printf("\nexpressions: %zu cases and the bytecode on %zu results, %zu failed\n", REGRESSION_NUM_EXPRESSION_CASES, 2 * REGRESSION_NUM_CONFIGURATIONS * REGRESSION_NUM_DESIGNS, failed);
+    ok = ok && failed == 0;
+    failed = _check_bands();
+    printf("bands: %zu jitter bands on %zu designs, %zu failed\n", REGRESSION_NUM_BANDS, REGRESSION_NUM_DESIGNS, failed);
+    ok = ok && failed == 0;
+
+    printf("\n%s\n", ok ? "all modes within their tolerance" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,424 @@
+#include "report.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "constants.h"
+#include "engineering.h"
+#include "memory.h"
+#include "pll_internal.h"
+#include "vector.h"
+
+#define REPORT_DEFAULT_BUDGET 200
+#define REPORT_NUM_COLORS 22
+
+struct report {
+    FILE* file;
+    size_t budget;
+    unsigned int indent;
+    int logx; // of the current axis
+};
+
+// taken from: https://sashamaps.net/docs/resources/20-colors/
+static const unsigned char colors[REPORT_NUM_COLORS][3] = {
+    {   0, 130, 200 }, // blue
+    { 230,  25,  75 }, // red
+    {  60, 180,  75 }, // green
+    { 255, 225,  25 }, // yellow
+    { 245, 130,  48 }, // orange
+    { 145,  30, 180 }, // purple
+    {  70, 240, 240 }, // cyan
+    { 240,  50, 230 }, // pink
+    { 210, 245,  60 }, // light green
+    { 250, 190, 212 }, // pig pink
+    {   0, 128, 128 }, // teal
+    { 220, 190, 255 }, // light purple
+    { 170, 110,  40 }, // ochre
+    { 255, 250, 200 }, // light yellow
+    { 128,   0,   0 }, // brown
+    { 170, 255, 195 }, // light turqouise
+    { 128, 128,   0 }, // slime green
+    { 255, 215, 180 }, // beige
+    {   0,   0, 128 }, // dark blue
+    { 128, 128, 128 }, // grey
+    { 255, 255, 255 }, // white
+    {   0,   0,   0 }, // black
+};
+
+static const char* pgfplotoptions[] = {
+    "compat=1.18",
+    "compat/show suggested version=false",
+    "scale only axis = true",
+    "scaled ticks=false",
+    "height = 5cm",
+    "axis line style = {thick}",
+    "tick align = inside",
+    "major tick length = {4pt}",
+    "minor tick length = {2pt}",
+    "every tick/.append style = {semithick, black}",
+    "every axis plot/.style={very thick, line join = round}",
+    "no markers",
+    "grid=both",
+    "grid style={black, line width = 0.4pt, dash pattern = on 0pt off 1.0pt, line cap = round}",
+    "enlarge x limits = false",
+    "enlarge y limits = false",
+    "legend cell align=left",
+    "legend style = {draw = none, at = {(0.5, -0.0)}, yshift = -1.2cm, anchor = north}",
+    "max space between ticks = 30",
+};
+
+static void _line(struct report* report, const char* format, ...)
+{
+    for(unsigned int i = 0; i < report->indent; ++i)
+    {
+        fputs("    ", report->file);
+    }
+    va_list args;
+    va_start(args, format);
+    vfprintf(report->file, format, args);
+    va_end(args);
+    fputc('\n', report->file);
+}
+
+static void _begin(struct report* report, const char* environment)
+{
+    _line(report, "\\begin{%s}", environment);
+    ++report->indent;
+}
+
+static void _end(struct report* report, const char* environment)
+{
+    --report->indent;
+    _line(report, "\\end{%s}", environment);
+}
+
+struct report* report_create(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return NULL;
+    }
+    struct report* report = memory_allocate_zeroed(1, sizeof(*report));
+    report->file = file;
+    report->budget = REPORT_DEFAULT_BUDGET;
+
+    _line(report, "\\documentclass[paper = a4, landscape, headinclude = false, footinclude = false, 10pt]{scrartcl}");
+    _line(report, "\\areaset{27cm}{20cm}");
+    _line(report, "\\usepackage[outline]{contour}");
+    _line(report, "\\usepackage{pgfplots}");
+    _line(report, "\\usepackage{siunitx}");
+    _line(report, "\\usepackage{booktabs}");
+    _line(report, "\\pagestyle{empty}");
+    for(size_t i = 0; i < REPORT_NUM_COLORS; ++i)
+    {
+        _line(report, "\\definecolor{plotcolor%zu}{RGB}{%u,%u,%u}", i + 1, colors[i][0], colors[i][1], colors[i][2]);
+    }
+    _line(report, "\\pgfplotsset{");
+    ++report->indent;
+    for(size_t i = 0; i < sizeof(pgfplotoptions) / sizeof(pgfplotoptions[0]); ++i)
+    {
+        _line(report, "%s,", pgfplotoptions[i]);
+    }
+    char cyclelist[REPORT_NUM_COLORS * 16] = "";
+    size_t length = 0;
+    for(size_t i = 0; i < REPORT_NUM_COLORS; ++i)
+    {
+        length += snprintf(cyclelist + length, sizeof(cyclelist) - length, "%splotcolor%zu", i > 0 ? ", " : "", i + 1);
+    }
+    _line(report, "cycle list = {%s},", cyclelist);
+    --report->indent;
+    _line(report, "}");
+    _begin(report, "document");
+    return report;
+}
+
+int report_close(struct report* report)
+{
+    _end(report, "document");
+    int ok = !ferror(report->file);
+    ok = fclose(report->file) == 0 && ok;
+    memory_free(report);
+    return ok;
+}
+
+void report_set_point_budget(struct report* report, size_t budget)
+{
+    report->budget = budget;
+}
+
+void report_paragraph(struct report* report, const char* text)
+{
+    _line(report, "\\par");
+    _line(report, "%s", text);
+    _line(report, "\\par");
+}
+
+size_t report_decimate(const double* x, const double* y, size_t count, size_t budget, size_t* indices)
+{
+    if(count <= budget)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            indices[i] = i;
+        }
+        return count;
+    }
+    if(budget < 3)
+    {
+        // only the end points
+        indices[0] = 0;
+        if(budget == 2)
+        {
+            indices[1] = count - 1;
+        }
+        return budget;
+    }
+    // the first and last point form their own buckets, the others are split into budget - 2 buckets;
+    // from every bucket the point is taken that forms the largest triangle with the previously selected point
+    // and the average of the next bucket
+    size_t numindices = 0;
+    indices[numindices++] = 0;
+    double width = (double)(count - 2) / (budget - 2);
+    size_t selected = 0;
+    for(size_t b = 0; b < budget - 2; ++b)
+    {
+        size_t start = 1 + (size_t)(b * width);
+        size_t end = 1 + (size_t)((b + 1) * width);
+        size_t nextstart = end;
+        size_t nextend = b + 2 < budget - 2 ? 1 + (size_t)((b + 2) * width) : count;
+        if(nextend > count)
+        {
+            nextend = count;
+        }
+        double xavg = 0.0;
+        double yavg = 0.0;
+        for(size_t i = nextstart; i < nextend; ++i)
+        {
+            xavg += x[i];
+            yavg += y[i];
+        }
+        xavg /= nextend - nextstart;
+        yavg /= nextend - nextstart;
+        double largest = -1.0;
+        size_t best = start;
+        for(size_t i = start; i < end; ++i)
+        {
+            double area = fabs((x[selected] - xavg) * (y[i] - y[selected]) - (x[selected] - x[i]) * (yavg - y[selected]));
+            if(area > largest)
+            {
+                largest = area;
+                best = i;
+            }
+        }
+        indices[numindices++] = best;
+        selected = best;
+    }
+    indices[numindices++] = count - 1;
+    return numindices;
+}
+
+void report_start_axis(struct report* report, const char* title, int logx, const char* options)
+{
+    report->logx = logx;
+    _begin(report, "tikzpicture");
+    _line(report, "[baseline = (plot.north)]");
+    _begin(report, "axis");
+    _line(report, "[name = plot, title = {%s}%s%s%s]", title ? title : "", logx ? ", xmode = log" : "", options ? ", " : "", options ? options : "");
+}
+
+void report_add_plot(struct report* report, const double* x, const double* y, size_t count, const char* legend)
+{
+    // LTTB works on the plotted coordinates (the logarithm of x on a logarithmic axis), non-finite points are left out
+    double* u = memory_allocate((count + 1) * sizeof(*u));
+    double* v = memory_allocate((count + 1) * sizeof(*v));
+    size_t* source = memory_allocate((count + 1) * sizeof(*source));
+    size_t numfinite = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        double xi = report->logx ? log10(x[i]) : x[i];
+        if(isfinite(xi) && isfinite(y[i]))
+        {
+            u[numfinite] = xi;
+            v[numfinite] = y[i];
+            source[numfinite] = i;
+            ++numfinite;
+        }
+    }
+    size_t budget = report->budget > 0 ? report->budget : numfinite;
+    size_t* indices = memory_allocate((budget + 1) * sizeof(*indices));
+    size_t numpoints = report_decimate(u, v, numfinite, budget, indices);
+    _line(report, "\\addplot+[] coordinates {");
+    ++report->indent;
+    for(size_t i = 0; i < numpoints; ++i)
+    {
+        size_t k = source[indices[i]];
+        _line(report, "(%.6g, %.6g)", x[k], y[k]);
+    }
+    --report->indent;
+    _line(report, "};");
+    if(legend)
+    {
+        _line(report, "\\addlegendentry{%s}", legend);
+    }
+    memory_free(indices);
+    memory_free(source);
+    memory_free(u);
+    memory_free(v);
+}
+
+void report_finish_axis(struct report* report)
+{
+    _end(report, "axis");
+    _end(report, "tikzpicture");
+}
+
+static void _row(struct report* report, const char* name, const double* values, const char* unit)
+{
+    char minimum[ENGINEERING_FORMAT_SIZE];
+    char maximum[ENGINEERING_FORMAT_SIZE];
+    engineering_format_buffer(minimum, sizeof(minimum), values[0], unit, 1);
+    engineering_format_buffer(maximum, sizeof(maximum), values[1], unit, 1);
+    _line(report, "%s & %s & %s \\\\", name, minimum, maximum);
+}
+
+void report_results(struct report* report, const struct pll_state* state)
+{
+    _line(report, "\\par");
+    _line(report, "$R_f = \\SI{%.1f}{\\ohm}$, $C_f = \\SI{%.1f}{\\pico\\farad}$, $C_{fx} = \\SI{%.2f}{\\pico\\farad}$", state->Rf, state->Cf / 1e-12, state->Cfx / 1e-12);
+    _line(report, "\\par");
+    _begin(report, "tabular");
+    _line(report, "{lrr}");
+    _line(report, "\\toprule");
+    _line(report, " & minimum $K_{VCO}$ & maximum $K_{VCO}$ \\\\");
+    _line(report, "\\midrule");
+    _row(report, "$J_{rms}$", state->Jrms, "s");
+    _row(report, "$J_{rms}$ VCO", state->Jrms_vco, "s");
+    _row(report, "$J_{rms}$ reference", state->Jrms_ref, "s");
+    _row(report, "$J_{rms}$ charge pump", state->Jrms_cp, "s");
+    _row(report, "$J_{rms}$ filter", state->Jrms_filter, "s");
+    _row(report, "$f_{0dB}$", state->f0dB, "Hz");
+    _row(report, "phase margin", state->phasemargin, "Degree");
+    _row(report, "$f_{bw}$", state->fbw, "Hz");
+    _line(report, "\\bottomrule");
+    _end(report, "tabular");
+}
+
+// frequency grid of the state as doubles
+static double* _frequencies(const struct pll_state* state)
+{
+    size_t samples = vector_size(state->f);
+    const double complex* f = vector_data(state->f);
+    double* x = memory_allocate(samples * sizeof(*x));
+    for(size_t k = 0; k < samples; ++k)
+    {
+        x[k] = creal(f[k]);
+    }
+    return x;
+}
+
+static void _magnitude_dB(const struct vector* H, double* y)
+{
+    const double complex* values = vector_data(H);
+    for(size_t k = 0; k < vector_size(H); ++k)
+    {
+        y[k] = 20 * log10(cabs(values[k]));
+    }
+}
+
+// unwrapped phase (see vector_phase), returns the range in 'ymin' and 'ymax'
+static void _phase(const struct vector* H, double* y, double* ymin, double* ymax)
+{
+    const double complex* values = vector_data(H);
+    double offset = 0.0;
+    for(size_t k = 0; k < vector_size(H); ++k)
+    {
+        double phase = 180 / CONSTANTS_PI * carg(values[k]);
+        if(k > 0 && phase + offset - y[k - 1] > 180)
+        {
+            offset -= 360;
+        }
+        else if(k > 0 && phase + offset - y[k - 1] < -180)
+        {
+            offset += 360;
+        }
+        y[k] = phase + offset;
+        *ymin = y[k] < *ymin ? y[k] : *ymin;
+        *ymax = y[k] > *ymax ? y[k] : *ymax;
+    }
+}
+
+void report_bode(struct report* report, const struct pll_state* state, const char* title)
+{
+    const struct vector* transfers[] = { state->Hloop, state->Hclosedloop };
+    const char* legends[] = { "open loop", "closed loop" };
+    size_t samples = vector_size(state->f);
+    double* x = _frequencies(state);
+    double* y = memory_allocate(samples * sizeof(*y));
+    double totalheight = 5.0;
+    double gap = 0.2;
+    double singleheight = (totalheight - gap) / 2;
+
+    report->logx = 1;
+    _begin(report, "tikzpicture");
+    _line(report, "[baseline = (magnitude.north)]");
+    _begin(report, "axis");
+    _line(report, "[name = magnitude, height = %.4fcm, anchor = south, xmode = log, xticklabels = {}, ylabel = {$|H(s)|$ (\\unit{\\deci\\bel})}, title = {%s}]", singleheight, title ? title : "");
+    for(size_t i = 0; i < 2; ++i)
+    {
+        _magnitude_dB(transfers[i], y);
+        report_add_plot(report, x, y, samples, NULL);
+    }
+    _end(report, "axis");
+
+    // the phase range is known only after both curves, the axis limits are rounded to multiples of 45 degree
+    double ymin = INFINITY;
+    double ymax = -INFINITY;
+    double* phases = memory_allocate(2 * samples * sizeof(*phases));
+    _phase(transfers[0], phases, &ymin, &ymax);
+    _phase(transfers[1], phases + samples, &ymin, &ymax);
+    ymin = 45 * floor(ymin / 45);
+    ymax = 45 * ceil(ymax / 45);
+    if(ymax <= ymin)
+    {
+        ymax = ymin + 45;
+    }
+    _begin(report, "axis");
+    _line(report, "[name = phase, height = %.4fcm, anchor = north, yshift = -%.4fcm, xmode = log, xlabel = {$f$ (\\unit{\\hertz})}, ylabel = {$\\varphi$ (\\unit{\\degree})}, ymin = %.0f, ymax = %.0f, ytick = {%.0f, %.0f, ..., %.0f}]", singleheight, gap, ymin, ymax, ymin, ymin + 45, ymax);
+    for(size_t i = 0; i < 2; ++i)
+    {
+        report_add_plot(report, x, phases + i * samples, samples, legends[i]);
+    }
+    _end(report, "axis");
+    _end(report, "tikzpicture");
+
+    memory_free(phases);
+    memory_free(y);
+    memory_free(x);
+}
+
+void report_noise(struct report* report, const struct pll_state* state, const char* title)
+{
+    const struct vector* spectra[] = { state->Stot_ref, state->Stot_vco, state->Stot_cp, state->Stot_phasedetector, state->Stot_filter, state->Stot };
+    const char* legends[] = { "reference", "VCO", "charge pump", "phase detector", "filter", "total" };
+    size_t samples = vector_size(state->f);
+    double* x = _frequencies(state);
+    double* y = memory_allocate(samples * sizeof(*y));
+    report_start_axis(report, title, 1, "xlabel = {$f$ (\\unit{\\hertz})}, ylabel = {$S_\\varphi$ (\\unit{\\deci\\bel} rad$^2$/\\unit{\\hertz})}, legend columns = 3");
+    for(size_t i = 0; i < sizeof(spectra) / sizeof(spectra[0]); ++i)
+    {
+        const double complex* S = vector_data(spectra[i]);
+        for(size_t k = 0; k < samples; ++k)
+        {
+            // zero contributions are -inf and left out of the plot
+            y[k] = 10 * log10(creal(S[k]));
+        }
+        report_add_plot(report, x, y, samples, legends[i]);
+    }
+    report_finish_axis(report);
+    memory_free(y);
+    memory_free(x);
+}
@@ -0,0 +1,41 @@
+#ifndef PLL_REPORT_H
+#define PLL_REPORT_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// LaTeX/pgfplots report of a pll_state (replaces the Lua report module of the original implementation).
+// The document is streamed to the file while it is built, nothing is kept in memory but the current curve.
+// Every curve is decimated to a point budget with the largest-triangle-three-buckets algorithm (on a logarithmic
+// frequency axis), which keeps peaks and corners, so reports of dense grids still compile quickly.
+// The plots show the vectors of the last pll_calculate, i.e. the maximum Kvco corner.
+
+struct report;
+
+// writes the preamble and starts the document, returns NULL if the file can not be opened
+struct report* report_create(const char* filename);
+// ends the document and closes the file, returns 0 if writing failed
+int report_close(struct report* report);
+// maximum number of points per curve (default: 200, 0: no decimation)
+void report_set_point_budget(struct report* report, size_t budget);
+
+// text is inserted verbatim (LaTeX)
+void report_paragraph(struct report* report, const char* text);
+// filter values and the results of both Kvco corners
+void report_results(struct report* report, const struct pll_state* state);
+// magnitude and phase of the open loop (Hloop) and closed loop (Hclosedloop) gain
+void report_bode(struct report* report, const struct pll_state* state, const char* title);
+// effective noise contributions and total noise
+void report_noise(struct report* report, const struct pll_state* state, const char* title);
+
+// generic axes: 'options' are additional pgfplots options (may be NULL), plots are added between start and finish
+void report_start_axis(struct report* report, const char* title, int logx, const char* options);
+void report_add_plot(struct report* report, const double* x, const double* y, size_t count, const char* legend);
+void report_finish_axis(struct report* report);
+
+// indices of at most 'budget' points that preserve the shape of (x, y) (LTTB, the first and last point are always kept),
+// returns the number of indices (count if count <= budget)
+size_t report_decimate(const double* x, const double* y, size_t count, size_t budget, size_t* indices);
+
+#endif /* PLL_REPORT_H */
@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "expression.h"
+#include "metrics.h"
+
+// apply several cost functions and constraint sets to the stored metrics of a sweep (written with 'main --metrics FILE')
+// usage: rescore FILE [EXPRESSION...]
+// further cost functions can be given as expressions over the stored metrics and design variables (see expression.h),
+// e.g. 'abs(pm-70) + jrms_vco/20e-15 + rf/1e4', or added to this file, the sweep does not have to be run again
+
+static const struct {
+    const char* name;
+    const char* expression;
+    int constrained;
+} costs[] = {
+    { "phase margin",           "10*abs(pm-70)",              0 },
+    { "jitter",                 "jrms/50e-15",                0 },
+    { "jitter (constrained)",   "jrms/50e-15",                1 },
+    { "weighted (constrained)", "abs(pm-70) + 10*jrms/50e-15", 1 },
+};
+
+static double _elapsed(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
+
+// 0 if 'text' is not a valid expression
+static int _report(const struct metrics* metrics, const char* name, const char* text, const struct metrics_constraint* constraints, size_t numconstraints)
+{
+    struct expression* expression = expression_compile(text);
+    if(!expression)
+    {
+        return 0;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double score;
+    size_t row = metrics_best_expression(metrics, expression, constraints, numconstraints, &score);
+    expression_destroy(expression);
+    double elapsed = _elapsed(&start);
+    if(row == metrics_get_size(metrics))
+    {
+        printf("%-24s no design with a comparable score fulfills the constraints (%.3f ms)\n", name, elapsed * 1e3);
+        return 1;
+    }
+    printf("%-24s Rf = %7.1f Ohm, Cf = %6.1f pF, score = %-10.4g PM = %5.1f Degree, Jrms = %5.1f fs (%.3f ms)\n",
+        name,
+        metrics_get_variable(metrics, PLL_RF)[row],
+        metrics_get_variable(metrics, PLL_CF)[row] / 1e-12,
+        score,
+        metrics_get_column(metrics, METRICS_PHASEMARGIN, 0)[row],
+        metrics_get_column(metrics, METRICS_JRMS, 0)[row] / 1e-15,
+        elapsed * 1e3
+    );
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s FILE [EXPRESSION...]\n", argv[0]);
+        return 1;
+    }
+    uint64_t confighash;
+    struct metrics* metrics = metrics_read(argv[1], &confighash);
+    if(!metrics)
+    {
+        return 1;
+    }
+    printf("%zu designs (configuration %016llx)\n", metrics_get_size(metrics), (unsigned long long)confighash);
+
+    // phase margin between 60 and 80 degree at both corners, bandwidth below 2 MHz
+    struct metrics_constraint constraints[] = {
+        { METRICS_PHASEMARGIN, 0, 60, 80 },
+        { METRICS_PHASEMARGIN, 1, 60, 80 },
+        { METRICS_BANDWIDTH, 0, -INFINITY, 2e6 },
+        { METRICS_BANDWIDTH, 1, -INFINITY, 2e6 },
+    };
+    size_t numconstraints = sizeof(constraints) / sizeof(constraints[0]);
+
+    int status = 0;
+    for(size_t i = 0; i < sizeof(costs) / sizeof(costs[0]); ++i)
+    {
+        if(!_report(metrics, costs[i].name, costs[i].expression, costs[i].constrained ? constraints : NULL, costs[i].constrained ? numconstraints : 0))
+        {
+            status = 1;
+        }
+    }
+    for(int i = 2; i < argc; ++i)
+    {
+        if(!_report(metrics, argv[i], argv[i], NULL, 0))
+        {
+            status = 1;
+        }
+    }
+
+    metrics_destroy(metrics);
+    return status;
+}
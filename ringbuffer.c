@@ -0,0 +1,122 @@
+#include "ringbuffer.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+// This is the classic bounded MPMC queue by Dmitry Vyukov:
+// every cell carries a sequence number that tells producers and consumers whether the cell is free or filled
+// for the current lap, so the only contended operations are the compare-and-swap on head and tail.
+
+#define RINGBUFFER_CACHELINE 64
+
+struct cell {
+    atomic_size_t sequence;
+};
+
+struct ringbuffer {
+    size_t mask;
+    size_t elementsize;
+    size_t cellsize;
+    unsigned char* cells;
+    _Alignas(RINGBUFFER_CACHELINE) atomic_size_t head; // next cell to be written
+    _Alignas(RINGBUFFER_CACHELINE) atomic_size_t tail; // next cell to be read
+};
+
+static struct cell* _get_cell(struct ringbuffer* ringbuffer, size_t pos)
+{
+    return (struct cell*)(ringbuffer->cells + (pos & ringbuffer->mask) * ringbuffer->cellsize);
+}
+
+struct ringbuffer* ringbuffer_create(size_t capacity, size_t elementsize)
+{
+    size_t size = 2;
+    while(size < capacity)
+    {
+        size *= 2;
+    }
+    struct ringbuffer* ringbuffer = memory_allocate_aligned(RINGBUFFER_CACHELINE, sizeof(*ringbuffer));
+    ringbuffer->mask = size - 1;
+    ringbuffer->elementsize = elementsize;
+    // element data is stored directly behind the sequence number, cells are padded to 8 bytes
+    ringbuffer->cellsize = (sizeof(struct cell) + elementsize + 7) & ~(size_t)7;
+    ringbuffer->cells = memory_allocate(size * ringbuffer->cellsize);
+    for(size_t i = 0; i < size; ++i)
+    {
+        atomic_init(&_get_cell(ringbuffer, i)->sequence, i);
+    }
+    atomic_init(&ringbuffer->head, 0);
+    atomic_init(&ringbuffer->tail, 0);
+    return ringbuffer;
+}
+
+void ringbuffer_destroy(struct ringbuffer* ringbuffer)
+{
+    memory_free(ringbuffer->cells);
+    memory_free(ringbuffer);
+}
+
+size_t ringbuffer_capacity(const struct ringbuffer* ringbuffer)
+{
+    return ringbuffer->mask + 1;
+}
+
+int ringbuffer_push(struct ringbuffer* ringbuffer, const void* element)
+{
+    size_t pos = atomic_load_explicit(&ringbuffer->head, memory_order_relaxed);
+    while(1)
+    {
+        struct cell* cell = _get_cell(ringbuffer, pos);
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if(diff == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&ringbuffer->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                memcpy(cell + 1, element, ringbuffer->elementsize);
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                return 1;
+            }
+            // pos was updated by the failed exchange
+        }
+        else if(diff < 0) // full
+        {
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ringbuffer->head, memory_order_relaxed);
+        }
+    }
+}
+
+int ringbuffer_pop(struct ringbuffer* ringbuffer, void* element)
+{
+    size_t pos = atomic_load_explicit(&ringbuffer->tail, memory_order_relaxed);
+    while(1)
+    {
+        struct cell* cell = _get_cell(ringbuffer, pos);
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if(diff == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&ringbuffer->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                memcpy(element, cell + 1, ringbuffer->elementsize);
+                atomic_store_explicit(&cell->sequence, pos + ringbuffer->mask + 1, memory_order_release);
+                return 1;
+            }
+        }
+        else if(diff < 0) // empty
+        {
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ringbuffer->tail, memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef PLL_RINGBUFFER_H
+#define PLL_RINGBUFFER_H
+
+#include <stddef.h>
+
+// bounded lock-free multi-producer/multi-consumer queue of fixed-size elements
+// (the capacity is rounded up to the next power of two)
+struct ringbuffer;
+
+struct ringbuffer* ringbuffer_create(size_t capacity, size_t elementsize);
+void ringbuffer_destroy(struct ringbuffer* ringbuffer);
+// both return 0 if the queue is full (push) or empty (pop), the caller decides how to wait
+int ringbuffer_push(struct ringbuffer* ringbuffer, const void* element);
+int ringbuffer_pop(struct ringbuffer* ringbuffer, void* element);
+size_t ringbuffer_capacity(const struct ringbuffer* ringbuffer);
+
+#endif /* PLL_RINGBUFFER_H */
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "memo.h"
+#include "memory.h"
+#include "pll.h"
+
+// checks that a long run of evaluations works in bounded memory:
+// after a warm-up, neither the resident set size nor the live bytes of the library may grow
+// usage: stress [EVALUATIONS] (default: 10^7 per case)
+
+#define STRESS_CHECKPOINTS 10
+#define STRESS_RSS_SLACK (256 * 1024) // bytes of RSS growth that are tolerated (allocator and stdio noise)
+
+static size_t _resident_bytes(void)
+{
+    FILE* file = fopen("/proc/self/statm", "r");
+    if(!file)
+    {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if(fscanf(file, "%lu %lu", &size, &resident) != 2)
+    {
+        resident = 0;
+    }
+    fclose(file);
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static double _elapsed(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + 1e-9 * (now.tv_nsec - start->tv_nsec);
+}
+
+// the cases differ in the jitter integration (whole range or band, both 0: whole range)
+struct stresscase {
+    const char* name;
+    double flower;
+    double fupper;
+};
+
+static const struct stresscase cases[] = {
+    { "whole range",         0,   0 },
+    { "jitter band 10k-100M", 1e4, 1e8 },
+};
+#define STRESS_NUM_CASES (sizeof(cases) / sizeof(cases[0]))
+
+// same configuration as main
+static struct pll_state* _create_state(const struct stresscase* stresscase)
+{
+    struct pll_state* state = pll_create();
+    pll_set_eval_frequencies(state, 3, 12, 10);
+    pll_set_input_output_frequencies(state, 875e6, 56e9);
+    pll_set_feedback_divider(state, 1);
+    pll_set_reference_divider(state, 1);
+    pll_set_phase_detector_gain(state, 0.45);
+    pll_set_vco_gain(state, 1.2e9, 1.2e9);
+    pll_set_vco_noise(state, 1e6, -90.0, 1e5);
+    pll_set_reference_noise(state, 1e3, -139, 1e-3);
+    pll_add_parasitic_pole(state, -1e10);
+    pll_add_parasitic_pole(state, -1e13);
+    pll_set_jitter_band(state, stresscase->flower, stresscase->fupper);
+    pll_set_chargepump_gain(state, 200e-6);
+    pll_set_chargepump_noise(state, 1e-22, 1e7);
+    pll_set_filter(state, 1.0e3, 200.0e-12, 0e-12);
+    pll_initialize(state);
+    return state;
+}
+
+// every evaluation gets new filter values (the filter is recalculated and the memo misses)
+static void _evaluate(struct pll_state* state, struct memo* memo, size_t count)
+{
+    struct pll_results results;
+    for(size_t i = 0; i < count; ++i)
+    {
+        pll_set_filter(state, 100 + (i % 9973), 20e-12 + 1e-15 * (i % 7919), 0.0);
+        memo_calculate(memo, state, &results);
+    }
+}
+
+static int _run(const struct stresscase* stresscase, size_t evaluations)
+{
+    size_t interval = evaluations / STRESS_CHECKPOINTS;
+    if(interval == 0)
+    {
+        interval = 1;
+    }
+
+    struct pll_state* state = _create_state(stresscase);
+    struct memo* memo = memo_create(1024);
+
+    // warm-up: the workspace and the memo reach their final size
+    _evaluate(state, memo, interval);
+    size_t rss0 = _resident_bytes();
+    struct memory_statistics statistics0;
+    memory_get_statistics(&statistics0);
+    printf("%s\n", stresscase->name);
+    printf("%12s %12s %12s %12s %14s\n", "evaluations", "RSS [KiB]", "live [B]", "peak [B]", "allocs/eval");
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct memory_statistics previous = statistics0;
+    size_t done = 0;
+    size_t rss = rss0;
+    while(done < evaluations)
+    {
+        size_t count = evaluations - done < interval ? evaluations - done : interval;
+        _evaluate(state, memo, count);
+        done += count;
+        struct memory_statistics statistics;
+        memory_get_statistics(&statistics);
+        rss = _resident_bytes();
+        printf("%12zu %12zu %12zu %12zu %14.3g\n", done, rss / 1024, statistics.live, statistics.peak, (double)(statistics.allocations - previous.allocations) / count);
+        previous = statistics;
+    }
+    double elapsed = _elapsed(&start);
+    printf("%zu evaluations in %.1f s (%.2f us per evaluation)\n", done, elapsed, 1e6 * elapsed / done);
+
+    int ok = 1;
+    if(previous.live != statistics0.live)
+    {
+        fprintf(stderr, "stress: %s: live bytes grew from %zu to %zu\n", stresscase->name, statistics0.live, previous.live);
+        ok = 0;
+    }
+    if(previous.allocations != statistics0.allocations)
+    {
+        fprintf(stderr, "stress: %s: %zu allocations after the warm-up\n", stresscase->name, previous.allocations - statistics0.allocations);
+        ok = 0;
+    }
+    if(rss > rss0 + STRESS_RSS_SLACK)
+    {
+        fprintf(stderr, "stress: %s: resident set size grew from %zu KiB to %zu KiB\n", stresscase->name, rss0 / 1024, rss / 1024);
+        ok = 0;
+    }
+
+    memo_destroy(memo);
+    pll_cleanup(state);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    size_t evaluations = 10000000;
+    if(argc > 2 || (argc == 2 && sscanf(argv[1], "%zu", &evaluations) != 1))
+    {
+        fprintf(stderr, "usage: %s [EVALUATIONS]\n", argv[0]);
+        return 1;
+    }
+
+    int ok = 1;
+    for(size_t c = 0; c < STRESS_NUM_CASES; ++c)
+    {
+        ok = _run(&cases[c], evaluations) && ok;
+    }
+
+    struct memory_statistics final;
+    memory_get_statistics(&final);
+    printf("after cleanup: %zu live bytes\n", final.live);
+    if(final.live != 0)
+    {
+        fprintf(stderr, "stress: %zu bytes are still allocated after cleanup\n", final.live);
+        ok = 0;
+    }
+    printf("%s\n", ok ? "memory is bounded" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,431 @@
+#include "summary.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory.h"
+
+#define SUMMARY_MAGIC "stajiba-summary"
+#define SUMMARY_VERSION 1
+
+struct summary {
+    size_t evaluated;
+    size_t valid;
+    int hasbest;
+    struct sweep_record best;
+    struct sweep_record* pareto;
+    size_t paretosize;
+    size_t paretocapacity;
+    struct summary_statistic statistics[SUMMARY_NUM_METRICS];
+};
+
+static const char* metricnames[SUMMARY_NUM_METRICS] = {
+    "score",
+    "Jrms",
+    "phasemargin",
+    "fbw",
+    "f0dB",
+};
+
+static double _get_metric(const struct sweep_record* record, enum summary_metric metric)
+{
+    switch(metric)
+    {
+        case SUMMARY_SCORE:
+            return record->score;
+        case SUMMARY_JRMS:
+            return record->results.Jrms[0];
+        case SUMMARY_PHASEMARGIN:
+            return record->results.phasemargin[0];
+        case SUMMARY_BANDWIDTH:
+            return record->results.fbw[0];
+        case SUMMARY_UNITY_GAIN_FREQUENCY:
+            return record->results.f0dB[0];
+        default:
+            return 0.0;
+    }
+}
+
+static void _statistic_reset(struct summary_statistic* statistic)
+{
+    statistic->count = 0;
+    statistic->min = DBL_MAX;
+    statistic->max = -DBL_MAX;
+    statistic->sum = 0.0;
+    statistic->compensation = 0.0;
+}
+
+static void _statistic_add_sum(struct summary_statistic* statistic, double value)
+{
+    double t = statistic->sum + value;
+    if(fabs(statistic->sum) >= fabs(value))
+    {
+        statistic->compensation += (statistic->sum - t) + value;
+    }
+    else
+    {
+        statistic->compensation += (value - t) + statistic->sum;
+    }
+    statistic->sum = t;
+}
+
+static void _statistic_add(struct summary_statistic* statistic, double value)
+{
+    ++statistic->count;
+    if(value < statistic->min)
+    {
+        statistic->min = value;
+    }
+    if(value > statistic->max)
+    {
+        statistic->max = value;
+    }
+    _statistic_add_sum(statistic, value);
+}
+
+static void _statistic_merge(struct summary_statistic* statistic, const struct summary_statistic* other)
+{
+    statistic->count += other->count;
+    if(other->min < statistic->min)
+    {
+        statistic->min = other->min;
+    }
+    if(other->max > statistic->max)
+    {
+        statistic->max = other->max;
+    }
+    _statistic_add_sum(statistic, other->sum);
+    _statistic_add_sum(statistic, other->compensation);
+}
+
+double summary_statistic_mean(const struct summary_statistic* statistic)
+{
+    if(statistic->count == 0)
+    {
+        return 0.0;
+    }
+    return (statistic->sum + statistic->compensation) / statistic->count;
+}
+
+struct summary* summary_create(void)
+{
+    struct summary* summary = memory_allocate_zeroed(1, sizeof(*summary));
+    for(size_t i = 0; i < SUMMARY_NUM_METRICS; ++i)
+    {
+        _statistic_reset(&summary->statistics[i]);
+    }
+    return summary;
+}
+
+void summary_destroy(struct summary* summary)
+{
+    memory_free(summary->pareto);
+    memory_free(summary);
+}
+
+// Pareto objectives: low jitter, high phase margin, high bandwidth
+static int _dominates(const struct sweep_record* a, const struct sweep_record* b)
+{
+    double Ja = a->results.Jrms[0];
+    double Jb = b->results.Jrms[0];
+    double PMa = a->results.phasemargin[0];
+    double PMb = b->results.phasemargin[0];
+    double fbwa = a->results.fbw[0];
+    double fbwb = b->results.fbw[0];
+    int noworse = Ja <= Jb && PMa >= PMb && fbwa >= fbwb;
+    int better = Ja < Jb || PMa > PMb || fbwa > fbwb;
+    return noworse && better;
+}
+
+static void _pareto_insert(struct summary* summary, const struct sweep_record* record)
+{
+    for(size_t i = 0; i < summary->paretosize; ++i)
+    {
+        if(_dominates(&summary->pareto[i], record))
+        {
+            return;
+        }
+    }
+    // remove all points that are dominated by the new one
+    size_t keep = 0;
+    for(size_t i = 0; i < summary->paretosize; ++i)
+    {
+        if(!_dominates(record, &summary->pareto[i]))
+        {
+            summary->pareto[keep] = summary->pareto[i];
+            ++keep;
+        }
+    }
+    summary->paretosize = keep;
+    if(summary->paretosize == summary->paretocapacity)
+    {
+        summary->paretocapacity = summary->paretocapacity ? 2 * summary->paretocapacity : 16;
+        summary->pareto = memory_reallocate(summary->pareto, summary->paretocapacity * sizeof(*summary->pareto));
+    }
+    summary->pareto[summary->paretosize] = *record;
+    ++summary->paretosize;
+}
+
+static void _best_update(struct summary* summary, const struct sweep_record* record)
+{
+    // an infeasible design (infinite or NaN score) is never the best one
+    if(!isfinite(record->score))
+    {
+        return;
+    }
+    if(!summary->hasbest || record->score < summary->best.score || (record->score == summary->best.score && record->index < summary->best.index))
+    {
+        summary->best = *record;
+        summary->hasbest = 1;
+    }
+}
+
+void summary_add(struct summary* summary, const struct sweep_record* record)
+{
+    ++summary->evaluated;
+    if(!record->valid)
+    {
+        return;
+    }
+    ++summary->valid;
+    _best_update(summary, record);
+    _pareto_insert(summary, record);
+    for(size_t i = 0; i < SUMMARY_NUM_METRICS; ++i)
+    {
+        _statistic_add(&summary->statistics[i], _get_metric(record, i));
+    }
+}
+
+int summary_writer(const struct sweep_record* record, void* summary)
+{
+    summary_add(summary, record);
+    return 1;
+}
+
+void summary_merge(struct summary* summary, const struct summary* other)
+{
+    summary->evaluated += other->evaluated;
+    summary->valid += other->valid;
+    if(other->hasbest)
+    {
+        _best_update(summary, &other->best);
+    }
+    for(size_t i = 0; i < other->paretosize; ++i)
+    {
+        _pareto_insert(summary, &other->pareto[i]);
+    }
+    for(size_t i = 0; i < SUMMARY_NUM_METRICS; ++i)
+    {
+        _statistic_merge(&summary->statistics[i], &other->statistics[i]);
+    }
+}
+
+size_t summary_get_evaluated(const struct summary* summary)
+{
+    return summary->evaluated;
+}
+
+int summary_get_best(const struct summary* summary, struct sweep_record* record)
+{
+    if(summary->hasbest)
+    {
+        *record = summary->best;
+    }
+    return summary->hasbest;
+}
+
+size_t summary_get_pareto_size(const struct summary* summary)
+{
+    return summary->paretosize;
+}
+
+const struct sweep_record* summary_get_pareto(const struct summary* summary, size_t idx)
+{
+    return &summary->pareto[idx];
+}
+
+void summary_get_statistic(const struct summary* summary, enum summary_metric metric, struct summary_statistic* statistic)
+{
+    *statistic = summary->statistics[metric];
+}
+
+/*
+ * File I/O
+ * plain text, all numbers are written with 17 significant digits so that they survive the round trip exactly
+ */
+
+static void _write_record(FILE* file, const char* tag, const struct sweep_record* record)
+{
+    fprintf(file, "%s %zu %d %.17g", tag, record->index, record->valid, record->score);
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        fprintf(file, " %.17g", record->variables[i]);
+    }
+    const struct pll_results* r = &record->results;
+    for(size_t i = 0; i < 2; ++i)
+    {
+        fprintf(
+            file, " %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g",
+            r->Jrms[i], r->Jrms_vco[i], r->Jrms_ref[i], r->Jrms_cp[i], r->Jrms_filter[i], r->f0dB[i], r->phasemargin[i], r->fbw[i]
+        );
+    }
+    fputc('\n', file);
+}
+
+static int _read_record(FILE* file, struct sweep_record* record)
+{
+    int ret = fscanf(file, "%zu %d %lg", &record->index, &record->valid, &record->score);
+    if(ret != 3)
+    {
+        return 0;
+    }
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(fscanf(file, "%lg", &record->variables[i]) != 1)
+        {
+            return 0;
+        }
+    }
+    struct pll_results* r = &record->results;
+    for(size_t i = 0; i < 2; ++i)
+    {
+        ret = fscanf(
+            file, "%lg %lg %lg %lg %lg %lg %lg %lg",
+            &r->Jrms[i], &r->Jrms_vco[i], &r->Jrms_ref[i], &r->Jrms_cp[i], &r->Jrms_filter[i], &r->f0dB[i], &r->phasemargin[i], &r->fbw[i]
+        );
+        if(ret != 8)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int _compare_index(const void* lhs, const void* rhs)
+{
+    const struct sweep_record* a = lhs;
+    const struct sweep_record* b = rhs;
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+void summary_write_to(const struct summary* summary, FILE* file)
+{
+    fprintf(file, "%s %d\n", SUMMARY_MAGIC, SUMMARY_VERSION);
+    fprintf(file, "evaluated %zu\n", summary->evaluated);
+    fprintf(file, "valid %zu\n", summary->valid);
+    for(size_t i = 0; i < SUMMARY_NUM_METRICS; ++i)
+    {
+        // normalized (sum holds the rounded total), so the text does not depend on the summation order
+        struct summary_statistic normalized = summary->statistics[i];
+        normalized.sum = summary->statistics[i].sum + summary->statistics[i].compensation;
+        normalized.compensation = summary->statistics[i].compensation - (normalized.sum - summary->statistics[i].sum);
+        const struct summary_statistic* statistic = &normalized;
+        fprintf(
+            file, "statistic %s %zu %.17g %.17g %.17g %.17g\n",
+            metricnames[i], statistic->count, statistic->min, statistic->max, statistic->sum, statistic->compensation
+        );
+    }
+    if(summary->hasbest)
+    {
+        _write_record(file, "best", &summary->best);
+    }
+    // the Pareto set is written in grid order, so the output does not depend on the order of evaluation
+    struct sweep_record* pareto = memory_allocate(summary->paretosize * sizeof(*pareto) + 1);
+    memcpy(pareto, summary->pareto, summary->paretosize * sizeof(*pareto));
+    qsort(pareto, summary->paretosize, sizeof(*pareto), _compare_index);
+    for(size_t i = 0; i < summary->paretosize; ++i)
+    {
+        _write_record(file, "pareto", &pareto[i]);
+    }
+    memory_free(pareto);
+}
+
+int summary_write(const struct summary* summary, const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    summary_write_to(summary, file);
+    fclose(file);
+    return 1;
+}
+
+struct summary* summary_read(const char* filename)
+{
+    FILE* file = fopen(filename, "r");
+    if(!file)
+    {
+        fprintf(stderr, "could not open file '%s' for reading\n", filename);
+        return NULL;
+    }
+    char magic[32];
+    int version;
+    if(fscanf(file, "%31s %d", magic, &version) != 2 || strcmp(magic, SUMMARY_MAGIC) != 0 || version != SUMMARY_VERSION)
+    {
+        fprintf(stderr, "summary_read: '%s' is not a summary file\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    struct summary* summary = summary_create();
+    char tag[32];
+    while(fscanf(file, "%31s", tag) == 1)
+    {
+        int ok = 1;
+        if(strcmp(tag, "evaluated") == 0)
+        {
+            ok = fscanf(file, "%zu", &summary->evaluated) == 1;
+        }
+        else if(strcmp(tag, "valid") == 0)
+        {
+            ok = fscanf(file, "%zu", &summary->valid) == 1;
+        }
+        else if(strcmp(tag, "statistic") == 0)
+        {
+            char name[32];
+            struct summary_statistic statistic;
+            ok = fscanf(
+                file, "%31s %zu %lg %lg %lg %lg",
+                name, &statistic.count, &statistic.min, &statistic.max, &statistic.sum, &statistic.compensation
+            ) == 6;
+            for(size_t i = 0; ok && i < SUMMARY_NUM_METRICS; ++i)
+            {
+                if(strcmp(name, metricnames[i]) == 0)
+                {
+                    summary->statistics[i] = statistic;
+                }
+            }
+        }
+        else if(strcmp(tag, "best") == 0)
+        {
+            ok = _read_record(file, &summary->best);
+            summary->hasbest = ok;
+        }
+        else if(strcmp(tag, "pareto") == 0)
+        {
+            struct sweep_record record;
+            ok = _read_record(file, &record);
+            if(ok)
+            {
+                _pareto_insert(summary, &record);
+            }
+        }
+        else
+        {
+            ok = 0;
+        }
+        if(!ok)
+        {
+            fprintf(stderr, "summary_read: malformed entry '%s' in '%s'\n", tag, filename);
+            summary_destroy(summary);
+            fclose(file);
+            return NULL;
+        }
+    }
+    fclose(file);
+    return summary;
+}
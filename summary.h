@@ -0,0 +1,50 @@
+#ifndef PLL_SUMMARY_H
+#define PLL_SUMMARY_H
+
+#include <stdio.h>
+
+#include "sweep.h"
+
+// Condensed result of a sweep (or a shard of a sweep): best point, Pareto set and statistics.
+// Summaries of disjoint shards can be merged and give the same best point and Pareto set as a single run
+// (the statistics sums are compensated, so they agree up to the last bits).
+
+enum summary_metric {
+    SUMMARY_SCORE,
+    SUMMARY_JRMS,
+    SUMMARY_PHASEMARGIN,
+    SUMMARY_BANDWIDTH,
+    SUMMARY_UNITY_GAIN_FREQUENCY,
+    SUMMARY_NUM_METRICS
+};
+
+struct summary_statistic {
+    size_t count;
+    double min;
+    double max;
+    double sum;
+    double compensation; // Neumaier summation
+};
+
+struct summary;
+
+struct summary* summary_create(void);
+void summary_destroy(struct summary* summary);
+void summary_add(struct summary* summary, const struct sweep_record* record);
+// sweep_writer adapter, 'summary' is a struct summary*
+int summary_writer(const struct sweep_record* record, void* summary);
+void summary_merge(struct summary* summary, const struct summary* other);
+
+size_t summary_get_evaluated(const struct summary* summary);
+// best valid point with a finite score, returns 0 if there is none
+int summary_get_best(const struct summary* summary, struct sweep_record* record);
+size_t summary_get_pareto_size(const struct summary* summary);
+const struct sweep_record* summary_get_pareto(const struct summary* summary, size_t idx);
+void summary_get_statistic(const struct summary* summary, enum summary_metric metric, struct summary_statistic* statistic);
+double summary_statistic_mean(const struct summary_statistic* statistic);
+
+int summary_write(const struct summary* summary, const char* filename);
+void summary_write_to(const struct summary* summary, FILE* file);
+struct summary* summary_read(const char* filename);
+
+#endif /* PLL_SUMMARY_H */
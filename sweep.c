@@ -0,0 +1,560 @@
+#include "sweep.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "batch.h"
+#include "database.h"
+#include "memory.h"
+#include "ringbuffer.h"
+
+struct sweep {
+    struct parameter* axes[PLL_NUM_VARIABLES];
+    evaluator eval;
+    sweep_writer writer;
+    void* userdata;
+    struct database* database;
+    unsigned int numthreads;
+    size_t capacity;
+    size_t shardindex;
+    size_t shardcount;
+    enum sweep_order order;
+
+    int hasbest;
+    struct sweep_record best;
+    struct sweep_statistics statistics;
+};
+
+struct sweep* sweep_create(void)
+{
+    struct sweep* sweep = memory_allocate_zeroed(1, sizeof(*sweep));
+    sweep->numthreads = 1;
+    sweep->capacity = 256;
+    sweep->shardindex = 0;
+    sweep->shardcount = 1;
+    return sweep;
+}
+
+void sweep_destroy(struct sweep* sweep)
+{
+    memory_free(sweep);
+}
+
+void sweep_set_axis(struct sweep* sweep, enum pll_variable variable, struct parameter* parameter)
+{
+    sweep->axes[variable] = parameter;
+}
+
+void sweep_set_evaluator(struct sweep* sweep, evaluator eval)
+{
+    sweep->eval = eval;
+}
+
+void sweep_set_writer(struct sweep* sweep, sweep_writer writer, void* userdata)
+{
+    sweep->writer = writer;
+    sweep->userdata = userdata;
+}
+
+void sweep_set_database(struct sweep* sweep, struct database* database)
+{
+    sweep->database = database;
+}
+
+void sweep_set_threads(struct sweep* sweep, unsigned int numthreads)
+{
+    sweep->numthreads = numthreads > 0 ? numthreads : 1;
+}
+
+void sweep_set_queue_capacity(struct sweep* sweep, size_t capacity)
+{
+    sweep->capacity = capacity;
+}
+
+void sweep_set_shard(struct sweep* sweep, size_t index, size_t count)
+{
+    sweep->shardindex = index;
+    sweep->shardcount = count > 0 ? count : 1;
+}
+
+void sweep_set_order(struct sweep* sweep, enum sweep_order order)
+{
+    sweep->order = order;
+}
+
+size_t sweep_get_size(const struct sweep* sweep)
+{
+    size_t size = 1;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(sweep->axes[i])
+        {
+            size *= parameter_get_count(sweep->axes[i]);
+        }
+    }
+    return size;
+}
+
+void sweep_get_range(const struct sweep* sweep, size_t* first, size_t* last)
+{
+    size_t size = sweep_get_size(sweep);
+    // the division is done per bound so that the slices cover the grid without gaps or overlaps
+    *first = size / sweep->shardcount * sweep->shardindex + size % sweep->shardcount * sweep->shardindex / sweep->shardcount;
+    *last = size / sweep->shardcount * (sweep->shardindex + 1) + size % sweep->shardcount * (sweep->shardindex + 1) / sweep->shardcount;
+}
+
+size_t sweep_get_index(const struct sweep* sweep, size_t position)
+{
+    if(sweep->order == SWEEP_ORDER_LINEAR)
+    {
+        return position;
+    }
+    // a digit runs backwards if the number formed by the higher digits (the count of its completed passes) is odd
+    size_t index = 0;
+    size_t stride = 1;
+    size_t higher = position;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(sweep->axes[i])
+        {
+            size_t count = parameter_get_count(sweep->axes[i]);
+            size_t digit = higher % count;
+            higher /= count;
+            if(higher % 2 == 1)
+            {
+                digit = count - 1 - digit;
+            }
+            index += digit * stride;
+            stride *= count;
+        }
+    }
+    return index;
+}
+
+void sweep_get_point(const struct sweep* sweep, const struct pll_state* state, size_t index, double* variables)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(sweep->axes[i])
+        {
+            size_t count = parameter_get_count(sweep->axes[i]);
+            variables[i] = parameter_get_value(sweep->axes[i], index % count);
+            index /= count;
+        }
+        else
+        {
+            variables[i] = pll_get_variable(state, i);
+        }
+    }
+}
+
+// variables that differ from the previous point (all for the first point)
+static unsigned int _changed(const double* previous, const double* variables)
+{
+    unsigned int changed = 0;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        if(!previous || previous[i] != variables[i])
+        {
+            changed |= 1u << i;
+        }
+    }
+    return changed;
+}
+
+static void _evaluate(const struct sweep* sweep, struct pll_state* state, struct sweep_record* record)
+{
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        pll_set_variable(state, i, record->variables[i]);
+    }
+    if(sweep->database)
+    {
+        record->valid = database_calculate(sweep->database, state, &record->results);
+        record->reused = PLL_REUSE_NONE;
+    }
+    else
+    {
+        record->valid = pll_calculate(state);
+        record->reused = pll_get_reused(state);
+        if(record->valid)
+        {
+            pll_get_results(state, &record->results);
+        }
+    }
+    if(record->valid)
+    {
+        record->score = sweep->eval ? pll_get_results_score(&record->results, sweep->eval) : 0.0;
+    }
+}
+
+static void _start(struct sweep* sweep)
+{
+    sweep->hasbest = 0;
+    sweep->statistics = (struct sweep_statistics) { 0 };
+}
+
+// writer stage: keeps track of the best point and forwards the record
+static int _collect(struct sweep* sweep, const struct sweep_record* record)
+{
+    ++sweep->statistics.evaluated;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        sweep->statistics.changed += (record->changed >> i) & 1;
+    }
+    if(record->reused & PLL_REUSE_FILTER)
+    {
+        ++sweep->statistics.filter_reused;
+    }
+    // an infeasible design (infinite or NaN score) is never the best one
+    if(record->valid && isfinite(record->score))
+    {
+        if(!sweep->hasbest || record->score < sweep->best.score || (record->score == sweep->best.score && record->index < sweep->best.index))
+        {
+            sweep->best = *record;
+            sweep->hasbest = 1;
+        }
+    }
+    if(sweep->writer)
+    {
+        return sweep->writer(record, sweep->userdata);
+    }
+    return 1;
+}
+
+int sweep_run(struct sweep* sweep, struct pll_state* state)
+{
+    _start(sweep);
+    size_t first, last;
+    sweep_get_range(sweep, &first, &last);
+    double previous[PLL_NUM_VARIABLES];
+    for(size_t position = first; position < last; ++position)
+    {
+        struct sweep_record record;
+        record.index = sweep_get_index(sweep, position);
+        sweep_get_point(sweep, state, record.index, record.variables);
+        record.changed = _changed(position > first ? previous : NULL, record.variables);
+        _evaluate(sweep, state, &record);
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            previous[i] = record.variables[i];
+        }
+        if(!_collect(sweep, &record))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Batched mode
+ */
+
+#define SWEEP_BATCH_SIZE 256
+
+int sweep_run_batched(struct sweep* sweep, struct pll_state* state)
+{
+    _start(sweep);
+    size_t first, last;
+    sweep_get_range(sweep, &first, &last);
+    struct sweep_record records[SWEEP_BATCH_SIZE];
+    double variables[PLL_NUM_VARIABLES][SWEEP_BATCH_SIZE];
+    double phasemargin[2][SWEEP_BATCH_SIZE];
+    double f0dB[2][SWEEP_BATCH_SIZE];
+    double fbw[2][SWEEP_BATCH_SIZE];
+    double Jrms[2][SWEEP_BATCH_SIZE];
+    struct batch_input input = { variables[PLL_RF], variables[PLL_CF], variables[PLL_CFX], variables[PLL_GM], NULL, NULL };
+    for(size_t start = first; start < last; start += SWEEP_BATCH_SIZE)
+    {
+        size_t count = last - start < SWEEP_BATCH_SIZE ? last - start : SWEEP_BATCH_SIZE;
+        for(size_t i = 0; i < count; ++i)
+        {
+            records[i].index = sweep_get_index(sweep, start + i);
+            sweep_get_point(sweep, state, records[i].index, records[i].variables);
+            // the last record of the previous (full) batch is still in place when the first one is filled
+            records[i].changed = _changed(start + i > first ? (i > 0 ? records[i - 1].variables : records[SWEEP_BATCH_SIZE - 1].variables) : NULL, records[i].variables);
+            records[i].reused = PLL_REUSE_NONE;
+            for(size_t v = 0; v < PLL_NUM_VARIABLES; ++v)
+            {
+                variables[v][i] = records[i].variables[v];
+            }
+        }
+        for(size_t corner = 0; corner < 2; ++corner)
+        {
+            struct batch_output output = { phasemargin[corner], f0dB[corner], fbw[corner], Jrms[corner] };
+            batch_calculate(state, &input, &output, count, corner);
+        }
+        for(size_t i = 0; i < count; ++i)
+        {
+            struct sweep_record* record = &records[i];
+            for(size_t corner = 0; corner < 2; ++corner)
+            {
+                record->results.phasemargin[corner] = phasemargin[corner][i];
+                record->results.f0dB[corner] = f0dB[corner][i];
+                record->results.fbw[corner] = fbw[corner][i];
+                record->results.Jrms[corner] = Jrms[corner][i];
+                // not calculated by the batched evaluator
+                record->results.Jrms_vco[corner] = NAN;
+                record->results.Jrms_ref[corner] = NAN;
+                record->results.Jrms_cp[corner] = NAN;
+                record->results.Jrms_filter[corner] = NAN;
+            }
+            // a design without a 0 dB crossing has no phase margin
+            record->valid = !isnan(phasemargin[0][i]);
+            record->score = sweep->eval ? pll_get_results_score(&record->results, sweep->eval) : 0.0;
+            if(!_collect(sweep, record))
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ * Pipelined mode
+ */
+
+// points are handed out in runs of consecutive positions, so every evaluator sees neighbouring points
+#define SWEEP_RUN 16
+
+struct candidate {
+    size_t count;
+    size_t index[SWEEP_RUN];
+    double variables[SWEEP_RUN][PLL_NUM_VARIABLES];
+};
+
+struct pipeline {
+    struct sweep* sweep;
+    struct pll_state* state;
+    struct ringbuffer* candidates;
+    struct ringbuffer* results;
+    atomic_int generator_done;
+    atomic_uint evaluators_done;
+    atomic_int abort;
+    atomic_size_t generator_stalls;
+    atomic_size_t evaluator_input_stalls;
+    atomic_size_t evaluator_output_stalls;
+};
+
+static void* _generator(void* arg)
+{
+    struct pipeline* pipeline = arg;
+    size_t first, last;
+    sweep_get_range(pipeline->sweep, &first, &last);
+    size_t stalls = 0;
+    for(size_t start = first; start < last && !atomic_load(&pipeline->abort); start += SWEEP_RUN)
+    {
+        struct candidate candidate;
+        candidate.count = last - start < SWEEP_RUN ? last - start : SWEEP_RUN;
+        for(size_t i = 0; i < candidate.count; ++i)
+        {
+            candidate.index[i] = sweep_get_index(pipeline->sweep, start + i);
+            sweep_get_point(pipeline->sweep, pipeline->state, candidate.index[i], candidate.variables[i]);
+        }
+        while(!ringbuffer_push(pipeline->candidates, &candidate))
+        {
+            if(atomic_load(&pipeline->abort))
+            {
+                break;
+            }
+            ++stalls;
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(&pipeline->generator_stalls, stalls);
+    atomic_store(&pipeline->generator_done, 1);
+    return NULL;
+}
+
+static void* _evaluator(void* arg)
+{
+    struct pipeline* pipeline = arg;
+    struct pll_state* state = pll_clone(pipeline->state);
+    size_t inputstalls = 0;
+    size_t outputstalls = 0;
+    double previous[PLL_NUM_VARIABLES];
+    int first = 1;
+    while(!atomic_load(&pipeline->abort))
+    {
+        struct candidate candidate;
+        if(!ringbuffer_pop(pipeline->candidates, &candidate))
+        {
+            // the generator sets its flag after the last push, so an empty queue after that is final
+            if(!atomic_load(&pipeline->generator_done))
+            {
+                ++inputstalls;
+                sched_yield();
+                continue;
+            }
+            if(!ringbuffer_pop(pipeline->candidates, &candidate))
+            {
+                break;
+            }
+        }
+        for(size_t j = 0; j < candidate.count && !atomic_load(&pipeline->abort); ++j)
+        {
+            struct sweep_record record;
+            record.index = candidate.index[j];
+            for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+            {
+                record.variables[i] = candidate.variables[j][i];
+            }
+            record.changed = _changed(first ? NULL : previous, record.variables);
+            _evaluate(pipeline->sweep, state, &record);
+            for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+            {
+                previous[i] = record.variables[i];
+            }
+            first = 0;
+            while(!ringbuffer_push(pipeline->results, &record))
+            {
+                if(atomic_load(&pipeline->abort))
+                {
+                    break;
+                }
+                ++outputstalls;
+                sched_yield();
+            }
+        }
+    }
+    pll_cleanup(state);
+    atomic_fetch_add(&pipeline->evaluator_input_stalls, inputstalls);
+    atomic_fetch_add(&pipeline->evaluator_output_stalls, outputstalls);
+    atomic_fetch_add(&pipeline->evaluators_done, 1);
+    return NULL;
+}
+
+int sweep_run_pipelined(struct sweep* sweep, struct pll_state* state)
+{
+    _start(sweep);
+    struct pipeline pipeline;
+    pipeline.sweep = sweep;
+    pipeline.state = state;
+    pipeline.candidates = ringbuffer_create(sweep->capacity, sizeof(struct candidate));
+    pipeline.results = ringbuffer_create(sweep->capacity, sizeof(struct sweep_record));
+    atomic_init(&pipeline.generator_done, 0);
+    atomic_init(&pipeline.evaluators_done, 0);
+    atomic_init(&pipeline.abort, 0);
+    atomic_init(&pipeline.generator_stalls, 0);
+    atomic_init(&pipeline.evaluator_input_stalls, 0);
+    atomic_init(&pipeline.evaluator_output_stalls, 0);
+
+    pthread_t generator;
+    pthread_t* evaluators = memory_allocate(sweep->numthreads * sizeof(*evaluators));
+    pthread_create(&generator, NULL, _generator, &pipeline);
+    for(unsigned int i = 0; i < sweep->numthreads; ++i)
+    {
+        pthread_create(&evaluators[i], NULL, _evaluator, &pipeline);
+    }
+
+    // writer stage
+    int status = 1;
+    size_t writerstalls = 0;
+    while(1)
+    {
+        struct sweep_record record;
+        if(ringbuffer_pop(pipeline.results, &record))
+        {
+            if(status && !_collect(sweep, &record))
+            {
+                status = 0;
+                atomic_store(&pipeline.abort, 1);
+            }
+        }
+        else if(atomic_load(&pipeline.evaluators_done) == sweep->numthreads)
+        {
+            if(!ringbuffer_pop(pipeline.results, &record))
+            {
+                break;
+            }
+            if(status && !_collect(sweep, &record))
+            {
+                status = 0;
+                atomic_store(&pipeline.abort, 1);
+            }
+        }
+        else
+        {
+            ++writerstalls;
+            sched_yield();
+        }
+    }
+
+    pthread_join(generator, NULL);
+    for(unsigned int i = 0; i < sweep->numthreads; ++i)
+    {
+        pthread_join(evaluators[i], NULL);
+    }
+    memory_free(evaluators);
+
+    sweep->statistics.generator_stalls = atomic_load(&pipeline.generator_stalls);
+    sweep->statistics.evaluator_input_stalls = atomic_load(&pipeline.evaluator_input_stalls);
+    sweep->statistics.evaluator_output_stalls = atomic_load(&pipeline.evaluator_output_stalls);
+    sweep->statistics.writer_stalls = writerstalls;
+    ringbuffer_destroy(pipeline.candidates);
+    ringbuffer_destroy(pipeline.results);
+    return status;
+}
+
+int sweep_round(const struct sweep* sweep, struct pll_state* state, const double* variables, struct sweep_record* record)
+{
+    // neighbours on every axis, the combinations are enumerated like a mixed-radix counter
+    size_t neighbors[PLL_NUM_VARIABLES][2];
+    size_t numneighbors[PLL_NUM_VARIABLES];
+    size_t numcombinations = 1;
+    for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+    {
+        numneighbors[i] = sweep->axes[i] ? parameter_get_neighbors(sweep->axes[i], variables[i], neighbors[i]) : 1;
+        numcombinations *= numneighbors[i];
+    }
+    int found = 0;
+    for(size_t combination = 0; combination < numcombinations; ++combination)
+    {
+        struct sweep_record candidate;
+        candidate.index = 0;
+        size_t stride = 1;
+        size_t digits = combination;
+        for(size_t i = 0; i < PLL_NUM_VARIABLES; ++i)
+        {
+            if(sweep->axes[i])
+            {
+                size_t idx = neighbors[i][digits % numneighbors[i]];
+                digits /= numneighbors[i];
+                candidate.variables[i] = parameter_get_value(sweep->axes[i], idx);
+                candidate.index += idx * stride;
+                stride *= parameter_get_count(sweep->axes[i]);
+            }
+            else
+            {
+                candidate.variables[i] = pll_get_variable(state, i);
+            }
+        }
+        candidate.changed = _changed(NULL, candidate.variables);
+        _evaluate(sweep, state, &candidate);
+        if(candidate.valid && isfinite(candidate.score) && (!found || candidate.score < record->score || (candidate.score == record->score && candidate.index < record->index)))
+        {
+            *record = candidate;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+int sweep_get_best(const struct sweep* sweep, struct sweep_record* record)
+{
+    if(sweep->hasbest)
+    {
+        *record = sweep->best;
+    }
+    return sweep->hasbest;
+}
+
+void sweep_get_statistics(const struct sweep* sweep, struct sweep_statistics* statistics)
+{
+    *statistics = sweep->statistics;
+}
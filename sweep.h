@@ -0,0 +1,87 @@
+#ifndef PLL_SWEEP_H
+#define PLL_SWEEP_H
+
+#include <stddef.h>
+
+#include "parameter.h"
+#include "pll.h"
+
+// one evaluated grid point
+struct sweep_record {
+    size_t index; // linear grid index (PLL_RF varies fastest)
+    double variables[PLL_NUM_VARIABLES];
+    unsigned int changed; // variables that differ from the previous point of the same evaluator (bit 1 << pll_variable)
+    unsigned int reused; // intermediates reused by pll_calculate (PLL_REUSE_* bits, always 0 with a database or in the batched mode)
+    int valid;
+    double score;
+    struct pll_results results;
+};
+
+// counts how often a stage had to wait for its neighbours
+struct sweep_statistics {
+    size_t evaluated;
+    size_t generator_stalls; // candidate queue full
+    size_t evaluator_input_stalls; // candidate queue empty
+    size_t evaluator_output_stalls; // result queue full
+    size_t writer_stalls; // result queue empty
+    size_t changed; // sum of the number of changed variables over all points
+    size_t filter_reused; // points that reused the filter of the previous point
+};
+
+// order in which the grid is visited
+enum sweep_order {
+    SWEEP_ORDER_LINEAR, // nested loops, PLL_RF varies fastest and jumps back to its start
+    SWEEP_ORDER_SERPENTINE // boustrophedon (reflected mixed-radix Gray code): exactly one variable changes by one step between neighbours
+};
+
+// called for every evaluated point (in the pipelined mode in completion order, not in grid order)
+// a return value of 0 aborts writing further records
+typedef int (*sweep_writer)(const struct sweep_record* record, void* userdata);
+
+struct sweep;
+struct database;
+
+struct sweep* sweep_create(void);
+void sweep_destroy(struct sweep* sweep);
+// the sweep does not take ownership of the parameter, axes that are not set keep the value of the pll_state
+void sweep_set_axis(struct sweep* sweep, enum pll_variable variable, struct parameter* parameter);
+void sweep_set_evaluator(struct sweep* sweep, evaluator eval);
+void sweep_set_writer(struct sweep* sweep, sweep_writer writer, void* userdata);
+// serve points from a design database (and store new ones in it)
+void sweep_set_database(struct sweep* sweep, struct database* database);
+void sweep_set_threads(struct sweep* sweep, unsigned int numthreads);
+void sweep_set_queue_capacity(struct sweep* sweep, size_t capacity);
+// only evaluate the slice 'index' of 'count' equally sized contiguous slices of the grid (for multi-process runs)
+void sweep_set_shard(struct sweep* sweep, size_t index, size_t count);
+// the pipelined mode hands out runs of consecutive points to keep the neighbourhood per evaluator
+void sweep_set_order(struct sweep* sweep, enum sweep_order order);
+size_t sweep_get_size(const struct sweep* sweep);
+// first and last (exclusive) position of the current shard (shards are contiguous in visiting order)
+void sweep_get_range(const struct sweep* sweep, size_t* first, size_t* last);
+// linear grid index of the point at 'position' in visiting order
+size_t sweep_get_index(const struct sweep* sweep, size_t position);
+void sweep_get_point(const struct sweep* sweep, const struct pll_state* state, size_t index, double* variables);
+
+// run the sweep on the calling thread
+int sweep_run(struct sweep* sweep, struct pll_state* state);
+// run the sweep with a generator thread, a pool of evaluator threads (working on clones of 'state')
+// and the writer on the calling thread, connected by bounded queues
+int sweep_run_pipelined(struct sweep* sweep, struct pll_state* state);
+
+// run the sweep on the calling thread with the batched evaluator (see batch.h),
+// the records only contain phase margin, unity-gain frequency, bandwidth and Jrms (the contributions are NaN),
+// a record is valid if the phase margin of the minimum Kvco corner could be determined,
+// a database set with sweep_set_database is not used
+int sweep_run_batched(struct sweep* sweep, struct pll_state* state);
+
+// rounds a continuous design (e.g. an optimum of synthesis or anytime) to the grid: evaluates all combinations of the
+// neighbouring grid values on every axis (at most 2^axes points, see parameter_get_neighbors) and returns the best valid one
+// (only points with a finite score count)
+// in 'record' (0 if none is valid), the last run and the writer are not affected
+int sweep_round(const struct sweep* sweep, struct pll_state* state, const double* variables, struct sweep_record* record);
+
+// best (lowest score, lowest index on ties) valid point with a finite score of the last run, returns 0 if there is none
+int sweep_get_best(const struct sweep* sweep, struct sweep_record* record);
+void sweep_get_statistics(const struct sweep* sweep, struct sweep_statistics* statistics);
+
+#endif /* PLL_SWEEP_H */
@@ -0,0 +1,174 @@
+#include "synthesis.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "constants.h"
+#include "pll_internal.h"
+
+// convergence tolerances (relative unity-gain frequency, phase margin in degree)
+#define SYNTHESIS_TOLERANCE_F0DB 1e-4
+#define SYNTHESIS_TOLERANCE_PHASEMARGIN 1e-2
+// relative step for the finite-difference Jacobian
+#define SYNTHESIS_DELTA 1e-4
+
+int synthesis_closed_form(const struct pll_state* state, const struct synthesis_target* target, double* Rf, double* Cf, double* Cfx)
+{
+    // Hloop = K * (1 + s * tz) / (s^2 * Ctot * (1 + s * tz / b)) with
+    // K = detectorgain * gm * 2 * pi * Kvco, Ctot = Cf + Cfx, tz = Rf * Cf and b = 1 + Cf / Cfx
+    double Kvco = sqrt(state->min_Kvco * state->max_Kvco);
+    double K = state->detectorgain * state->gm * 2 * CONSTANTS_PI * Kvco;
+    double wc = 2 * CONSTANTS_PI * target->f0dB;
+    double t = tan(target->phasemargin * CONSTANTS_PI / 180);
+    if(target->phasemargin <= 0 || target->phasemargin >= 90)
+    {
+        fprintf(stderr, "synthesis: phase margin must lie between 0 and 90 degree\n");
+        return 0;
+    }
+    // x = wc * tz from atan(x) - atan(x / b) = phase margin, i.e. (t / b) * x^2 - (1 - 1 / b) * x + t = 0
+    // the smaller root is used (zero closer to the crossover, becomes x = t for Cfx = 0)
+    double x;
+    double invb = 0.0;
+    if(target->ratio > 0)
+    {
+        invb = target->ratio / (1 + target->ratio);
+        double B = 1 - invb;
+        double discriminant = B * B - 4 * t * t * invb;
+        if(discriminant < 0)
+        {
+            fprintf(stderr, "synthesis: phase margin of %g degree is not reachable with Cfx / Cf = %g\n", target->phasemargin, target->ratio);
+            return 0;
+        }
+        x = 2 * t / (B + sqrt(discriminant));
+    }
+    else
+    {
+        x = t;
+    }
+    double tz = x / wc;
+    // |Hloop(j * wc)| = 1
+    double Ctot = K * sqrt(1 + x * x) / (wc * wc * sqrt(1 + x * x * invb * invb));
+    *Cf = Ctot / (1 + target->ratio);
+    *Cfx = target->ratio * *Cf;
+    *Rf = tz / *Cf;
+    return 1;
+}
+
+// residuals: log(f0dB / target) and phase margin - target
+static void _evaluate(struct pll_state* state, const struct synthesis_target* target, double Rf, double Cf, double* residuals, size_t* evaluations)
+{
+    pll_set_filter(state, Rf, Cf, target->ratio * Cf);
+    pll_calculate(state);
+    ++*evaluations;
+    double f0dB = sqrt(state->f0dB[0] * state->f0dB[1]);
+    double phasemargin = fmin(state->phasemargin[0], state->phasemargin[1]);
+    residuals[0] = log(f0dB / target->f0dB);
+    residuals[1] = phasemargin - target->phasemargin;
+}
+
+static double _error(const double* residuals)
+{
+    double e0 = residuals[0] / SYNTHESIS_TOLERANCE_F0DB;
+    double e1 = residuals[1] / SYNTHESIS_TOLERANCE_PHASEMARGIN;
+    return e0 * e0 + e1 * e1;
+}
+
+int synthesis_run(struct pll_state* state, const struct synthesis_target* target, size_t maxiterations, struct synthesis_result* result)
+{
+    double Rf, Cf, Cfx;
+    result->iterations = 0;
+    result->evaluations = 0;
+    if(!synthesis_closed_form(state, target, &Rf, &Cf, &Cfx))
+    {
+        return 0;
+    }
+    return synthesis_run_from(state, target, Rf, Cf, maxiterations, result);
+}
+
+int synthesis_run_from(struct pll_state* state, const struct synthesis_target* target, double Rf, double Cf, size_t maxiterations, struct synthesis_result* result)
+{
+    result->iterations = 0;
+    result->evaluations = 0;
+    // pll_calculate can only find a crossing inside the evaluation grid
+    double flower = pow(10, state->flowerexp);
+    double fupper = pow(10, state->fupperexp);
+    if(!(target->f0dB > flower && target->f0dB < fupper))
+    {
+        fprintf(stderr, "synthesis: unity-gain frequency of %g Hz lies outside the evaluation grid (%g Hz to %g Hz)\n", target->f0dB, flower, fupper);
+        return 0;
+    }
+    if(!(Rf > 0 && Cf > 0 && isfinite(Rf) && isfinite(Cf)))
+    {
+        fprintf(stderr, "synthesis: invalid start (Rf = %g Ohm, Cf = %g F)\n", Rf, Cf);
+        return 0;
+    }
+
+    // Newton iteration in u = (log(Rf), log(Cf)), Cfx follows Cf with the target ratio
+    double residuals[2];
+    _evaluate(state, target, Rf, Cf, residuals, &result->evaluations);
+    double error = _error(residuals);
+    int converged = error <= 2.0;
+    int current = 1; // the state holds the results of (Rf, Cf)
+    while(!converged && result->iterations < maxiterations)
+    {
+        ++result->iterations;
+        current = 0;
+        // Jacobian by forward differences
+        double J[2][2];
+        double perturbed[2];
+        _evaluate(state, target, Rf * exp(SYNTHESIS_DELTA), Cf, perturbed, &result->evaluations);
+        J[0][0] = (perturbed[0] - residuals[0]) / SYNTHESIS_DELTA;
+        J[1][0] = (perturbed[1] - residuals[1]) / SYNTHESIS_DELTA;
+        _evaluate(state, target, Rf, Cf * exp(SYNTHESIS_DELTA), perturbed, &result->evaluations);
+        J[0][1] = (perturbed[0] - residuals[0]) / SYNTHESIS_DELTA;
+        J[1][1] = (perturbed[1] - residuals[1]) / SYNTHESIS_DELTA;
+        double det = J[0][0] * J[1][1] - J[0][1] * J[1][0];
+        if(det == 0 || !isfinite(det))
+        {
+            break;
+        }
+        double du0 = -(J[1][1] * residuals[0] - J[0][1] * residuals[1]) / det;
+        double du1 = -(-J[1][0] * residuals[0] + J[0][0] * residuals[1]) / det;
+
+        // damping: halve the step until the error decreases
+        double step = 1.0;
+        int improved = 0;
+        while(step > 1.0 / 64)
+        {
+            double newRf = Rf * exp(step * du0);
+            double newCf = Cf * exp(step * du1);
+            double newresiduals[2];
+            _evaluate(state, target, newRf, newCf, newresiduals, &result->evaluations);
+            double newerror = _error(newresiduals);
+            if(newerror < error)
+            {
+                Rf = newRf;
+                Cf = newCf;
+                residuals[0] = newresiduals[0];
+                residuals[1] = newresiduals[1];
+                error = newerror;
+                improved = 1;
+                current = 1;
+                break;
+            }
+            step *= 0.5;
+        }
+        if(!improved)
+        {
+            break;
+        }
+        converged = error <= 2.0;
+    }
+
+    // leave the state with the final filter (and its results)
+    if(!current)
+    {
+        _evaluate(state, target, Rf, Cf, residuals, &result->evaluations);
+    }
+    result->Rf = Rf;
+    result->Cf = Cf;
+    result->Cfx = target->ratio * Cf;
+    result->f0dB = sqrt(state->f0dB[0] * state->f0dB[1]);
+    result->phasemargin = fmin(state->phasemargin[0], state->phasemargin[1]);
+    return converged;
+}
@@ -0,0 +1,38 @@
+#ifndef PLL_SYNTHESIS_H
+#define PLL_SYNTHESIS_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Direct synthesis of the loop filter (Rf, Cf, Cfx) for a target unity-gain frequency and phase margin.
+// The filter is first computed in closed form for the ideal loop (no parasitic poles, Kvco = sqrt(min_Kvco * max_Kvco)),
+// then a damped Newton iteration on pll_calculate corrects for everything the closed form ignores.
+// Targets refer to the metrics of pll_calculate: the unity-gain frequency is the geometric mean of both Kvco corners,
+// the phase margin is the worse of both corners.
+
+struct synthesis_target {
+    double f0dB;
+    double phasemargin; // in degree
+    double ratio; // Cfx / Cf (0: no Cfx)
+};
+
+struct synthesis_result {
+    double Rf;
+    double Cf;
+    double Cfx;
+    double f0dB;
+    double phasemargin;
+    size_t iterations;
+    size_t evaluations; // number of pll_calculate calls
+};
+
+// computes the closed-form filter only (no evaluation), returns 0 if the phase margin can not be reached with the given ratio
+int synthesis_closed_form(const struct pll_state* state, const struct synthesis_target* target, double* Rf, double* Cf, double* Cfx);
+// synthesizes the filter and leaves it set in 'state', returns 0 if the iteration did not converge
+// or if the target can not be synthesized (e.g. a unity-gain frequency outside the evaluation grid, result->evaluations is 0)
+int synthesis_run(struct pll_state* state, const struct synthesis_target* target, size_t maxiterations, struct synthesis_result* result);
+// same as synthesis_run, but the Newton iteration starts at the given filter instead of the closed form (a warm start)
+int synthesis_run_from(struct pll_state* state, const struct synthesis_target* target, double Rf, double Cf, size_t maxiterations, struct synthesis_result* result);
+
+#endif /* PLL_SYNTHESIS_H */
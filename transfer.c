@@ -39,13 +39,13 @@ static double complex _get_value(struct vector* values, size_t idx, double frac)
     return vector_get(values, idx) + frac * (vector_get(values, idx) - vector_get(values, idx - 1));
 }
 
-int transfer_phase_margin(struct vector* f, struct vector* H, double* result)
+int transfer_phase_margin(struct workspace* workspace, struct vector* f, struct vector* H, double* result)
 {
     size_t idx;
     double frac;
     if(_find_0dB(H, &idx, &frac))
     {
-        struct vector* phase = vector_phase(H);
+        struct vector* phase = vector_phase_in(workspace, H);
         *result = creal(_get_value(phase, idx, frac)) + 180;
         vector_destroy(phase);
         return 1;
@@ -5,7 +5,8 @@
 
 int transfer_find_0dB(struct vector* f, struct vector* H, double* result);
 int transfer_unity_gain_frequency(struct vector* f, struct vector* H, double* result);
-int transfer_phase_margin(struct vector* f, struct vector* H, double* result);
+// the unwrapped phase is a temporary of 'workspace' (heap if NULL), the workspace is not reset
+int transfer_phase_margin(struct workspace* workspace, struct vector* f, struct vector* H, double* result);
 int transfer_lowpass_bandwidth(struct vector* f, struct vector* H, double* result);
 
 #endif /* PLL_TRANSFER_H */
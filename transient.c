@@ -0,0 +1,286 @@
+#include "transient.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "constants.h"
+#include "memory.h"
+#include "pll_internal.h"
+
+// state vector: phase error at the detector, voltage of Cf, voltage of Cfx (only if Cfx > 0),
+// outputs of the parasitic poles, (constant) frequency step at the detector in rad/s
+
+struct transient {
+    double step;
+    double tolerance;
+    double phaserange;
+    double timestep;
+    size_t maxsteps;
+
+    // prepared model
+    size_t dimension;
+    double h;
+    double* Phi; // exp(A h), dimension x dimension (row major)
+    double* vco; // VCO input voltage as a function of the state
+    double Kvco;
+    unsigned int N;
+};
+
+struct transient* transient_create(void)
+{
+    struct transient* transient = memory_allocate_zeroed(1, sizeof(*transient));
+    transient->step = 1e6;
+    transient->tolerance = 1e3;
+    transient->phaserange = 2 * CONSTANTS_PI;
+    transient->timestep = 0.0;
+    transient->maxsteps = 100000;
+    return transient;
+}
+
+void transient_destroy(struct transient* transient)
+{
+    memory_free(transient->Phi);
+    memory_free(transient->vco);
+    memory_free(transient);
+}
+
+void transient_set_frequency_step(struct transient* transient, double step)
+{
+    transient->step = step;
+}
+
+void transient_set_tolerance(struct transient* transient, double tolerance)
+{
+    transient->tolerance = tolerance;
+}
+
+void transient_set_phase_range(struct transient* transient, double range)
+{
+    transient->phaserange = range;
+}
+
+void transient_set_time_step(struct transient* transient, double seconds)
+{
+    transient->timestep = seconds;
+}
+
+void transient_set_max_steps(struct transient* transient, size_t steps)
+{
+    transient->maxsteps = steps;
+}
+
+// result = a * b (n x n, result must not alias a or b)
+static void _matrix_multiply(size_t n, const double* a, const double* b, double* result)
+{
+    for(size_t i = 0; i < n; ++i)
+    {
+        for(size_t j = 0; j < n; ++j)
+        {
+            double sum = 0.0;
+            for(size_t k = 0; k < n; ++k)
+            {
+                sum += a[i * n + k] * b[k * n + j];
+            }
+            result[i * n + j] = sum;
+        }
+    }
+}
+
+// exp(A) by scaling and squaring: the Taylor series of exp(A / 2^s) with |A / 2^s| <= 1/2 converges to
+// double precision after 18 terms
+static void _matrix_exponential(size_t n, const double* A, double* result)
+{
+    double norm = 0.0;
+    for(size_t i = 0; i < n; ++i)
+    {
+        double row = 0.0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            row += fabs(A[i * n + j]);
+        }
+        norm = row > norm ? row : norm;
+    }
+    int squarings = norm > 0.5 ? (int)ceil(log2(norm / 0.5)) : 0;
+    double scale = ldexp(1.0, -squarings);
+
+    // Horner: I + B (I + B / 2 (I + B / 3 (...)))
+    double B[n * n];
+    double temporary[n * n];
+    for(size_t i = 0; i < n * n; ++i)
+    {
+        B[i] = A[i] * scale;
+        result[i] = 0.0;
+    }
+    for(size_t i = 0; i < n; ++i)
+    {
+        result[i * n + i] = 1.0;
+    }
+    for(int k = 18; k >= 1; --k)
+    {
+        _matrix_multiply(n, B, result, temporary);
+        for(size_t i = 0; i < n * n; ++i)
+        {
+            result[i] = temporary[i] / k;
+        }
+        for(size_t i = 0; i < n; ++i)
+        {
+            result[i * n + i] += 1.0;
+        }
+    }
+    for(int i = 0; i < squarings; ++i)
+    {
+        _matrix_multiply(n, result, result, temporary);
+        memcpy(result, temporary, n * n * sizeof(*result));
+    }
+}
+
+int transient_prepare(struct transient* transient, const struct pll_state* state, size_t corner)
+{
+    if(!(state->Rf > 0) || !(state->Cf > 0))
+    {
+        return 0;
+    }
+    double Kvco = corner == 0 ? state->min_Kvco : state->max_Kvco;
+    double Kpd = state->detectorgain * state->gm; // charge pump current per rad of phase error
+    int hasCfx = state->Cfx > 0;
+
+    size_t phase = 0;
+    size_t Cf = 1;
+    size_t Cfx = 2;
+    size_t poles = hasCfx ? 3 : 2;
+    size_t frequency = poles + state->numparpoles;
+    size_t n = frequency + 1;
+
+    double A[n * n];
+    double u[n]; // input of the current stage
+    memset(A, 0, sizeof(A));
+    memset(u, 0, sizeof(u));
+
+    // filter: Rf in series with Cf, Cfx in parallel (the filter output is the voltage of Cfx)
+    if(hasCfx)
+    {
+        double Rfcurrent = 1 / state->Rf; // per volt of (Vcfx - Vcf)
+        A[Cf * n + Cfx] = Rfcurrent / state->Cf;
+        A[Cf * n + Cf] = -Rfcurrent / state->Cf;
+        A[Cfx * n + phase] = Kpd / state->Cfx;
+        A[Cfx * n + Cfx] = -Rfcurrent / state->Cfx;
+        A[Cfx * n + Cf] = Rfcurrent / state->Cfx;
+        u[Cfx] = 1;
+    }
+    else
+    {
+        // without Cfx the output is Vcf + Rf * i
+        A[Cf * n + phase] = Kpd / state->Cf;
+        u[Cf] = 1;
+        u[phase] = state->Rf * Kpd;
+    }
+
+    // parasitic poles (pole in Hz, negative for a stable pole): dx/dt = a (u - x) with a = -2 pi pole
+    for(size_t i = 0; i < state->numparpoles; ++i)
+    {
+        size_t row = poles + i;
+        double a = -2 * CONSTANTS_PI * state->parpoles[i];
+        for(size_t j = 0; j < n; ++j)
+        {
+            A[row * n + j] = a * u[j];
+            u[j] = 0;
+        }
+        A[row * n + row] -= a;
+        u[row] = 1;
+    }
+
+    // phase error: d/dt (phi_ref - phi_out / N) = step - 2 pi Kvco v / N
+    for(size_t j = 0; j < n; ++j)
+    {
+        A[phase * n + j] = -2 * CONSTANTS_PI * Kvco / state->N * u[j];
+    }
+    A[phase * n + frequency] = 1;
+
+    // time step from the natural frequency of the loop (as if Cfx and the parasitic poles were absent)
+    double h = transient->timestep;
+    if(!(h > 0))
+    {
+        double naturalfrequency = sqrt(Kpd * 2 * CONSTANTS_PI * Kvco / (state->N * (state->Cf + state->Cfx)));
+        h = 2 * CONSTANTS_PI / naturalfrequency / 64;
+    }
+    for(size_t i = 0; i < n * n; ++i)
+    {
+        A[i] *= h;
+    }
+    if(n != transient->dimension)
+    {
+        transient->Phi = memory_reallocate(transient->Phi, n * n * sizeof(*transient->Phi));
+        transient->vco = memory_reallocate(transient->vco, n * sizeof(*transient->vco));
+        transient->dimension = n;
+    }
+    _matrix_exponential(n, A, transient->Phi);
+    memcpy(transient->vco, u, n * sizeof(*u));
+    transient->h = h;
+    transient->Kvco = Kvco;
+    transient->N = state->N;
+    return 1;
+}
+
+void transient_run(struct transient* transient, struct transient_result* result)
+{
+    size_t n = transient->dimension;
+    double x[n];
+    double next[n];
+    memset(x, 0, sizeof(x));
+    x[n - 1] = 2 * CONSTANTS_PI * transient->step / transient->N;
+
+    memset(result, 0, sizeof(*result));
+    double peak = 0.0; // relative to the step
+    size_t lastoutside = 0;
+    size_t k;
+    for(k = 1; k <= transient->maxsteps; ++k)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            double sum = 0.0;
+            for(size_t j = 0; j < n; ++j)
+            {
+                sum += transient->Phi[i * n + j] * x[j];
+            }
+            next[i] = sum;
+        }
+        memcpy(x, next, sizeof(x));
+
+        double v = 0.0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            v += transient->vco[j] * x[j];
+        }
+        double frequency = transient->Kvco * v;
+        if(transient->step != 0 && frequency / transient->step > peak)
+        {
+            peak = frequency / transient->step;
+        }
+        double phaseerror = fabs(x[0]);
+        result->peakphaseerror = phaseerror > result->peakphaseerror ? phaseerror : result->peakphaseerror;
+        if(fabs(frequency - transient->step) > transient->tolerance)
+        {
+            lastoutside = k;
+        }
+        else if(k >= 2 * lastoutside)
+        {
+            // within the tolerance for as long as it took to get there
+            break;
+        }
+    }
+    result->steps = k > transient->maxsteps ? transient->maxsteps : k;
+    result->settled = lastoutside < result->steps;
+    result->settlingtime = lastoutside * transient->h;
+    result->overshoot = peak > 1 ? peak - 1 : 0.0;
+    result->cycleslip = result->peakphaseerror > transient->phaserange;
+}
+
+int transient_simulate(struct transient* transient, const struct pll_state* state, size_t corner, struct transient_result* result)
+{
+    if(!transient_prepare(transient, state, corner))
+    {
+        return 0;
+    }
+    transient_run(transient, result);
+    return 1;
+}
@@ -0,0 +1,50 @@
+#ifndef PLL_TRANSIENT_H
+#define PLL_TRANSIENT_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Behavioural lock transient of the linearized loop (the time domain counterpart of pll_calculate):
+// response of the output frequency to a step of the target frequency, e.g. a channel change.
+// The loop of pll_calculate (detector gain, charge pump, Rf/Cf/Cfx filter, parasitic poles, Kvco and the divider N)
+// is built as a continuous state-space model dx/dt = A x. The frequency step is an additional constant state,
+// so the model is autonomous and is discretized exactly with one matrix exponential exp(A h) per design
+// (scaling and squaring, stiff parasitic poles need no smaller time step). A time step then is a matrix-vector product.
+// The simulation stops once the output stayed within the tolerance for as long as it took to get there
+// (or after the maximum number of steps).
+// The model is linear: a cycle slip is only flagged, when the phase error at the detector leaves the linear range.
+
+struct transient_result {
+    double settlingtime; // in seconds: last time the output frequency error exceeded the tolerance
+    double overshoot; // peak output frequency beyond the step, relative to the step
+    double peakphaseerror; // in rad at the detector
+    int cycleslip; // the peak phase error exceeds the linear range of the detector
+    int settled; // within the tolerance at the end of the simulation
+    size_t steps;
+};
+
+struct transient;
+
+struct transient* transient_create(void);
+void transient_destroy(struct transient* transient);
+// step of the output frequency in Hz (default: 1 MHz)
+void transient_set_frequency_step(struct transient* transient, double step);
+// settling band of the output frequency in Hz (default: 1 kHz)
+void transient_set_tolerance(struct transient* transient, double tolerance);
+// linear range of the phase detector in rad (default: 2 pi, a phase-frequency detector)
+void transient_set_phase_range(struct transient* transient, double range);
+// time step in seconds (0: 1/64 of the period of the natural frequency of the loop, default)
+void transient_set_time_step(struct transient* transient, double seconds);
+// default: 100000
+void transient_set_max_steps(struct transient* transient, size_t steps);
+
+// builds and discretizes the model of the design in 'state' for one Kvco corner (0: min_Kvco, 1: max_Kvco),
+// returns 0 if the filter values can not be simulated (Rf or Cf not positive)
+int transient_prepare(struct transient* transient, const struct pll_state* state, size_t corner);
+// simulates the prepared model (can be repeated with other steps and tolerances, the model depends on the time step only)
+void transient_run(struct transient* transient, struct transient_result* result);
+// prepare and run
+int transient_simulate(struct transient* transient, const struct pll_state* state, size_t corner, struct transient_result* result);
+
+#endif /* PLL_TRANSIENT_H */
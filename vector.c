@@ -1,3 +1,5 @@
+#include "vector.h"
+
 #include <assert.h>
 #include <complex.h>
 #include <math.h>
@@ -6,23 +8,125 @@
 #include <stdio.h>
 
 #include "constants.h"
+#include "memory.h"
+
+#define WORKSPACE_ALIGNMENT 64
 
-struct vector {
-    double complex* values;
-    size_t size;
+struct workspace {
+    char* memory;
+    size_t capacity;
+    size_t used;
+    // allocations that did not fit into 'memory' (freed by the next reset, which grows 'memory' to the demand)
+    void** overflow;
+    size_t numoverflow;
+    size_t overflowcapacity;
+    size_t demand; // bytes requested since the last reset
+    size_t heapallocations;
 };
 
-struct vector* _create(size_t size)
+static size_t _align(size_t bytes)
+{
+    return (bytes + WORKSPACE_ALIGNMENT - 1) / WORKSPACE_ALIGNMENT * WORKSPACE_ALIGNMENT;
+}
+
+struct workspace* workspace_create(size_t bytes)
+{
+    struct workspace* workspace = memory_allocate_zeroed(1, sizeof(*workspace));
+    workspace->capacity = _align(bytes);
+    if(workspace->capacity > 0)
+    {
+        workspace->memory = memory_allocate_aligned(WORKSPACE_ALIGNMENT, workspace->capacity);
+        ++workspace->heapallocations;
+    }
+    return workspace;
+}
+
+void workspace_reset(struct workspace* workspace)
+{
+    if(workspace->numoverflow > 0)
+    {
+        // the demand of this round did not fit: replace the overflow blocks by one larger block
+        for(size_t i = 0; i < workspace->numoverflow; ++i)
+        {
+            memory_free(workspace->overflow[i]);
+        }
+        workspace->numoverflow = 0;
+        memory_free(workspace->memory);
+        workspace->capacity = workspace->demand;
+        workspace->memory = memory_allocate_aligned(WORKSPACE_ALIGNMENT, workspace->capacity);
+        ++workspace->heapallocations;
+    }
+    workspace->used = 0;
+    workspace->demand = 0;
+}
+
+void workspace_destroy(struct workspace* workspace)
+{
+    for(size_t i = 0; i < workspace->numoverflow; ++i)
+    {
+        memory_free(workspace->overflow[i]);
+    }
+    memory_free(workspace->overflow);
+    memory_free(workspace->memory);
+    memory_free(workspace);
+}
+
+size_t workspace_get_capacity(const struct workspace* workspace)
+{
+    return workspace->capacity;
+}
+
+size_t workspace_get_heap_allocations(const struct workspace* workspace)
+{
+    return workspace->heapallocations;
+}
+
+static void* _allocate(struct workspace* workspace, size_t bytes)
 {
-    struct vector* vector = malloc(sizeof(*vector));
-    vector->values = malloc(size * sizeof(*vector->values));
+    bytes = _align(bytes);
+    workspace->demand += bytes;
+    if(workspace->used + bytes <= workspace->capacity)
+    {
+        void* memory = workspace->memory + workspace->used;
+        workspace->used += bytes;
+        return memory;
+    }
+    if(workspace->numoverflow == workspace->overflowcapacity)
+    {
+        workspace->overflowcapacity = workspace->overflowcapacity > 0 ? 2 * workspace->overflowcapacity : 8;
+        workspace->overflow = memory_reallocate(workspace->overflow, workspace->overflowcapacity * sizeof(*workspace->overflow));
+        ++workspace->heapallocations;
+    }
+    void* memory = memory_allocate_aligned(WORKSPACE_ALIGNMENT, bytes);
+    ++workspace->heapallocations;
+    workspace->overflow[workspace->numoverflow++] = memory;
+    return memory;
+}
+
+static struct vector* _create(struct workspace* workspace, size_t size)
+{
+    struct vector* vector;
+    if(workspace)
+    {
+        vector = _allocate(workspace, sizeof(*vector));
+        vector->values = _allocate(workspace, size * sizeof(*vector->values));
+        vector->arena = 1;
+        vector->view = 0;
+    }
+    else
+    {
+        vector = memory_allocate(sizeof(*vector));
+        vector->values = memory_allocate(size * sizeof(*vector->values));
+        vector->arena = 0;
+        vector->view = 0;
+    }
     vector->size = size;
     return vector;
 }
 
-struct vector* vector_create(size_t size, double complex value)
+struct vector* vector_create_in(struct workspace* workspace, size_t size, double complex value)
 {
-    struct vector* vector = _create(size);
+    struct vector* vector = _create(workspace, size);
     for(size_t i = 0; i < vector->size; ++i)
     {
         vector->values[i] = value;
@@ -30,10 +134,30 @@ struct vector* vector_create(size_t size, double complex value)
     return vector;
 }
 
+struct vector* vector_create(size_t size, double complex value)
+{
+    return vector_create_in(NULL, size, value);
+}
+
 void vector_destroy(struct vector* vector)
 {
-    free(vector->values);
-    free(vector);
+    if(vector->arena || vector->view)
+    {
+        return;
+    }
+    memory_free(vector->values);
+    memory_free(vector);
+}
+
+struct vector vector_view(const struct vector* vector, size_t offset, size_t size)
+{
+    assert(offset + size <= vector->size);
+    struct vector view;
+    view.values = vector->values + offset;
+    view.size = size;
+    view.arena = 0;
+    view.view = 1;
+    return view;
 }
 
 void vector_set(struct vector* vector, size_t idx, double complex value)
@@ -63,16 +187,19 @@ double complex vector_get(struct vector* vector, size_t idx)
     return vector->values[idx];
 }
 
+double complex* vector_data(const struct vector* vector)
+{
+    return vector->values;
+}
+
 size_t vector_size(const struct vector* vector)
 {
     return vector->size;
 }
 
-struct vector* vector_copy(const struct vector* vector)
+struct vector* vector_copy_in(struct workspace* workspace, const struct vector* vector)
 {
-    struct vector* new = malloc(sizeof(*new));
-    new->values = malloc(vector->size * sizeof(*new->values));
-    new->size = vector->size;
+    struct vector* new = _create(workspace, vector->size);
     for(size_t i = 0; i < vector->size; ++i)
     {
         new->values[i] = vector->values[i];
@@ -80,6 +207,11 @@ struct vector* vector_copy(const struct vector* vector)
     return new;
 }
 
+struct vector* vector_copy(const struct vector* vector)
+{
+    return vector_copy_in(NULL, vector);
+}
+
 void vector_add_scalar(struct vector* vector, double complex value)
 {
     for(size_t i = 0; i < vector->size; ++i)
@@ -105,6 +237,15 @@ void vector_add(struct vector* a, const struct vector* b)
     }
 }
 
+void vector_add_scaled(struct vector* a, const struct vector* b, double complex factor)
+{
+    assert(a->size == b->size);
+    for(size_t i = 0; i < a->size; ++i)
+    {
+        a->values[i] += factor * b->values[i];
+    }
+}
+
 void vector_multiply(struct vector* multiplicand, const struct vector* multiplier)
 {
     assert(multiplicand->size == multiplier->size);
@@ -140,9 +281,9 @@ void vector_abs_squared(struct vector* vector)
     }
 }
 
-struct vector* vector_magnitude(const struct vector* vector)
+struct vector* vector_magnitude_in(struct workspace* workspace, const struct vector* vector)
 {
-    struct vector* result = vector_copy(vector);
+    struct vector* result = vector_copy_in(workspace, vector);
     for(size_t i = 0; i < result->size; ++i)
     {
         result->values[i] = cabs(result->values[i]);
@@ -150,9 +291,14 @@ struct vector* vector_magnitude(const struct vector* vector)
     return result;
 }
 
-struct vector* vector_phase(struct vector* vector)
+struct vector* vector_magnitude(const struct vector* vector)
 {
-    struct vector* result = vector_copy(vector);
+    return vector_magnitude_in(NULL, vector);
+}
+
+struct vector* vector_phase_in(struct workspace* workspace, const struct vector* vector)
+{
+    struct vector* result = vector_copy_in(workspace, vector);
     for(size_t i = 0; i < result->size; ++i)
     {
         result->values[i] = 180 / CONSTANTS_PI * carg(result->values[i]);
@@ -177,6 +323,11 @@ struct vector* vector_phase(struct vector* vector)
     return result;
 }
 
+struct vector* vector_phase(const struct vector* vector)
+{
+    return vector_phase_in(NULL, vector);
+}
+
 void vector_print(const struct vector* vector)
 {
     for(size_t i = 0; i < vector->size; ++i)
@@ -188,7 +339,7 @@ void vector_print(const struct vector* vector)
 
 struct vector* vector_logspace(double a, double b, unsigned int N)
 {
-    struct vector* x = _create(N);
+    struct vector* x = _create(NULL, N);
     double factor = pow(10, (b - a) / (N - 1));
     for(size_t i = 0; i < N; ++i)
     {
@@ -4,25 +4,55 @@
 #include <complex.h>
 #include <stddef.h>
 
-struct vector;
+// the layout is public only so that views can be held by value (on the stack), use the functions to access a vector
+struct vector {
+    double complex* values;
+    size_t size;
+    int arena; // allocated from a workspace, released by workspace_reset
+    int view; // shares the values of another vector, see vector_view
+};
 
+// Bump allocator for temporary vectors (one per thread, e.g. per pll_state): vectors are allocated from one block
+// with 64 byte alignment and are all released at once by workspace_reset (vector_destroy does nothing for them).
+// Allocations that do not fit are taken from the heap and the block grows to the demand on the next reset,
+// so a workload that repeats itself makes no heap calls after the first round.
+struct workspace;
+
+struct workspace* workspace_create(size_t bytes);
+void workspace_destroy(struct workspace* workspace);
+// O(1) unless the block has to grow, invalidates all vectors of the workspace
+void workspace_reset(struct workspace* workspace);
+size_t workspace_get_capacity(const struct workspace* workspace);
+size_t workspace_get_heap_allocations(const struct workspace* workspace);
+
+// the *_in variants allocate the result in 'workspace' (or on the heap if it is NULL)
 struct vector* vector_create(size_t size, double complex value);
-struct vector* vector_destroy(struct vector* vector);
+struct vector* vector_create_in(struct workspace* workspace, size_t size, double complex value);
+void vector_destroy(struct vector* vector);
+// non-owning slice [offset, offset + size) of 'vector' without any allocation, valid as long as 'vector' is
+// (vector_destroy does nothing for it)
+struct vector vector_view(const struct vector* vector, size_t offset, size_t size);
 void vector_set(struct vector* vector, size_t idx, double complex value);
 void vector_set_all(struct vector* vector, double complex value);
 void vector_copy_values(struct vector* vector, const struct vector* other);
 double complex vector_get(struct vector* vector, size_t idx);
+// direct access to the values (for kernels that work on several vectors at once)
+double complex* vector_data(const struct vector* vector);
 size_t vector_size(const struct vector* vector);
 struct vector* vector_copy(const struct vector* vector);
+struct vector* vector_copy_in(struct workspace* workspace, const struct vector* vector);
 void vector_add_scalar(struct vector* vector, double complex value);
 void vector_scale(struct vector* vector, double complex factor);
 void vector_add(struct vector* a, const struct vector* b);
+void vector_add_scaled(struct vector* a, const struct vector* b, double complex factor);
 void vector_multiply(struct vector* multiplicand, const struct vector* multiplier);
 void vector_divide(struct vector* dividend, const struct vector* divisor);
 void vector_abs(struct vector* vector);
 void vector_abs_squared(struct vector* vector);
 struct vector* vector_magnitude(const struct vector* vector);
+struct vector* vector_magnitude_in(struct workspace* workspace, const struct vector* vector);
 struct vector* vector_phase(const struct vector* vector);
+struct vector* vector_phase_in(struct workspace* workspace, const struct vector* vector);
 void vector_print(const struct vector* vector);
 struct vector* vector_logspace(double a, double b, unsigned int N);
 
@@ -0,0 +1,236 @@
+#include "worstcase.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "constants.h"
+#include "loopscan.h"
+#include "memory.h"
+#include "noise.h"
+#include "pll_internal.h"
+
+// Kvco-independent data of one frequency point
+struct point {
+    double f;
+    // loop gain for Kvco = 1: Hloop = Kvco * G
+    double Gr;
+    double Gi;
+    double G2; // |G|^2
+    double logG; // log10(|G|)
+    double phase; // unwrapped phase of G (and therefore of Hloop) in degree
+    // |gm * Hfilter * Hvco|^2 for Kvco = 1
+    double FV2;
+    // |Hfilter|^2
+    double Hfilter2;
+    // source PSDs
+    double Sref;
+    double Svco;
+    double Scp;
+    double Sphasedetector;
+};
+
+struct worstcase {
+    struct point* points;
+    size_t samples;
+    double min_Kvco;
+    double max_Kvco;
+    double kM;
+    double invN;
+    double g2;
+    double Sfilter0;
+    double fsig;
+    struct noise_band jitterband;
+    size_t numgrid;
+    double tolerance;
+};
+
+struct worstcase* worstcase_create(const struct pll_state* state)
+{
+    const struct context* context = state->context;
+    const double complex* f = vector_data(context->f);
+    const double complex* s = vector_data(context->s);
+    const double complex* Hparasitic = vector_data(context->Hparasitic);
+    const double complex* Sref = vector_data(context->Sref);
+    const double complex* Svco = vector_data(context->Svco);
+    const double complex* Scp = vector_data(context->Scp);
+    const double complex* Sphasedetector = vector_data(context->Sphasedetector);
+
+    struct worstcase* worstcase = memory_allocate(sizeof(*worstcase));
+    worstcase->samples = context->samples;
+    worstcase->points = memory_allocate(worstcase->samples * sizeof(*worstcase->points));
+    worstcase->min_Kvco = state->min_Kvco;
+    worstcase->max_Kvco = state->max_Kvco;
+    unsigned int k = state->fsig / state->fref;
+    worstcase->kM = k / state->M; // integer division, like in pll_calculate
+    worstcase->invN = 1.0 / state->N;
+    double g = state->detectorgain * state->gm;
+    worstcase->g2 = g * g;
+    worstcase->Sfilter0 = 1.657e-20 * state->Rf;
+    worstcase->fsig = state->fsig;
+    worstcase->jitterband = state->jitterband;
+    worstcase->numgrid = 9;
+    worstcase->tolerance = 1e-3;
+
+    double offset = 0;
+    for(size_t j = 0; j < worstcase->samples; ++j)
+    {
+        struct point* p = &worstcase->points[j];
+        p->f = creal(f[j]);
+        // Hfilter: (1 + s * Rf * Cf) / (s * (Cf + Cfx) + s^2 * Rf * Cf * Cfx)
+        double complex Hfilter = (1 + s[j] * state->Rf * state->Cf) / (s[j] * (state->Cf + state->Cfx) + s[j] * s[j] * state->Rf * state->Cf * state->Cfx);
+        // Hvco for Kvco = 1: 2 * pi / s
+        double complex FV = state->gm * Hfilter * 2 * CONSTANTS_PI / s[j];
+        double complex G = state->detectorgain * FV * Hparasitic[j];
+        p->Gr = creal(G);
+        p->Gi = cimag(G);
+        p->G2 = p->Gr * p->Gr + p->Gi * p->Gi;
+        p->logG = log10(sqrt(p->G2));
+        double phase = 180 / CONSTANTS_PI * carg(G);
+        p->phase = j == 0 ? phase : loopscan_unwrap(phase, worstcase->points[j - 1].phase, &offset);
+        p->FV2 = creal(FV) * creal(FV) + cimag(FV) * cimag(FV);
+        p->Hfilter2 = creal(Hfilter) * creal(Hfilter) + cimag(Hfilter) * cimag(Hfilter);
+        p->Sref = creal(Sref[j]);
+        p->Svco = creal(Svco[j]);
+        p->Scp = creal(Scp[j]);
+        p->Sphasedetector = creal(Sphasedetector[j]);
+    }
+    return worstcase;
+}
+
+void worstcase_destroy(struct worstcase* worstcase)
+{
+    memory_free(worstcase->points);
+    memory_free(worstcase);
+}
+
+void worstcase_set_grid(struct worstcase* worstcase, size_t numpoints)
+{
+    worstcase->numgrid = numpoints > 2 ? numpoints : 2;
+}
+
+void worstcase_set_tolerance(struct worstcase* worstcase, double tolerance)
+{
+    worstcase->tolerance = tolerance;
+}
+
+void worstcase_evaluate(const struct worstcase* worstcase, double Kvco, double* values)
+{
+    double K2 = Kvco * Kvco;
+    double logK = log10(Kvco);
+    struct loopscan scan;
+    loopscan_start(&scan, &worstcase->jitterband);
+    for(size_t j = 0; j < worstcase->samples; ++j)
+    {
+        const struct point* p = &worstcase->points[j];
+        // 1 + 1 / N * Hloop
+        double dr = 1 + worstcase->invN * Kvco * p->Gr;
+        double di = worstcase->invN * Kvco * p->Gi;
+        double dmag2 = dr * dr + di * di;
+        double loopmag2 = K2 * p->G2;
+        double clmag2 = loopmag2 / dmag2;
+
+        // effective noise contributions (|NTF|^2 * S), see pll_calculate
+        double Stot = worstcase->kM * worstcase->kM * clmag2 * p->Sref
+            + p->Svco / dmag2
+            + clmag2 / worstcase->g2 * p->Scp
+            + K2 * p->FV2 / dmag2 * p->Sphasedetector
+            + clmag2 / (worstcase->g2 * p->Hfilter2) * worstcase->Sfilter0;
+
+        loopscan_add(&scan, p->f, Kvco * sqrt(p->G2), logK + p->logG, p->phase, Stot);
+    }
+    values[WORSTCASE_PHASEMARGIN] = scan.phasemargin;
+    values[WORSTCASE_UNITY_GAIN_FREQUENCY] = scan.f0dB;
+    values[WORSTCASE_BANDWIDTH] = scan.fbw;
+    values[WORSTCASE_JRMS] = noise_area_to_RMSjitter(worstcase->fsig, scan.Atot);
+}
+
+// larger is worse, NaN is worst of all
+static double _badness(enum worstcase_metric metric, double value)
+{
+    if(isnan(value))
+    {
+        return INFINITY;
+    }
+    if(metric == WORSTCASE_PHASEMARGIN || metric == WORSTCASE_UNITY_GAIN_FREQUENCY)
+    {
+        return -value;
+    }
+    return value;
+}
+
+// evaluates at exp(x) and keeps track of the worst point seen so far
+static double _probe(const struct worstcase* worstcase, enum worstcase_metric metric, double x, struct worstcase_result* result)
+{
+    double values[WORSTCASE_NUM_METRICS];
+    double Kvco = exp(x);
+    worstcase_evaluate(worstcase, Kvco, values);
+    ++result->evaluations;
+    double badness = _badness(metric, values[metric]);
+    if(result->evaluations == 1 || badness > _badness(metric, result->value))
+    {
+        result->Kvco = Kvco;
+        result->value = values[metric];
+    }
+    return badness;
+}
+
+void worstcase_search(const struct worstcase* worstcase, enum worstcase_metric metric, struct worstcase_result* result)
+{
+    result->evaluations = 0;
+    double xmin = log(worstcase->min_Kvco);
+    double xmax = log(worstcase->max_Kvco);
+    if(!(xmax > xmin))
+    {
+        _probe(worstcase, metric, xmin, result);
+        return;
+    }
+
+    // bracket: worst point of a logarithmic grid and its neighbours
+    size_t numgrid = worstcase->numgrid;
+    double step = (xmax - xmin) / (numgrid - 1);
+    size_t worst = 0;
+    double worstbadness = -INFINITY;
+    for(size_t i = 0; i < numgrid; ++i)
+    {
+        double badness = _probe(worstcase, metric, i == numgrid - 1 ? xmax : xmin + i * step, result);
+        if(badness > worstbadness)
+        {
+            worstbadness = badness;
+            worst = i;
+        }
+    }
+    if(isinf(worstbadness))
+    {
+        // undetermined metric, nothing to refine
+        return;
+    }
+    double a = worst > 0 ? xmin + (worst - 1) * step : xmin;
+    double b = worst < numgrid - 1 ? xmin + (worst + 1) * step : xmax;
+
+    // golden-section search for the maximum badness in [a, b] (the grid points already cover both ends)
+    const double invphi = 0.6180339887498949;
+    double x1 = b - invphi * (b - a);
+    double x2 = a + invphi * (b - a);
+    double b1 = _probe(worstcase, metric, x1, result);
+    double b2 = _probe(worstcase, metric, x2, result);
+    while(b - a > worstcase->tolerance)
+    {
+        if(b1 > b2)
+        {
+            b = x2;
+            x2 = x1;
+            b2 = b1;
+            x1 = b - invphi * (b - a);
+            b1 = _probe(worstcase, metric, x1, result);
+        }
+        else
+        {
+            a = x1;
+            x1 = x2;
+            b1 = b2;
+            x2 = a + invphi * (b - a);
+            b2 = _probe(worstcase, metric, x2, result);
+        }
+    }
+}
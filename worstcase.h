@@ -0,0 +1,43 @@
+#ifndef PLL_WORSTCASE_H
+#define PLL_WORSTCASE_H
+
+#include <stddef.h>
+
+#include "pll.h"
+
+// Worst-case search over the continuous Kvco range [min_Kvco, max_Kvco] of an initialized pll_state.
+// pll_calculate only evaluates the two corners, but with parasitic poles the worst phase margin or jitter can lie inside the range.
+// Everything that does not depend on Kvco (filter, parasitic poles, source PSDs, phase of the loop gain) is captured once
+// by worstcase_create, a single probe then only rescales the loop gain.
+// The search samples the range on a logarithmic grid to bracket the worst point and refines it with a golden-section search,
+// so extrema narrower than the grid spacing can be missed (see worstcase_set_grid).
+
+// worst means minimum for the phase margin and the unity-gain frequency and maximum for the bandwidth and the jitter (like montecarlo)
+enum worstcase_metric {
+    WORSTCASE_PHASEMARGIN,
+    WORSTCASE_UNITY_GAIN_FREQUENCY,
+    WORSTCASE_BANDWIDTH,
+    WORSTCASE_JRMS,
+    WORSTCASE_NUM_METRICS
+};
+
+struct worstcase_result {
+    double Kvco;
+    double value; // NaN if the metric can not be determined at Kvco (no 0 dB crossing), which counts as worst
+    size_t evaluations;
+};
+
+struct worstcase;
+
+// captures the Kvco-independent parts of 'state', the worstcase object has to be recreated if the state changes
+struct worstcase* worstcase_create(const struct pll_state* state);
+void worstcase_destroy(struct worstcase* worstcase);
+// number of grid points including both corners (default: 9)
+void worstcase_set_grid(struct worstcase* worstcase, size_t numpoints);
+// relative Kvco tolerance of the golden-section search (default: 1e-3)
+void worstcase_set_tolerance(struct worstcase* worstcase, double tolerance);
+// evaluates all metrics at one Kvco (values: WORSTCASE_NUM_METRICS entries)
+void worstcase_evaluate(const struct worstcase* worstcase, double Kvco, double* values);
+void worstcase_search(const struct worstcase* worstcase, enum worstcase_metric metric, struct worstcase_result* result);
+
+#endif /* PLL_WORSTCASE_H */